@@ -7,7 +7,8 @@ class AnalysisService(
     private val perf: PerfIndex = PerfIndex
 ) {
     fun analyze(run: RunRecord, windowSec: Int = 60 * 60 * 24 * 7 * 8): Pair<RunRecord, Recommendation> {
-        val ppi = perf.purdyScore(run.distanceMeters, run.elapsedSeconds)
+        // Imports can carry a zero distance or duration, which purdyScore rejects; leave those unscored
+        val ppi = if (run.distanceMeters > 0 && run.elapsedSeconds > 0) perf.purdyScore(run.distanceMeters, run.elapsedSeconds) else null
         val targetPace = perf.targetPace(run.distanceMeters, windowSec)
         val rec = Recommendation(
             targetPaceSecPerKm = targetPace,
@@ -1,9 +1,12 @@
 package com.mebeatme.android
 
+import com.mebeatme.android.domain.AnalysisService
 import com.mebeatme.android.domain.PerfIndex
+import com.mebeatme.android.models.RunRecord
 import com.mebeatme.shared.core.PurdyPointsCalculator
 import org.junit.Test
 import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNull
 
 class KmpBridgeTest {
     @Test
@@ -19,4 +22,12 @@ class KmpBridgeTest {
         val actual = PerfIndex.targetPace(5000.0, 3600)
         assertEquals(expected, actual, 0.0001)
     }
+
+    @Test
+    fun analysisLeavesZeroDurationImportsUnscored() {
+        val run = RunRecord("r1", "gpx", 0L, 0L, distanceMeters = 5000.0, elapsedSeconds = 0, avgPaceSecPerKm = 0.0)
+        val (analyzed, _) = AnalysisService().analyze(run)
+        assertNull(analyzed.ppi)
+        assertEquals(PerfIndex.purdyScore(5000.0, 1500), AnalysisService().analyze(run.copy(elapsedSeconds = 1500)).first.ppi!!, 0.0001)
+    }
 }
@@ -13,9 +13,11 @@ async function getWorkoutData() {
   return global.workoutData;
 }
 
+// Full rescan, only for bulk replacement; single adds and deletes update bestPpi incrementally.
+// Dashboard totals come from the server's /rollups, not from here.
 async function persist(sessions) {
   global.workoutData.sessions = sessions;
-  global.workoutData.bestPpi = sessions.length ? Math.max(...sessions.map(s => s.ppi)) : 0;
+  global.workoutData.bestPpi = sessions.reduce((best, s) => Math.max(best, s.ppi || 0), 0);
   return global.workoutData;
 }
 
@@ -33,8 +35,8 @@ async function addSession(session) {
       ...session,
       createdAt: session.createdAt || Date.now()
     };
-    const sessions = [newSession, ...current.sessions];
-    await persist(sessions);
+    current.sessions = [newSession, ...current.sessions];
+    current.bestPpi = Math.max(current.bestPpi || 0, newSession.ppi || 0);
     console.log(`Successfully added session: ${newSession.id} to memory store`);
     return newSession;
   } catch (error) {
@@ -45,9 +47,13 @@ async function addSession(session) {
 
 async function deleteSession(sessionId) {
   const current = await getWorkoutData();
-  const sessions = current.sessions.filter(s => s.id !== sessionId);
-  await persist(sessions);
   const removed = current.sessions.find(s => s.id === sessionId) || null;
+  if (!removed) return null;
+  current.sessions = current.sessions.filter(s => s.id !== sessionId);
+  // Only a deleted best forces a rescan
+  if ((removed.ppi || 0) >= current.bestPpi) {
+    current.bestPpi = current.sessions.reduce((best, s) => Math.max(best, s.ppi || 0), 0);
+  }
   return removed;
 }
 
@@ -3,6 +3,8 @@ plugins {
     kotlin("plugin.serialization") version "2.0.0" apply false
     kotlin("js") version "2.0.0" apply false
     kotlin("jvm") version "2.0.0" apply false
+    kotlin("plugin.allopen") version "2.0.0" apply false
+    id("org.jetbrains.kotlinx.benchmark") version "0.4.11" apply false
     id("com.android.library") version "8.2.0" apply false
     id("com.android.application") version "8.2.0" apply false
 }
@@ -2,6 +2,8 @@ plugins {
     kotlin("multiplatform")
     kotlin("plugin.serialization")
     id("com.android.library")
+    kotlin("plugin.allopen")
+    id("org.jetbrains.kotlinx.benchmark")
 }
 
 android {
@@ -18,8 +20,59 @@ android {
     }
 }
 
+// Bakes purdy_baseline.csv into a Kotlin table with precomputed log-space
+// segment coefficients so scoring never parses CSV or takes anchor logs at runtime.
+val generatePurdyBaseline by tasks.registering {
+    val csvFile = file("src/commonMain/resources/purdy_baseline.csv")
+    val outputDir = layout.buildDirectory.dir("generated/purdy/commonMain/kotlin")
+    inputs.file(csvFile)
+    outputs.dir(outputDir)
+    
+    doLast {
+        val rows = csvFile.readLines()
+            .map { it.trim() }
+            .filter { it.isNotEmpty() && !it.startsWith("#") && it.first().isDigit() }
+            .map { line -> line.split(",").map { it.trim().toDouble() } }
+            .sortedBy { it[0] }
+        require(rows.size >= 2) { "purdy_baseline.csv needs at least two anchors" }
+        
+        val logDistances = rows.map { kotlin.math.ln(it[0]) }
+        val logTimes = rows.map { kotlin.math.ln(it[1]) }
+        val slopes = (0 until rows.size - 1).map { i ->
+            (logTimes[i + 1] - logTimes[i]) / (logDistances[i + 1] - logDistances[i])
+        }
+        val intercepts = slopes.indices.map { i -> logTimes[i] - slopes[i] * logDistances[i] }
+        
+        fun array(values: List<Double>) = values.joinToString(", ", "doubleArrayOf(", ")")
+        
+        val target = outputDir.get().file("com/mebeatme/core/ppi/PurdyBaseline.kt").asFile
+        target.parentFile.mkdirs()
+        target.writeText(
+            """
+            |package com.mebeatme.core.ppi
+            |
+            |// Generated from purdy_baseline.csv by :core:generatePurdyBaseline. Do not edit.
+            |internal object PurdyBaseline {
+            |    val distancesM = ${array(rows.map { it[0] })}
+            |    val timesSec = ${array(rows.map { it[1] })}
+            |    val points = ${array(rows.map { it[2] })}
+            |    val logDistances = ${array(logDistances)}
+            |    val segmentSlopes = ${array(slopes)}
+            |    val segmentIntercepts = ${array(intercepts)}
+            |}
+            |""".trimMargin()
+        )
+    }
+}
+
 kotlin {
     androidTarget()
+    // JVM target for the JMH benchmarks in src/jvmBenchmark (run with :core:benchmark; not part of check)
+    jvm {
+        compilations.create("benchmark") {
+            associateWith(this@jvm.compilations.getByName("main"))
+        }
+    }
     iosArm64()
     iosX64()
     iosSimulatorArm64()
@@ -27,6 +80,7 @@ kotlin {
 
     sourceSets {
         val commonMain by getting {
+            kotlin.srcDir(generatePurdyBaseline)
             dependencies {
                 implementation(kotlin("stdlib"))
                 implementation("org.jetbrains.kotlinx:kotlinx-serialization-json:1.6.3")
@@ -38,5 +92,21 @@ kotlin {
                 implementation(kotlin("test")) 
             } 
         }
+        val jvmBenchmark by getting {
+            dependencies {
+                implementation("org.jetbrains.kotlinx:kotlinx-benchmark-runtime:0.4.11")
+            }
+        }
+    }
+}
+
+// JMH needs open benchmark classes
+allOpen {
+    annotation("org.openjdk.jmh.annotations.State")
+}
+
+benchmark {
+    targets {
+        register("jvmBenchmark")
     }
 }
@@ -14,7 +14,7 @@ import kotlinx.serialization.Serializable
     // Current PPI based on current distance and elapsed time
     val currentPPI: Double
         get() = if (currentDistanceM > 0 && currentElapsedSec > 0) {
-            com.mebeatme.core.ppi.PpiEngine.score(currentDistanceM, currentElapsedSec)
+            com.mebeatme.core.ppi.PpiEngine.liveScore(currentDistanceM, currentElapsedSec)
         } else {
             0.0
         }
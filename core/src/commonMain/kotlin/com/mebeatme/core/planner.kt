@@ -12,7 +12,14 @@ import kotlin.random.Random
     val willExceedScore: Double
 )
 
-class BeatPlanner(private val history: List<Score>) {
+/**
+ * @param sustainedPaceSecPerKm Fastest pace the athlete has held for a window in seconds, e.g. from the
+ * shared PaceEnvelope; when it knows a window, that choice is set just ahead of it instead of from the best PPI
+ */
+class BeatPlanner(
+    private val history: List<Score>,
+    private val sustainedPaceSecPerKm: (windowSeconds: Int) -> Double? = { null }
+) {
     fun bestFor(bucket: Bucket): Double =
         history.filter { it.bucket == bucket }.maxByOrNull { it.ppi }?.ppi ?: 0.0
 
@@ -23,7 +30,8 @@ class BeatPlanner(private val history: List<Score>) {
         val out = windows.map { w ->
             val km = kmWindows.getValue(w)
             val distM = km * 1000
-            val secPerKm = PpiEngine.requiredPaceSecPerKm(best + 1.0, w, distM)
+            val secPerKm = sustainedPaceSecPerKm(w)?.let { it * 0.99 }
+                ?: PpiEngine.requiredPaceSecPerKm(best + 1.0, w, distM)
             val projected = PpiEngine.score(distM, secPerKm * km)
             BeatChoice(
                 label = when (w) { 300 -> "Short & Fierce"; 600 -> "Tempo Boost"; else -> "Ease Into It" },
@@ -38,6 +38,50 @@ object PpiCurvePurdy {
         return rawPoints.coerceIn(MIN_POINTS, MAX_POINTS)
     }
     
+    /**
+     * Points before clamping to the 100-2000 range, for positive distance and time only.
+     * Used to build lookup tables whose interpolation must not straddle the clamp.
+     */
+    internal fun unclampedScore(distanceM: Double, elapsedSec: Double): Double =
+        ELITE_POINTS * (PurdyTable.getBaselineTime(distanceM) / elapsedSec).pow(-ALPHA)
+    
+    internal const val SCORE_FLOOR = MIN_POINTS
+    internal const val SCORE_CEILING = MAX_POINTS
+    
+    /**
+     * Score many runs in one call over struct-of-arrays input.
+     * Matches [score] within [BATCH_TOLERANCE] (relative) but costs one `ln` and one
+     * `exp` per run: the baseline comes from the log-space segment table and
+     * ratio^-2 is expanded as (elapsed / baseline)^2 instead of going through `pow`.
+     * @param distancesM Distances in meters
+     * @param elapsedSec Elapsed times in seconds, same length as [distancesM]
+     * @param out Destination array (may be reused across calls)
+     * @return [out], filled with points scores (100-2000 range)
+     */
+    fun scoreBatch(
+        distancesM: DoubleArray,
+        elapsedSec: DoubleArray,
+        out: DoubleArray = DoubleArray(distancesM.size)
+    ): DoubleArray {
+        require(elapsedSec.size == distancesM.size) { "distancesM and elapsedSec must have the same length" }
+        require(out.size >= distancesM.size) { "out is smaller than the input" }
+
+        for (i in distancesM.indices) {
+            val d = distancesM[i]
+            val t = elapsedSec[i]
+            val valid = d > 0 && t > 0
+            // Invalid rows go through the math on a dummy distance and are masked below
+            val logBaseline = PurdyTable.logBaselineTime(kotlin.math.ln(if (valid) d else 1.0))
+            val q = t * kotlin.math.exp(-logBaseline) // elapsed / baseline == ratio^-1
+            val rawPoints = ELITE_POINTS * q * q // ALPHA == 2
+            out[i] = if (valid) rawPoints.coerceIn(MIN_POINTS, MAX_POINTS) else MIN_POINTS
+        }
+        return out
+    }
+
+    /** Relative tolerance between [scoreBatch] and [score]. */
+    const val BATCH_TOLERANCE = 1e-9
+
     /**
      * Calculate corrected score with elevation and temperature adjustments.
      * @param distanceM Distance in meters
@@ -52,7 +96,7 @@ object PpiCurvePurdy {
     
     /**
      * Find the minimum elapsed time needed to reach a target score for a given distance.
-     * Uses binary search for precision.
+     * Inverts the points curve in closed form: ratio = (target / 1000)^(-1 / ALPHA).
      * @param distanceM Distance in meters
      * @param targetScore Target points score
      * @return Minimum elapsed time in seconds
@@ -62,24 +106,41 @@ object PpiCurvePurdy {
         if (targetScore >= MAX_POINTS) return 0.0
         
         val baselineTime = PurdyTable.getBaselineTime(distanceM)
+        return requiredTimeFromBaseline(baselineTime, targetScore)
+    }
+    
+    /**
+     * Batch variant of [requiredTimeFor] over struct-of-arrays input.
+     * @param distancesM Distances in meters
+     * @param targetScores Target points scores, same length as [distancesM]
+     * @param out Destination array (may be reused across calls)
+     * @return [out], filled with minimum elapsed times in seconds
+     */
+    fun requiredTimeForBatch(
+        distancesM: DoubleArray,
+        targetScores: DoubleArray,
+        out: DoubleArray = DoubleArray(distancesM.size)
+    ): DoubleArray {
+        require(targetScores.size == distancesM.size) { "distancesM and targetScores must have the same length" }
+        require(out.size >= distancesM.size) { "out is smaller than the input" }
         
-        // Binary search bounds
-        var low = 0.1 // Very fast time
-        var high = baselineTime * 3.0 // Very slow time
-        
-        // Binary search for required time
-        repeat(50) { // Sufficient precision
-            val mid = (low + high) / 2.0
-            val score = score(distanceM, mid)
-            
-            if (score >= targetScore) {
-                high = mid
-            } else {
-                low = mid
+        for (i in distancesM.indices) {
+            val d = distancesM[i]
+            val target = targetScores[i]
+            val baselineTime = kotlin.math.exp(PurdyTable.logBaselineTime(kotlin.math.ln(if (d > 0) d else 1.0)))
+            out[i] = when {
+                d <= 0 || target <= MIN_POINTS -> Double.MAX_VALUE
+                target >= MAX_POINTS -> 0.0
+                else -> requiredTimeFromBaseline(baselineTime, target)
             }
         }
-        
-        return high
+        return out
+    }
+    
+    // Same bounds the old 50-step bisection searched: [0.1 s, 3 × baseline]
+    private fun requiredTimeFromBaseline(baselineTime: Double, targetScore: Double): Double {
+        val ratio = (targetScore / ELITE_POINTS).pow(-1.0 / ALPHA)
+        return (baselineTime / ratio).coerceIn(0.1, baselineTime * 3.0)
     }
     
     /**
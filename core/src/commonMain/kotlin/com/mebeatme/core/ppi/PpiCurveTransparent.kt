@@ -18,9 +18,40 @@ object PpiCurveTransparent {
      * @return Points score (0-1200 range)
      */
     fun score(distanceM: Double, elapsedSec: Double): Double {
+        val base = unclampedScore(distanceM, elapsedSec)
+        return base.coerceIn(SCORE_FLOOR, SCORE_CEILING)
+    }
+    
+    /**
+     * Points before clamping to the 0-1200 range, for positive distance and time only.
+     */
+    internal fun unclampedScore(distanceM: Double, elapsedSec: Double): Double {
         val v = distanceM / elapsedSec // m/s
-        val base = 350.0 * v.pow(0.95) * distanceM.pow(0.05)
-        return base.coerceIn(0.0, 1200.0)
+        return 350.0 * v.pow(0.95) * distanceM.pow(0.05)
+    }
+    
+    internal const val SCORE_FLOOR = 0.0
+    internal const val SCORE_CEILING = 1200.0
+    
+    /**
+     * Score many runs in one call over struct-of-arrays input.
+     * @param distancesM Distances in meters
+     * @param elapsedSec Elapsed times in seconds, same length as [distancesM]
+     * @param out Destination array (may be reused across calls)
+     * @return [out], filled with points scores (0-1200 range)
+     */
+    fun scoreBatch(
+        distancesM: DoubleArray,
+        elapsedSec: DoubleArray,
+        out: DoubleArray = DoubleArray(distancesM.size)
+    ): DoubleArray {
+        require(elapsedSec.size == distancesM.size) { "distancesM and elapsedSec must have the same length" }
+        require(out.size >= distancesM.size) { "out is smaller than the input" }
+        
+        for (i in distancesM.indices) {
+            out[i] = score(distancesM[i], elapsedSec[i])
+        }
+        return out
     }
     
     /**
@@ -35,36 +66,51 @@ object PpiCurveTransparent {
 
     /**
      * Find required pace (sec/km) to reach >= targetScore over given distance/time window.
-     * Uses binary search for precision.
      * @param targetScore Target points score
      * @param windowSeconds Time window in seconds (unused in v0)
      * @param distanceForWindowM Distance in meters
      * @return Required pace in seconds per kilometer
      */
-    fun requiredPaceSecPerKm(targetScore: Double, windowSeconds: Int, distanceForWindowM: Double): Double {
-        var lo = 1.0; var hi = 1e5
-        repeat(40) {
-            val mid = (lo + hi) / 2
-            val s = score(distanceForWindowM, mid)
-            if (s >= targetScore) hi = mid else lo = mid
-        }
-        return hi / (distanceForWindowM / 1000.0)
-    }
+    fun requiredPaceSecPerKm(targetScore: Double, windowSeconds: Int, distanceForWindowM: Double): Double =
+        requiredTimeFor(distanceForWindowM, targetScore) / (distanceForWindowM / 1000.0)
     
     /**
-     * Find the minimum elapsed time needed to reach a target score for a given distance.
-     * Uses binary search for precision.
+     * Find the slowest elapsed time that still reaches a target score for a given distance.
+     * Inverts score = 350 * v^0.95 * d^0.05 in closed form for v, then t = d / v.
+     * Results are kept inside the [1 s, 1e5 s] window the old bisection searched.
      * @param distanceM Distance in meters
      * @param targetScore Target points score
-     * @return Minimum elapsed time in seconds
+     * @return Required elapsed time in seconds
      */
     fun requiredTimeFor(distanceM: Double, targetScore: Double): Double {
-        var lo = 1.0; var hi = 1e5
-        repeat(40) {
-            val mid = (lo + hi) / 2
-            val s = score(distanceM, mid)
-            if (s >= targetScore) hi = mid else lo = mid
+        if (distanceM <= 0 || targetScore <= 0.0) return MAX_TIME_SEC
+        if (targetScore > 1200.0) return MIN_TIME_SEC
+        
+        val v = (targetScore / (350.0 * distanceM.pow(0.05))).pow(1.0 / 0.95)
+        return (distanceM / v).coerceIn(MIN_TIME_SEC, MAX_TIME_SEC)
+    }
+    
+    /**
+     * Batch variant of [requiredTimeFor] over struct-of-arrays input.
+     * @param distancesM Distances in meters
+     * @param targetScores Target points scores, same length as [distancesM]
+     * @param out Destination array (may be reused across calls)
+     * @return [out], filled with required elapsed times in seconds
+     */
+    fun requiredTimeForBatch(
+        distancesM: DoubleArray,
+        targetScores: DoubleArray,
+        out: DoubleArray = DoubleArray(distancesM.size)
+    ): DoubleArray {
+        require(targetScores.size == distancesM.size) { "distancesM and targetScores must have the same length" }
+        require(out.size >= distancesM.size) { "out is smaller than the input" }
+        
+        for (i in distancesM.indices) {
+            out[i] = requiredTimeFor(distancesM[i], targetScores[i])
         }
-        return hi
+        return out
     }
+    
+    private const val MIN_TIME_SEC = 1.0
+    private const val MAX_TIME_SEC = 1e5
 }
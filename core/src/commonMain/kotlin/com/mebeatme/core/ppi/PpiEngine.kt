@@ -22,6 +22,12 @@ object PpiEngine {
      */
     var model: PpiModel = PpiModel.PurdyV1
     
+    /**
+     * When true, [liveScore] reads the precomputed [PpiLookupGrid] instead of the exact curve.
+     * Off by default; enable on devices where live UI reads dominate scoring cost.
+     */
+    var useLookupGridForLive: Boolean = false
+    
     /**
      * Calculate PPI score using the active model.
      * @param distanceM Distance in meters
@@ -35,6 +41,40 @@ object PpiEngine {
             PpiModel.PurdyV1 -> PpiCurvePurdy.score(distanceM, elapsedSec + corr.elevationAdjSec + corr.temperatureAdjSec)
         }
     
+    /**
+     * Score for live, per-frame reads (current PPI during a run).
+     * Uses the lookup grid for the active model when [useLookupGridForLive] is set,
+     * otherwise the exact curve.
+     * @param distanceM Distance in meters
+     * @param elapsedSec Elapsed time in seconds
+     * @return Points score
+     */
+    fun liveScore(distanceM: Double, elapsedSec: Double): Double =
+        if (useLookupGridForLive) {
+            PpiLookupGrid.forActiveModel().score(distanceM, elapsedSec)
+        } else {
+            score(distanceM, elapsedSec)
+        }
+    
+    /**
+     * Score many runs with the active model.
+     * The model is read once for the whole batch, so switching [model] mid-batch
+     * cannot mix curves and the per-row loop has no model dispatch.
+     * @param distancesM Distances in meters
+     * @param elapsedSec Elapsed times in seconds, same length as [distancesM]
+     * @param out Destination array (may be reused across calls)
+     * @return [out], filled with points scores
+     */
+    fun scoreBatch(
+        distancesM: DoubleArray,
+        elapsedSec: DoubleArray,
+        out: DoubleArray = DoubleArray(distancesM.size)
+    ): DoubleArray =
+        when (model) {
+            PpiModel.TransparentV0 -> PpiCurveTransparent.scoreBatch(distancesM, elapsedSec, out)
+            PpiModel.PurdyV1 -> PpiCurvePurdy.scoreBatch(distancesM, elapsedSec, out)
+        }
+    
     /**
      * Calculate required pace in seconds per kilometer to achieve target score.
      * @param targetScore Target points score
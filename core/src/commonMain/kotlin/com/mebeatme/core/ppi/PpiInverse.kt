@@ -0,0 +1,91 @@
+package com.mebeatme.core.ppi
+
+import kotlin.math.abs
+import kotlin.math.exp
+import kotlin.math.ln
+
+/**
+ * Inverse scoring: elapsed time needed to reach a target score.
+ * Every built-in model has an exact closed-form inverse; [solveRequiredTime]
+ * is the fallback for curves that cannot be inverted analytically.
+ */
+object PpiInverse {
+    
+    /**
+     * Exact inverse for the given model.
+     * @param model PPI model to invert
+     * @param distanceM Distance in meters
+     * @param targetScore Target points score
+     * @return Required elapsed time in seconds
+     */
+    fun requiredTimeFor(model: PpiModel, distanceM: Double, targetScore: Double): Double =
+        when (model) {
+            PpiModel.TransparentV0 -> PpiCurveTransparent.requiredTimeFor(distanceM, targetScore)
+            PpiModel.PurdyV1 -> PpiCurvePurdy.requiredTimeFor(distanceM, targetScore)
+        }
+    
+    /**
+     * Batch inverse for many distance/target pairs.
+     * The model is resolved once for the whole batch, not per row.
+     * @param model PPI model to invert
+     * @param distancesM Distances in meters
+     * @param targetScores Target points scores, same length as [distancesM]
+     * @param out Destination array (may be reused across calls)
+     * @return [out], filled with required elapsed times in seconds
+     */
+    fun requiredTimeForBatch(
+        model: PpiModel,
+        distancesM: DoubleArray,
+        targetScores: DoubleArray,
+        out: DoubleArray = DoubleArray(distancesM.size)
+    ): DoubleArray =
+        when (model) {
+            PpiModel.TransparentV0 -> PpiCurveTransparent.requiredTimeForBatch(distancesM, targetScores, out)
+            PpiModel.PurdyV1 -> PpiCurvePurdy.requiredTimeForBatch(distancesM, targetScores, out)
+        }
+    
+    /**
+     * Numeric inverse for monotonic curves without a closed form.
+     * Runs Newton's method on ln(time) with a finite-difference slope and falls
+     * back to a bisection step whenever Newton would leave the bracket, so it
+     * converges like bisection in the worst case and in a handful of steps normally.
+     * @param targetScore Target points score
+     * @param lowSec Lower bound of the search bracket in seconds
+     * @param highSec Upper bound of the search bracket in seconds
+     * @param toleranceSec Stop once the bracket or step is narrower than this
+     * @param score Score as a function of elapsed seconds (monotonic on the bracket)
+     * @return Elapsed time in seconds at which [score] crosses [targetScore]
+     */
+    fun solveRequiredTime(
+        targetScore: Double,
+        lowSec: Double,
+        highSec: Double,
+        toleranceSec: Double = 1e-6,
+        score: (Double) -> Double
+    ): Double {
+        var lo = ln(lowSec)
+        var hi = ln(highSec)
+        val increasing = score(highSec) >= score(lowSec)
+        var x = (lo + hi) / 2.0
+        
+        repeat(MAX_ITERATIONS) {
+            val t = exp(x)
+            val f = score(t) - targetScore
+            if (f == 0.0) return t
+            
+            // Keep the bracket so a bad Newton step can never escape it
+            if ((f > 0) == increasing) hi = x else lo = x
+            
+            val h = 1e-6 * (abs(x) + 1.0)
+            val slope = (score(exp(x + h)) - score(exp(x - h))) / (2.0 * h)
+            val newton = if (slope != 0.0) x - f / slope else Double.NaN
+            val next = if (newton.isNaN() || newton <= lo || newton >= hi) (lo + hi) / 2.0 else newton
+            
+            if (abs(exp(next) - t) < toleranceSec || exp(hi) - exp(lo) < toleranceSec) return exp(next)
+            x = next
+        }
+        return exp(x)
+    }
+    
+    private const val MAX_ITERATIONS = 60
+}
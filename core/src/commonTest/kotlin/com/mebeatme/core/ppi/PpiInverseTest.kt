@@ -0,0 +1,79 @@
+package com.mebeatme.core.ppi
+
+import kotlin.math.abs
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class PpiInverseTest {
+    
+    // The 50-step search requiredTimeFor used before the closed form, kept as the reference result
+    private fun bisectionRequiredTime(distanceM: Double, targetScore: Double): Double {
+        var low = 0.1
+        var high = PurdyTable.getBaselineTime(distanceM) * 3.0
+        repeat(50) {
+            val mid = (low + high) / 2.0
+            if (PpiCurvePurdy.score(distanceM, mid) >= targetScore) high = mid else low = mid
+        }
+        return high
+    }
+    
+    @Test
+    fun `purdy closed form should match the bisection result`() {
+        val random = Random(3)
+        repeat(1_000) {
+            val distance = random.nextDouble(800.0, 50_000.0)
+            val target = random.nextDouble(150.0, 1900.0)
+            val exact = PpiCurvePurdy.requiredTimeFor(distance, target)
+            assertEquals(bisectionRequiredTime(distance, target), exact, exact * 1e-9)
+        }
+    }
+    
+    @Test
+    fun `purdy inverse should round trip through score`() {
+        for (distance in listOf(1500.0, 3000.0, 5000.0, 10000.0, 21097.0, 42195.0)) {
+            for (target in listOf(300.0, 600.0, 1000.0, 1500.0)) {
+                val time = PpiCurvePurdy.requiredTimeFor(distance, target)
+                assertEquals(target, PpiCurvePurdy.score(distance, time), 1e-6)
+            }
+        }
+    }
+    
+    @Test
+    fun `transparent inverse should round trip through score`() {
+        for (distance in listOf(1000.0, 2000.0, 5000.0, 10000.0)) {
+            for (target in listOf(200.0, 400.0, 600.0)) {
+                val time = PpiCurveTransparent.requiredTimeFor(distance, target)
+                assertEquals(target, PpiCurveTransparent.score(distance, time), 1e-6)
+            }
+        }
+    }
+    
+    @Test
+    fun `batch inverse should match scalar inverse for both models`() {
+        val distances = doubleArrayOf(1500.0, 4000.0, 5000.0, 12000.0, 42195.0, 0.0)
+        val targets = doubleArrayOf(400.0, 800.0, 1000.0, 1200.0, 700.0, 500.0)
+        
+        for (model in PpiModel.values()) {
+            val batch = PpiInverse.requiredTimeForBatch(model, distances, targets)
+            for (i in distances.indices) {
+                val scalar = PpiInverse.requiredTimeFor(model, distances[i], targets[i])
+                assertEquals(scalar, batch[i], abs(scalar) * 1e-9)
+            }
+        }
+    }
+    
+    @Test
+    fun `newton fallback should agree with the closed forms`() {
+        val purdy = PpiInverse.solveRequiredTime(800.0, 0.1, PurdyTable.getBaselineTime(10000.0) * 3.0) { t ->
+            PpiCurvePurdy.score(10000.0, t)
+        }
+        assertEquals(PpiCurvePurdy.requiredTimeFor(10000.0, 800.0), purdy, 1e-3)
+        
+        val transparent = PpiInverse.solveRequiredTime(500.0, 1.0, 1e5) { t ->
+            PpiCurveTransparent.score(5000.0, t)
+        }
+        assertEquals(PpiCurveTransparent.requiredTimeFor(5000.0, 500.0), transparent, 1e-3)
+    }
+}
@@ -0,0 +1,47 @@
+package com.mebeatme.core.ppi
+
+import kotlin.math.abs
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class PpiLookupGridTest {
+    
+    @Test
+    fun `purdy grid should stay within the documented error`() {
+        val report = PpiLookupGrid.build(PpiModel.PurdyV1).accuracyReport()
+        assertTrue(report.maxRelativeError < 0.007, "max error ${report.maxRelativeError}")
+        assertTrue(report.meanRelativeError < 0.0005, "mean error ${report.meanRelativeError}")
+    }
+    
+    @Test
+    fun `transparent grid should be near exact`() {
+        val report = PpiLookupGrid.build(PpiModel.TransparentV0).accuracyReport()
+        assertTrue(report.maxRelativeError < 1e-5, "max error ${report.maxRelativeError}")
+    }
+    
+    @Test
+    fun `grid should fall back to the exact curve outside its range`() {
+        val grid = PpiLookupGrid.build(PpiModel.PurdyV1)
+        
+        assertEquals(PpiCurvePurdy.score(50.0, 9.0), grid.score(50.0, 9.0))
+        assertEquals(PpiCurvePurdy.score(250_000.0, 90_000.0), grid.score(250_000.0, 90_000.0))
+        assertEquals(PpiCurvePurdy.score(0.0, 100.0), grid.score(0.0, 100.0))
+    }
+    
+    @Test
+    fun `live score should use the grid only when enabled`() {
+        PpiEngine.model = PpiModel.PurdyV1
+        val exact = PpiEngine.score(4321.0, 1234.0)
+        
+        PpiEngine.useLookupGridForLive = true
+        try {
+            val live = PpiEngine.liveScore(4321.0, 1234.0)
+            assertTrue(abs(live / exact - 1) < 0.007)
+            assertEquals(PpiEngine.getCurrentModelVersion(), PpiLookupGrid.forActiveModel().curveVersion)
+        } finally {
+            PpiEngine.useLookupGridForLive = false
+        }
+        assertEquals(exact, PpiEngine.liveScore(4321.0, 1234.0))
+    }
+}
@@ -52,6 +52,18 @@ class PurdyTableTest {
         assertTrue(time7500 > 780.0 && time7500 < 1620.0) // Between 5000m and 10000m times
     }
     
+    @Test
+    fun `baked segments should be continuous at every anchor`() {
+        val anchors = PurdyTable.getAnchors()
+        
+        for (anchor in anchors) {
+            assertEquals(anchor.timeSec, PurdyTable.getBaselineTime(anchor.distanceM), 1e-9)
+            // Just either side of the anchor must agree with the anchor itself
+            assertEquals(anchor.timeSec, PurdyTable.getBaselineTime(anchor.distanceM * (1 - 1e-12)), 1e-6)
+            assertEquals(anchor.timeSec, PurdyTable.getBaselineTime(anchor.distanceM * (1 + 1e-12)), 1e-6)
+        }
+    }
+    
     @Test
     fun `should handle edge cases`() {
         // Very short distance
@@ -0,0 +1,46 @@
+package com.mebeatme.core.ppi
+
+import kotlinx.benchmark.Benchmark
+import kotlinx.benchmark.BenchmarkMode
+import kotlinx.benchmark.Blackhole
+import kotlinx.benchmark.Measurement
+import kotlinx.benchmark.Mode
+import kotlinx.benchmark.OutputTimeUnit
+import kotlinx.benchmark.Scope
+import kotlinx.benchmark.Setup
+import kotlinx.benchmark.State
+import kotlinx.benchmark.Warmup
+import java.util.concurrent.TimeUnit
+import kotlin.random.Random
+
+/**
+ * Throughput of scoring a 200k-run history one call at a time against one [PpiCurvePurdy.scoreBatch].
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.MILLISECONDS)
+@Warmup(iterations = 3, time = 1, timeUnit = TimeUnit.SECONDS)
+@Measurement(iterations = 5, time = 1, timeUnit = TimeUnit.SECONDS)
+class PpiBatchBenchmark {
+
+    private val count = 200_000
+    private lateinit var distances: DoubleArray
+    private lateinit var times: DoubleArray
+    private lateinit var out: DoubleArray
+
+    @Setup
+    fun setUp() {
+        val random = Random(7)
+        distances = DoubleArray(count) { random.nextDouble(400.0, 60_000.0) }
+        times = DoubleArray(count) { distances[it] / random.nextDouble(2.0, 6.5) }
+        out = DoubleArray(count)
+    }
+
+    @Benchmark
+    fun scalar(blackhole: Blackhole) {
+        for (i in 0 until count) blackhole.consume(PpiCurvePurdy.score(distances[i], times[i]))
+    }
+
+    @Benchmark
+    fun batch(): DoubleArray = PpiCurvePurdy.scoreBatch(distances, times, out)
+}
@@ -0,0 +1,63 @@
+package com.mebeatme.core.ppi
+
+import kotlinx.benchmark.Benchmark
+import kotlinx.benchmark.BenchmarkMode
+import kotlinx.benchmark.Blackhole
+import kotlinx.benchmark.Measurement
+import kotlinx.benchmark.Mode
+import kotlinx.benchmark.OutputTimeUnit
+import kotlinx.benchmark.Scope
+import kotlinx.benchmark.Setup
+import kotlinx.benchmark.State
+import kotlinx.benchmark.Warmup
+import java.util.concurrent.TimeUnit
+import kotlin.random.Random
+
+/**
+ * Latency of 20k required-time solves: the 50-step bisection requiredTimeFor used
+ * before, the closed-form inverse, and [PpiInverse.requiredTimeForBatch].
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+@Warmup(iterations = 3, time = 1, timeUnit = TimeUnit.SECONDS)
+@Measurement(iterations = 5, time = 1, timeUnit = TimeUnit.SECONDS)
+class PpiInverseBenchmark {
+
+    private val count = 20_000
+    private lateinit var distances: DoubleArray
+    private lateinit var targets: DoubleArray
+    private lateinit var out: DoubleArray
+
+    @Setup
+    fun setUp() {
+        val random = Random(11)
+        distances = DoubleArray(count) { random.nextDouble(800.0, 50_000.0) }
+        targets = DoubleArray(count) { random.nextDouble(150.0, 1900.0) }
+        out = DoubleArray(count)
+    }
+
+    @Benchmark
+    fun bisection(blackhole: Blackhole) {
+        for (i in 0 until count) blackhole.consume(bisectionRequiredTime(distances[i], targets[i]))
+    }
+
+    @Benchmark
+    fun closedForm(blackhole: Blackhole) {
+        for (i in 0 until count) blackhole.consume(PpiCurvePurdy.requiredTimeFor(distances[i], targets[i]))
+    }
+
+    @Benchmark
+    fun batch(): DoubleArray = PpiInverse.requiredTimeForBatch(PpiModel.PurdyV1, distances, targets, out)
+
+    // The search requiredTimeFor ran before the closed form; PpiInverseTest checks both agree
+    private fun bisectionRequiredTime(distanceM: Double, targetScore: Double): Double {
+        var low = 0.1
+        var high = PurdyTable.getBaselineTime(distanceM) * 3.0
+        repeat(50) {
+            val mid = (low + high) / 2.0
+            if (PpiCurvePurdy.score(distanceM, mid) >= targetScore) high = mid else low = mid
+        }
+        return high
+    }
+}
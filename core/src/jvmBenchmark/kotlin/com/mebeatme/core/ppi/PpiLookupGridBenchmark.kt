@@ -0,0 +1,55 @@
+package com.mebeatme.core.ppi
+
+import kotlinx.benchmark.Benchmark
+import kotlinx.benchmark.BenchmarkMode
+import kotlinx.benchmark.Blackhole
+import kotlinx.benchmark.Measurement
+import kotlinx.benchmark.Mode
+import kotlinx.benchmark.OutputTimeUnit
+import kotlinx.benchmark.Scope
+import kotlinx.benchmark.Setup
+import kotlinx.benchmark.State
+import kotlinx.benchmark.Warmup
+import org.openjdk.jmh.annotations.OperationsPerInvocation
+import java.util.concurrent.TimeUnit
+import kotlin.random.Random
+
+/**
+ * Per-call latency of the exact Purdy curve against [PpiLookupGrid]; the grid's
+ * error bound is asserted in PpiLookupGridTest.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.NANOSECONDS)
+@Warmup(iterations = 3, time = 1, timeUnit = TimeUnit.SECONDS)
+@Measurement(iterations = 5, time = 1, timeUnit = TimeUnit.SECONDS)
+class PpiLookupGridBenchmark {
+
+    private lateinit var grid: PpiLookupGrid
+    private lateinit var distances: DoubleArray
+    private lateinit var times: DoubleArray
+
+    @Setup
+    fun setUp() {
+        grid = PpiLookupGrid.build(PpiModel.PurdyV1)
+        val random = Random(5)
+        distances = DoubleArray(CALLS) { random.nextDouble(200.0, 45_000.0) }
+        times = DoubleArray(CALLS) { distances[it] / random.nextDouble(2.0, 6.0) }
+    }
+
+    @Benchmark
+    @OperationsPerInvocation(CALLS)
+    fun exact(blackhole: Blackhole) {
+        for (i in 0 until CALLS) blackhole.consume(PpiCurvePurdy.score(distances[i], times[i]))
+    }
+
+    @Benchmark
+    @OperationsPerInvocation(CALLS)
+    fun lookupGrid(blackhole: Blackhole) {
+        for (i in 0 until CALLS) blackhole.consume(grid.score(distances[i], times[i]))
+    }
+
+    private companion object {
+        const val CALLS = 10_000
+    }
+}
@@ -0,0 +1,146 @@
+import Foundation
+
+/// Read-only view over runs packed by the shared module (`JsonRunStore.getAllPacked()`,
+/// `listSincePacked(sinceMs:)`), read in place from the NSData instead of bridging one
+/// Objective-C object per run.
+///
+/// Layout, little-endian: a 24-byte header, fixed-size records, then a string table.
+/// The constants in `Layout` mirror `RunBatchCodec` in shared/.../persistence/RunBatch.kt.
+struct PackedRuns: RandomAccessCollection {
+
+    enum Layout {
+        static let magic: [UInt8] = Array("MBMRUNS".utf8) + [0]
+        static let headerSize = 24
+        static let recordSize = 80
+
+        static let startedAt = 0
+        static let endedAt = 8
+        static let distance = 16
+        static let averagePace = 24
+        static let ppi = 32
+        static let elapsed = 40
+        static let averageHeartRate = 44
+        static let id = 48
+        static let source = 52
+        static let notes = 56
+        static let curveVersion = 60
+        static let bestEfforts = 64
+    }
+
+    /// Bands of `PackedRun.bestEffortSeconds(_:)`, in record order
+    enum Band: Int, CaseIterable {
+        case fiveK = 0, tenK, half, full
+    }
+
+    let data: Data
+    let count: Int
+    private let recordSize: Int
+    private let stringCount: Int
+    private let stringOffsets: Int
+    private let stringData: Int
+
+    /// - Parameter data: Buffer from the shared module; bridging NSData to Data does not copy it
+    /// - Throws: `AppError.kmpBridgeError` if the buffer is not a run batch this reader understands
+    init(_ data: Data) throws {
+        guard data.count >= Layout.headerSize, data.prefix(8).elementsEqual(Layout.magic) else {
+            throw AppError.kmpBridgeError("Not a packed run batch")
+        }
+        self.data = data
+        // Newer versions only append record fields, so step by the header's record size
+        recordSize = Int(Self.load(UInt16.self, from: data, at: 10))
+        count = Int(Self.load(UInt32.self, from: data, at: 12))
+        let stringsOffset = Int(Self.load(UInt32.self, from: data, at: 16))
+        let stringsLength = Int(Self.load(UInt32.self, from: data, at: 20))
+        guard recordSize >= Layout.recordSize,
+              Layout.headerSize + count * recordSize <= stringsOffset,
+              stringsLength >= 4,
+              stringsOffset + stringsLength <= data.count else {
+            throw AppError.kmpBridgeError("Packed run batch is truncated")
+        }
+        stringCount = Int(Self.load(UInt32.self, from: data, at: stringsOffset))
+        guard 4 * (stringCount + 2) <= stringsLength else {
+            throw AppError.kmpBridgeError("Packed run batch string table is truncated")
+        }
+        stringOffsets = stringsOffset + 4
+        stringData = stringOffsets + 4 * (stringCount + 1)
+        // Offsets must climb from 0 to at most the string bytes, so string(_:) never reads past the buffer
+        let stringBytes = stringsOffset + stringsLength - stringData
+        var previous = 0
+        for i in 0...stringCount {
+            let offset = Int(Self.load(UInt32.self, from: data, at: stringOffsets + 4 * i))
+            guard offset >= previous, offset <= stringBytes, i > 0 || offset == 0 else {
+                throw AppError.kmpBridgeError("Packed run batch string table is corrupt")
+            }
+            previous = offset
+        }
+    }
+
+    var startIndex: Int { 0 }
+    var endIndex: Int { count }
+
+    subscript(position: Int) -> PackedRun {
+        precondition(indices.contains(position), "Run \(position) of \(count)")
+        return PackedRun(runs: self, offset: Layout.headerSize + position * recordSize)
+    }
+
+    // MARK: - Field Access
+
+    fileprivate func load<T: FixedWidthInteger>(_ type: T.Type, at offset: Int) -> T {
+        Self.load(type, from: data, at: offset)
+    }
+
+    fileprivate func string(_ index: Int32) -> String? {
+        guard index >= 0, Int(index) < stringCount else { return nil }
+        let from = Int(load(UInt32.self, at: stringOffsets + 4 * Int(index)))
+        let to = Int(load(UInt32.self, at: stringOffsets + 4 * (Int(index) + 1)))
+        let start = data.startIndex + stringData
+        return String(decoding: data[(start + from)..<(start + to)], as: UTF8.self)
+    }
+
+    private static func load<T: FixedWidthInteger>(_ type: T.Type, from data: Data, at offset: Int) -> T {
+        data.withUnsafeBytes { T(littleEndian: $0.loadUnaligned(fromByteOffset: offset, as: T.self)) }
+    }
+}
+
+/// One run inside `PackedRuns`; fields are decoded from the buffer on access
+struct PackedRun {
+    fileprivate let runs: PackedRuns
+    fileprivate let offset: Int
+
+    var id: String { runs.string(int(PackedRuns.Layout.id)) ?? "" }
+    var source: String { runs.string(int(PackedRuns.Layout.source)) ?? "" }
+    var notes: String? { runs.string(int(PackedRuns.Layout.notes)) }
+    var ppiCurveVersion: String? { runs.string(int(PackedRuns.Layout.curveVersion)) }
+
+    var startedAtMs: Int64 { Int64(bitPattern: runs.load(UInt64.self, at: offset + PackedRuns.Layout.startedAt)) }
+    var endedAtMs: Int64 { Int64(bitPattern: runs.load(UInt64.self, at: offset + PackedRuns.Layout.endedAt)) }
+    var date: Date { Date(timeIntervalSince1970: Double(startedAtMs) / 1000) }
+
+    var distance: Double { double(PackedRuns.Layout.distance) } // meters
+    var averagePace: Double { double(PackedRuns.Layout.averagePace) } // seconds per kilometer
+    var duration: Int { Int(int(PackedRuns.Layout.elapsed)) } // seconds
+
+    var ppi: Double? {
+        let value = double(PackedRuns.Layout.ppi)
+        return value.isNaN ? nil : value
+    }
+
+    var averageHeartRate: Int? {
+        let value = int(PackedRuns.Layout.averageHeartRate)
+        return value < 0 ? nil : Int(value)
+    }
+
+    /// Fastest segment of a standard distance inside this run, if its samples covered it
+    func bestEffortSeconds(_ band: PackedRuns.Band) -> Int? {
+        let value = int(PackedRuns.Layout.bestEfforts + 4 * band.rawValue)
+        return value < 0 ? nil : Int(value)
+    }
+
+    private func int(_ field: Int) -> Int32 {
+        Int32(bitPattern: runs.load(UInt32.self, at: offset + field))
+    }
+
+    private func double(_ field: Int) -> Double {
+        Double(bitPattern: runs.load(UInt64.self, at: offset + field))
+    }
+}
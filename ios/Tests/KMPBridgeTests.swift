@@ -91,10 +91,10 @@ class KMPBridgeTests: XCTestCase {
         let dayMs: Int64 = 24 * 3600 * 1000
         
         let runs = [
-            RunDTO(id: "1", source: "GPX", startedAtEpochMs: nowMs - 10 * dayMs, endedAtEpochMs: nowMs - 10 * dayMs + 1500, distanceMeters: 5000.0, elapsedSeconds: 1500, avgPaceSecPerKm: 300.0, avgHr: nil, ppi: 400.0, notes: nil),
-            RunDTO(id: "2", source: "GPX", startedAtEpochMs: nowMs - 50 * dayMs, endedAtEpochMs: nowMs - 50 * dayMs + 1200, distanceMeters: 5000.0, elapsedSeconds: 1200, avgPaceSecPerKm: 240.0, avgHr: nil, ppi: 600.0, notes: nil),
-            RunDTO(id: "3", source: "GPX", startedAtEpochMs: nowMs - 100 * dayMs, endedAtEpochMs: nowMs - 100 * dayMs + 1800, distanceMeters: 5000.0, elapsedSeconds: 1800, avgPaceSecPerKm: 360.0, avgHr: nil, ppi: 300.0, notes: nil), // Outside 90 days
-            RunDTO(id: "4", source: "GPX", startedAtEpochMs: nowMs - 5 * dayMs, endedAtEpochMs: nowMs - 5 * dayMs + 1400, distanceMeters: 5000.0, elapsedSeconds: 1400, avgPaceSecPerKm: 280.0, avgHr: nil, ppi: 500.0, notes: nil)
+            RunDTO(id: "1", source: "GPX", startedAtEpochMs: nowMs - 10 * dayMs, endedAtEpochMs: nowMs - 10 * dayMs + 1500, distanceMeters: 5000.0, elapsedSeconds: 1500, avgPaceSecPerKm: 300.0, avgHr: nil, ppi: 400.0, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: []),
+            RunDTO(id: "2", source: "GPX", startedAtEpochMs: nowMs - 50 * dayMs, endedAtEpochMs: nowMs - 50 * dayMs + 1200, distanceMeters: 5000.0, elapsedSeconds: 1200, avgPaceSecPerKm: 240.0, avgHr: nil, ppi: 600.0, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: []),
+            RunDTO(id: "3", source: "GPX", startedAtEpochMs: nowMs - 100 * dayMs, endedAtEpochMs: nowMs - 100 * dayMs + 1800, distanceMeters: 5000.0, elapsedSeconds: 1800, avgPaceSecPerKm: 360.0, avgHr: nil, ppi: 300.0, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: []), // Outside 90 days
+            RunDTO(id: "4", source: "GPX", startedAtEpochMs: nowMs - 5 * dayMs, endedAtEpochMs: nowMs - 5 * dayMs + 1400, distanceMeters: 5000.0, elapsedSeconds: 1400, avgPaceSecPerKm: 280.0, avgHr: nil, ppi: 500.0, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: [])
         ]
         
         let highest = PerfIndex.highestPpiInWindow(runs: runs, nowMs: nowMs, days: 90)
@@ -104,7 +104,7 @@ class KMPBridgeTests: XCTestCase {
     func testHighestPpiInWindowNoRuns() {
         let nowMs: Int64 = 1700000000000
         let runs = [
-            RunDTO(id: "1", source: "GPX", startedAtEpochMs: nowMs - 100 * 24 * 3600 * 1000, endedAtEpochMs: nowMs - 100 * 24 * 3600 * 1000 + 1500, distanceMeters: 5000.0, elapsedSeconds: 1500, avgPaceSecPerKm: 300.0, avgHr: nil, ppi: 400.0, notes: nil)
+            RunDTO(id: "1", source: "GPX", startedAtEpochMs: nowMs - 100 * 24 * 3600 * 1000, endedAtEpochMs: nowMs - 100 * 24 * 3600 * 1000 + 1500, distanceMeters: 5000.0, elapsedSeconds: 1500, avgPaceSecPerKm: 300.0, avgHr: nil, ppi: 400.0, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: [])
         ]
         
         let highest = PerfIndex.highestPpiInWindow(runs: runs, nowMs: nowMs, days: 90)
@@ -116,8 +116,8 @@ class KMPBridgeTests: XCTestCase {
         let dayMs: Int64 = 24 * 3600 * 1000
         
         let runs = [
-            RunDTO(id: "1", source: "GPX", startedAtEpochMs: nowMs - 10 * dayMs, endedAtEpochMs: nowMs - 10 * dayMs + 1500, distanceMeters: 5000.0, elapsedSeconds: 1500, avgPaceSecPerKm: 300.0, avgHr: nil, ppi: nil, notes: nil),
-            RunDTO(id: "2", source: "GPX", startedAtEpochMs: nowMs - 20 * dayMs, endedAtEpochMs: nowMs - 20 * dayMs + 1200, distanceMeters: 5000.0, elapsedSeconds: 1200, avgPaceSecPerKm: 240.0, avgHr: nil, ppi: 600.0, notes: nil)
+            RunDTO(id: "1", source: "GPX", startedAtEpochMs: nowMs - 10 * dayMs, endedAtEpochMs: nowMs - 10 * dayMs + 1500, distanceMeters: 5000.0, elapsedSeconds: 1500, avgPaceSecPerKm: 300.0, avgHr: nil, ppi: nil, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: []),
+            RunDTO(id: "2", source: "GPX", startedAtEpochMs: nowMs - 20 * dayMs, endedAtEpochMs: nowMs - 20 * dayMs + 1200, distanceMeters: 5000.0, elapsedSeconds: 1200, avgPaceSecPerKm: 240.0, avgHr: nil, ppi: 600.0, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: [])
         ]
         
         let highest = PerfIndex.highestPpiInWindow(runs: runs, nowMs: nowMs, days: 90)
@@ -126,14 +126,14 @@ class KMPBridgeTests: XCTestCase {
     
     func testCalculateBests() {
         let runs = [
-            RunDTO(id: "1", source: "GPX", startedAtEpochMs: 1000, endedAtEpochMs: 2000, distanceMeters: 5000.0, elapsedSeconds: 1500, avgPaceSecPerKm: 300.0, avgHr: nil, ppi: nil, notes: nil), // 5K in 25:00
-            RunDTO(id: "2", source: "GPX", startedAtEpochMs: 2000, endedAtEpochMs: 3000, distanceMeters: 5000.0, elapsedSeconds: 1200, avgPaceSecPerKm: 240.0, avgHr: nil, ppi: nil, notes: nil), // 5K in 20:00 (better)
-            RunDTO(id: "3", source: "GPX", startedAtEpochMs: 3000, endedAtEpochMs: 4000, distanceMeters: 10000.0, elapsedSeconds: 3000, avgPaceSecPerKm: 300.0, avgHr: nil, ppi: nil, notes: nil), // 10K in 50:00
-            RunDTO(id: "4", source: "GPX", startedAtEpochMs: 4000, endedAtEpochMs: 5000, distanceMeters: 10000.0, elapsedSeconds: 2400, avgPaceSecPerKm: 240.0, avgHr: nil, ppi: nil, notes: nil), // 10K in 40:00 (better)
-            RunDTO(id: "5", source: "GPX", startedAtEpochMs: 5000, endedAtEpochMs: 6000, distanceMeters: 21097.5, elapsedSeconds: 6300, avgPaceSecPerKm: 300.0, avgHr: nil, ppi: nil, notes: nil), // Half in 1:45:00
-            RunDTO(id: "6", source: "GPX", startedAtEpochMs: 6000, endedAtEpochMs: 7000, distanceMeters: 21097.5, elapsedSeconds: 5400, avgPaceSecPerKm: 256.0, avgHr: nil, ppi: nil, notes: nil), // Half in 1:30:00 (better)
-            RunDTO(id: "7", source: "GPX", startedAtEpochMs: 7000, endedAtEpochMs: 8000, distanceMeters: 42195.0, elapsedSeconds: 12600, avgPaceSecPerKm: 300.0, avgHr: nil, ppi: nil, notes: nil), // Full in 3:30:00
-            RunDTO(id: "8", source: "GPX", startedAtEpochMs: 8000, endedAtEpochMs: 9000, distanceMeters: 42195.0, elapsedSeconds: 10800, avgPaceSecPerKm: 256.0, avgHr: nil, ppi: nil, notes: nil) // Full in 3:00:00 (better)
+            RunDTO(id: "1", source: "GPX", startedAtEpochMs: 1000, endedAtEpochMs: 2000, distanceMeters: 5000.0, elapsedSeconds: 1500, avgPaceSecPerKm: 300.0, avgHr: nil, ppi: nil, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: []), // 5K in 25:00
+            RunDTO(id: "2", source: "GPX", startedAtEpochMs: 2000, endedAtEpochMs: 3000, distanceMeters: 5000.0, elapsedSeconds: 1200, avgPaceSecPerKm: 240.0, avgHr: nil, ppi: nil, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: []), // 5K in 20:00 (better)
+            RunDTO(id: "3", source: "GPX", startedAtEpochMs: 3000, endedAtEpochMs: 4000, distanceMeters: 10000.0, elapsedSeconds: 3000, avgPaceSecPerKm: 300.0, avgHr: nil, ppi: nil, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: []), // 10K in 50:00
+            RunDTO(id: "4", source: "GPX", startedAtEpochMs: 4000, endedAtEpochMs: 5000, distanceMeters: 10000.0, elapsedSeconds: 2400, avgPaceSecPerKm: 240.0, avgHr: nil, ppi: nil, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: []), // 10K in 40:00 (better)
+            RunDTO(id: "5", source: "GPX", startedAtEpochMs: 5000, endedAtEpochMs: 6000, distanceMeters: 21097.5, elapsedSeconds: 6300, avgPaceSecPerKm: 300.0, avgHr: nil, ppi: nil, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: []), // Half in 1:45:00
+            RunDTO(id: "6", source: "GPX", startedAtEpochMs: 6000, endedAtEpochMs: 7000, distanceMeters: 21097.5, elapsedSeconds: 5400, avgPaceSecPerKm: 256.0, avgHr: nil, ppi: nil, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: []), // Half in 1:30:00 (better)
+            RunDTO(id: "7", source: "GPX", startedAtEpochMs: 7000, endedAtEpochMs: 8000, distanceMeters: 42195.0, elapsedSeconds: 12600, avgPaceSecPerKm: 300.0, avgHr: nil, ppi: nil, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: []), // Full in 3:30:00
+            RunDTO(id: "8", source: "GPX", startedAtEpochMs: 8000, endedAtEpochMs: 9000, distanceMeters: 42195.0, elapsedSeconds: 10800, avgPaceSecPerKm: 256.0, avgHr: nil, ppi: nil, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: []) // Full in 3:00:00 (better)
         ]
         
         let bests = PerfIndex.calculateBests(runs: runs)
@@ -157,8 +157,8 @@ class KMPBridgeTests: XCTestCase {
     func testCalculateBestsWithSinceFilter() {
         let baseTime: Int64 = 1700000000000
         let runs = [
-            RunDTO(id: "1", source: "GPX", startedAtEpochMs: baseTime - 1000, endedAtEpochMs: baseTime - 1000 + 1500, distanceMeters: 5000.0, elapsedSeconds: 1500, avgPaceSecPerKm: 300.0, avgHr: nil, ppi: nil, notes: nil), // Old run
-            RunDTO(id: "2", source: "GPX", startedAtEpochMs: baseTime + 1000, endedAtEpochMs: baseTime + 1000 + 1200, distanceMeters: 5000.0, elapsedSeconds: 1200, avgPaceSecPerKm: 240.0, avgHr: nil, ppi: nil, notes: nil) // Recent run
+            RunDTO(id: "1", source: "GPX", startedAtEpochMs: baseTime - 1000, endedAtEpochMs: baseTime - 1000 + 1500, distanceMeters: 5000.0, elapsedSeconds: 1500, avgPaceSecPerKm: 300.0, avgHr: nil, ppi: nil, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: []), // Old run
+            RunDTO(id: "2", source: "GPX", startedAtEpochMs: baseTime + 1000, endedAtEpochMs: baseTime + 1000 + 1200, distanceMeters: 5000.0, elapsedSeconds: 1200, avgPaceSecPerKm: 240.0, avgHr: nil, ppi: nil, notes: nil, ppiCurveVersion: nil, bestEffortsSec: [:], maxDistanceByDurationM: []) // Recent run
         ]
         
         let bests = PerfIndex.calculateBests(runs: runs, sinceMs: baseTime)
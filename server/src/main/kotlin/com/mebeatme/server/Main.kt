@@ -11,7 +11,19 @@ import io.ktor.server.routing.*
 import io.ktor.serialization.kotlinx.json.*
 import kotlinx.serialization.json.Json
 import com.mebeatme.shared.api.*
-import com.mebeatme.shared.core.highestPpiInWindow
+import com.mebeatme.shared.persistence.BestsBand
+import com.mebeatme.shared.persistence.BestsIndex
+import com.mebeatme.shared.persistence.MergedRunSketches
+import com.mebeatme.shared.persistence.PpiWindowIndex
+import com.mebeatme.shared.persistence.RollupPeriod
+import com.mebeatme.shared.persistence.RunLog
+import com.mebeatme.shared.persistence.RunLogFile
+import com.mebeatme.shared.persistence.RunMetric
+import com.mebeatme.shared.persistence.RunRollups
+import com.mebeatme.shared.persistence.RunSketches
+import com.mebeatme.shared.model.DistanceBucket
+import kotlinx.datetime.IllegalTimeZoneException
+import kotlinx.datetime.TimeZone
 import java.util.concurrent.ConcurrentHashMap
 import java.util.concurrent.atomic.AtomicLong
 
@@ -72,15 +84,7 @@ fun main() {
             get("/bests") {
                 try {
                     val since = call.request.queryParameters["since"]?.toLongOrNull() ?: 0L
-                    val runs = runRepository.listSince(since)
-                    
-                    val bests = BestsDTO(
-                        best5kSec = findBestTime(runs, 5000.0),
-                        best10kSec = findBestTime(runs, 10000.0),
-                        bestHalfSec = findBestTime(runs, 21097.0),
-                        bestFullSec = findBestTime(runs, 42195.0),
-                        highestPPILast90Days = highestPpiInWindow(runs, System.currentTimeMillis())
-                    )
+                    val bests = runRepository.bests(since, System.currentTimeMillis())
                     
                     call.respond(bests)
                 } catch (e: Exception) {
@@ -92,44 +96,175 @@ fun main() {
             get("/sync/bests") {
                 try {
                     val since = call.request.queryParameters["since"]?.toLongOrNull() ?: 0L
-                    val runs = runRepository.listSince(since)
-                    
-                    val bests = BestsDTO(
-                        best5kSec = findBestTime(runs, 5000.0),
-                        best10kSec = findBestTime(runs, 10000.0),
-                        bestHalfSec = findBestTime(runs, 21097.0),
-                        bestFullSec = findBestTime(runs, 42195.0),
-                        highestPPILast90Days = highestPpiInWindow(runs, System.currentTimeMillis())
-                    )
+                    val bests = runRepository.bests(since, System.currentTimeMillis())
                     
                     call.respond(bests)
                 } catch (e: Exception) {
                     call.respond(500, ErrorResponse("internal_error", "Internal server error: ${e.message}"))
                 }
             }
+            
+            // Dashboard aggregates: ?period=day|week|month&from=<ms>&to=<ms>[&tz=<IANA zone> of the user, default UTC]
+            get("/rollups") {
+                try {
+                    val period = call.request.queryParameters["period"]
+                        ?.let { name -> RollupPeriod.values().find { it.name.equals(name, ignoreCase = true) } }
+                        ?: RollupPeriod.DAY
+                    val to = call.request.queryParameters["to"]?.toLongOrNull() ?: System.currentTimeMillis()
+                    val from = call.request.queryParameters["from"]?.toLongOrNull() ?: (to - 365 * 24L * 3600_000)
+                    val timeZone = try {
+                        call.request.queryParameters["tz"]?.let { TimeZone.of(it) } ?: TimeZone.UTC
+                    } catch (e: IllegalTimeZoneException) {
+                        call.respond(400, ErrorResponse("invalid_query", "Unknown time zone"))
+                        return@get
+                    }
+                    
+                    call.respond(runRepository.rollups(period, from, to, timeZone))
+                } catch (e: Exception) {
+                    call.respond(500, ErrorResponse("internal_error", "Internal server error: ${e.message}"))
+                }
+            }
+            
+            // Population percentiles: ?bucket=<DistanceBucket>&metric=ppi|pace&q=0.5,0.9[&value=<x> for its rank]
+            get("/percentiles") {
+                try {
+                    val bucket = call.request.queryParameters["bucket"]
+                        ?.let { name -> DistanceBucket.values().find { it.name.equals(name, ignoreCase = true) } }
+                    if (bucket == null) {
+                        call.respond(400, ErrorResponse("invalid_query", "Unknown or missing bucket"))
+                        return@get
+                    }
+                    val metric = call.request.queryParameters["metric"]
+                        ?.let { name -> RunMetric.values().find { it.name.equals(name, ignoreCase = true) } }
+                        ?: RunMetric.PPI
+                    val quantiles = call.request.queryParameters["q"]
+                        ?.split(',')?.mapNotNull { it.trim().toDoubleOrNull()?.takeIf { q -> q in 0.0..1.0 } }
+                        ?: listOf(0.5, 0.9)
+                    val value = call.request.queryParameters["value"]?.toDoubleOrNull()
+                    
+                    call.respond(runRepository.percentiles(bucket, metric, quantiles, value))
+                } catch (e: Exception) {
+                    call.respond(500, ErrorResponse("internal_error", "Internal server error: ${e.message}"))
+                }
+            }
+            
+            // This shard's own sketches, for merging into another shard
+            get("/sketches") {
+                call.respond(runRepository.sketches())
+            }
+            
+            // Take another shard's or device's sketches; a later push from the same source replaces the earlier one
+            post("/sketches/merge") {
+                val source = call.request.queryParameters["source"]
+                if (source.isNullOrBlank()) {
+                    call.respond(400, ErrorResponse("invalid_query", "Missing source"))
+                    return@post
+                }
+                try {
+                    runRepository.mergeSketches(source, call.receive<RunSketches>())
+                    call.respond(mapOf("status" to "ok"))
+                } catch (e: Exception) {
+                    call.respond(400, ErrorResponse("invalid_payload", "Invalid sketches: ${e.message}"))
+                }
+            }
         }
     }.start(wait = true)
 }
 
-// Simple in-memory repository for demo purposes
+// Simple in-memory repository for demo purposes, optionally backed by a run log
 object runRepository {
     private val runs = ConcurrentHashMap<String, RunDTO>()
     private val idCounter = AtomicLong(1)
     
+    // Bests (standard distances within 5%), 90-day PPI, rollups and sketches, updated on every upsert; all guarded by bestsIndex
+    private val bestsIndex = BestsIndex(BestsBand.withTolerance(0.05))
+    private val ppiWindows = PpiWindowIndex()
+    // Rollups per requested zone (UTC unless the client sends its own), built from the runs on first use;
+    // past MAX_ROLLUP_ZONES the least recently read zone is dropped
+    private const val MAX_ROLLUP_ZONES = 8
+    private val rollupsByZone = object : LinkedHashMap<TimeZone, RunRollups>(16, 0.75f, true) {
+        override fun removeEldestEntry(eldest: MutableMap.MutableEntry<TimeZone, RunRollups>) = size > MAX_ROLLUP_ZONES
+    }
+    private val sketches = RunSketches()
+    private val mergedSketches = MergedRunSketches(sketches)
+    
+    // Optional durable backing: MEBEATME_RUN_LOG=<path> replays that run log at startup and appends every write
+    private val log = RunLog(RunDTO.serializer()) { it.id }
+    private val logFile = System.getenv("MEBEATME_RUN_LOG")?.let { RunLogFile(it) }
+    
+    init {
+        logFile?.let { file ->
+            synchronized(bestsIndex) { log.replay(file.open()).forEach { index(it) } }
+            // Generated ids continue after the replayed ones
+            runs.keys.filter { it.startsWith("run_") }.mapNotNull { it.removePrefix("run_").toLongOrNull() }
+                .maxOrNull()?.let { idCounter.set(it + 1) }
+        }
+    }
+    
     fun upsertAll(newRuns: List<RunDTO>): Int {
-        var stored = 0
-        newRuns.forEach { run ->
-            val runWithId = if (run.id.isBlank()) {
+        val runsWithIds = newRuns.map { run ->
+            if (run.id.isBlank()) {
                 run.copy(id = "run_${idCounter.getAndIncrement()}")
             } else {
                 run
             }
-            runs[runWithId.id] = runWithId
-            stored++
         }
-        return stored
+        synchronized(bestsIndex) {
+            logFile?.append(runsWithIds.map { log.upsert(it) })
+            runsWithIds.forEach { index(it) }
+        }
+        return runsWithIds.size
+    }
+    
+    private fun index(run: RunDTO) {
+        runs[run.id] = run
+        bestsIndex.upsert(run.id, run.distanceMeters, run.elapsedSeconds, run.startedAtEpochMs, run.bestEffortsSec)
+        ppiWindows.upsert(run.id, run.startedAtEpochMs, run.ppi)
+        rollupsByZone.values.forEach { it.upsert(run.id, run.startedAtEpochMs, run.distanceMeters, run.elapsedSeconds, run.ppi) }
+        sketches.upsert(run.id, run.distanceMeters, run.ppi, run.avgPaceSecPerKm)
+        mergedSketches.invalidate()
+    }
+    
+    fun bests(sinceMs: Long, nowMs: Long): BestsDTO {
+        return synchronized(bestsIndex) {
+            val times = bestsIndex.bestSecondsByBand(sinceMs)
+            val cutoffMs = maxOf(sinceMs, nowMs - 90 * 24L * 3600_000)
+            BestsDTO(
+                best5kSec = times[0],
+                best10kSec = times[1],
+                bestHalfSec = times[2],
+                bestFullSec = times[3],
+                highestPPILast90Days = ppiWindows.maxPpi(cutoffMs)
+            )
+        }
     }
     
+    fun rollups(period: RollupPeriod, fromMs: Long, toMs: Long, timeZone: TimeZone) = synchronized(bestsIndex) {
+        val rollups = rollupsByZone.getOrPut(timeZone) {
+            RunRollups(timeZone).also { zone ->
+                runs.values.forEach { zone.upsert(it.id, it.startedAtEpochMs, it.distanceMeters, it.elapsedSeconds, it.ppi) }
+            }
+        }
+        rollups.rows(period, fromMs, toMs)
+    }
+    
+    fun percentiles(bucket: DistanceBucket, metric: RunMetric, quantiles: List<Double>, value: Double?): PercentilesResponse {
+        return synchronized(bestsIndex) {
+            val combined = mergedSketches.combined()
+            PercentilesResponse(
+                bucket = bucket.name,
+                metric = metric.name,
+                count = combined.count(bucket, metric),
+                quantiles = quantiles.associate { it.toString() to combined.quantile(bucket, metric, it) },
+                rank = value?.let { combined.rank(bucket, metric, it) }
+            )
+        }
+    }
+    
+    fun sketches(): RunSketches = synchronized(bestsIndex) { sketches.copy() }
+    
+    fun mergeSketches(source: String, other: RunSketches) = synchronized(bestsIndex) { mergedSketches.put(source, other) }
+    
     fun listSince(sinceMs: Long): List<RunDTO> {
         return runs.values.filter { it.startedAtEpochMs >= sinceMs }
     }
@@ -138,15 +273,3 @@ object runRepository {
         return runs.values.toList()
     }
 }
-
-// Helper function to find best time for a specific distance
-private fun findBestTime(runs: List<RunDTO>, targetDistance: Double): Int? {
-    val tolerance = targetDistance * 0.05 // 5% tolerance
-    
-    return runs
-        .filter { run ->
-            val distanceDiff = kotlin.math.abs(run.distanceMeters - targetDistance)
-            distanceDiff <= tolerance
-        }
-        .minOfOrNull { it.elapsedSeconds }
-}
\ No newline at end of file
@@ -2,10 +2,17 @@ plugins {
     kotlin("multiplatform")
     kotlin("plugin.serialization")
     id("com.android.library")
+    kotlin("plugin.allopen")
+    id("org.jetbrains.kotlinx.benchmark")
 }
 
 kotlin {
-    jvm()
+    // The "benchmark" compilation holds the JMH benchmarks in src/jvmBenchmark (run with :shared:benchmark; not part of check)
+    jvm {
+        compilations.create("benchmark") {
+            associateWith(this@jvm.compilations.getByName("main"))
+        }
+    }
     
     androidTarget {
         compilations.all {
@@ -53,13 +60,29 @@ kotlin {
                 implementation("org.jetbrains.kotlinx:kotlinx-coroutines-test:1.7.3")
             }
         }
+        val jvmBenchmark by getting {
+            dependencies {
+                implementation("org.jetbrains.kotlinx:kotlinx-benchmark-runtime:0.4.11")
+            }
+        }
+        val jvmMain by getting
         val androidMain by getting
         val androidUnitTest by getting
+        // Code shared by the JVM and Android (java.nio run log, atomic file writes, atomic counters)
+        val jvmAndroidMain by creating {
+            dependsOn(commonMain)
+            jvmMain.dependsOn(this)
+            androidMain.dependsOn(this)
+        }
+        // Code shared by iOS and watchOS (cinterop writers, NSData bridges, the run log, atomic counters)
+        val appleMain by creating {
+            dependsOn(commonMain)
+        }
         val iosX64Main by getting
         val iosArm64Main by getting
         val iosSimulatorArm64Main by getting
         val iosMain by creating {
-            dependsOn(commonMain)
+            dependsOn(appleMain)
             iosX64Main.dependsOn(this)
             iosArm64Main.dependsOn(this)
             iosSimulatorArm64Main.dependsOn(this)
@@ -72,7 +95,7 @@ kotlin {
         val watchosArm64Main by getting
         val watchosSimulatorArm64Main by getting
         val watchosMain by creating {
-            dependsOn(commonMain)
+            dependsOn(appleMain)
             watchosArm64Main.dependsOn(this)
             watchosSimulatorArm64Main.dependsOn(this)
         }
@@ -82,6 +105,34 @@ kotlin {
     }
 }
 
+// Ship include/mebeatme_flat.h inside every Shared.framework and declare it in the framework
+// module, so `import Shared` also brings in MBMBests, MBMScore and MBMFeedback
+tasks.withType<org.jetbrains.kotlin.gradle.tasks.KotlinNativeLink>().configureEach {
+    val flatHeader = file("include/mebeatme_flat.h")
+    inputs.file(flatHeader)
+    doLast {
+        val framework = binary as? org.jetbrains.kotlin.gradle.plugin.mpp.Framework ?: return@doLast
+        val frameworkDir = framework.outputFile
+        flatHeader.copyTo(frameworkDir.resolve("Headers/mebeatme_flat.h"), overwrite = true)
+        val moduleMap = frameworkDir.resolve("Modules/module.modulemap")
+        val text = moduleMap.readText()
+        if ("mebeatme_flat.h" !in text) {
+            moduleMap.writeText(text.replaceFirst(Regex("umbrella header \"[^\"]+\""), "$0\n    header \"mebeatme_flat.h\""))
+        }
+    }
+}
+
+// JMH needs open benchmark classes
+allOpen {
+    annotation("org.openjdk.jmh.annotations.State")
+}
+
+benchmark {
+    targets {
+        register("jvmBenchmark")
+    }
+}
+
 android {
     namespace = "com.mebeatme.shared"
     compileSdk = 34
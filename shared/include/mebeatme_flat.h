@@ -0,0 +1,132 @@
+/*
+ * mebeatme_flat.h
+ * Plain C layouts of the shared module's bests, score and live feedback results.
+ *
+ * The Objective-C classes generated in Shared.h box every optional field
+ * (SharedInt *, SharedDouble *, SharedLong *), so each result costs several bridge
+ * objects. These structs are plain old data instead: optional fields are flagged in a
+ * `present` bitmask, and the shared module writes straight into a struct the caller
+ * owns, so a caller can keep one per screen and refresh it without allocating.
+ *
+ * Writers:
+ *   Swift (iOS, watchOS)  JsonRunStore.writeBests(nowMs:sinceMs:out:)
+ *                         MeBeatMeService.writeRealTimeFeedback(out:precision:)
+ *                         MeBeatMeService.completeSessionFlat(out:)
+ *   JVM / JNI             JsonRunStore.writeBests(nowMs, sinceMs, out, at) into a direct
+ *                         ByteBuffer in native order; C reads it via GetDirectBufferAddress
+ *
+ * Including it:
+ *   Swift                 The shared Gradle build copies this header into Shared.framework
+ *                         and lists it in the framework module, so `import Shared` is enough
+ *   C / JNI               Add shared/include to the include path; module.modulemap beside
+ *                         this file also exposes it to clang as module MeBeatMeFlat
+ *
+ * Fields are in the CPU's byte order (little-endian on every supported target) at the
+ * offsets below, which mirror the FlatBests, FlatScore and FlatFeedback objects in
+ * shared/src/commonMain/.../core/FlatStructs.kt. A field whose bit is clear in
+ * `present` is zero. Layouts only grow at the end; the size constants say how many
+ * bytes a writer fills.
+ */
+#ifndef MEBEATME_FLAT_H
+#define MEBEATME_FLAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* MARK: - Bests */
+
+/* Index into MBMBests.best_sec, the BestsBand.STANDARD order */
+enum {
+    MBM_BAND_5K = 0,
+    MBM_BAND_10K = 1,
+    MBM_BAND_HALF = 2,
+    MBM_BAND_FULL = 3,
+    MBM_BAND_COUNT = 4
+};
+
+/* MBMBests.present bits; best_sec[band] is set when (present & (1u << band)) */
+enum {
+    MBM_BESTS_HAS_5K = 1u << MBM_BAND_5K,
+    MBM_BESTS_HAS_10K = 1u << MBM_BAND_10K,
+    MBM_BESTS_HAS_HALF = 1u << MBM_BAND_HALF,
+    MBM_BESTS_HAS_FULL = 1u << MBM_BAND_FULL,
+    MBM_BESTS_HAS_HIGHEST_PPI = 1u << 4
+};
+
+/* BestsDTO: best times for 5K, 10K, half and full, and the highest PPI of the last 90 days */
+typedef struct MBMBests {
+    uint32_t present;
+    int32_t best_sec[MBM_BAND_COUNT];  /* seconds */
+    double highest_ppi_last_90_days;
+} MBMBests;
+
+/* MARK: - Score */
+
+/* MBMScore.present bits */
+enum {
+    MBM_SCORE_HAS_TARGET_PACE = 1u << 0,
+    MBM_SCORE_HAS_TARGET_DURATION = 1u << 1
+};
+
+/* Score of a completed session */
+typedef struct MBMScore {
+    uint32_t present;
+    int32_t bucket;                    /* DistanceBucket ordinal */
+    double ppi;
+    double target_pace;                /* seconds per kilometer */
+    int64_t target_duration;           /* seconds */
+    int32_t achieved;                  /* 1 if the PPI reached the challenge's expected PPI */
+    int32_t reserved;
+} MBMScore;
+
+/* MARK: - Live Feedback */
+
+/* MBMFeedback.pace_zone values, the PaceZone ordinals */
+enum {
+    MBM_PACE_ZONE_TOO_FAST = 0,
+    MBM_PACE_ZONE_ON_TARGET = 1,
+    MBM_PACE_ZONE_TOO_SLOW = 2
+};
+
+/* RealTimeFeedback during a run; every field is always set */
+typedef struct MBMFeedback {
+    double current_pace;               /* seconds per kilometer */
+    double target_pace;                /* seconds per kilometer */
+    double pace_difference;            /* current minus target; negative is faster */
+    double progress_percentage;        /* 0 to 1 */
+    double current_ppi;
+    int32_t pace_zone;
+    int32_t reserved;
+} MBMFeedback;
+
+/* MARK: - Layout Checks */
+
+#if defined(__cplusplus)
+#define MBM_STATIC_ASSERT(condition, message) static_assert(condition, message)
+#else
+#define MBM_STATIC_ASSERT(condition, message) _Static_assert(condition, message)
+#endif
+
+MBM_STATIC_ASSERT(sizeof(MBMBests) == 32, "MBMBests must match FlatBests.SIZE");
+MBM_STATIC_ASSERT(offsetof(MBMBests, best_sec) == 4, "FlatBests.OFFSET_BEST_SECONDS");
+MBM_STATIC_ASSERT(offsetof(MBMBests, highest_ppi_last_90_days) == 24, "FlatBests.OFFSET_HIGHEST_PPI");
+
+MBM_STATIC_ASSERT(sizeof(MBMScore) == 40, "MBMScore must match FlatScore.SIZE");
+MBM_STATIC_ASSERT(offsetof(MBMScore, ppi) == 8, "FlatScore.OFFSET_PPI");
+MBM_STATIC_ASSERT(offsetof(MBMScore, target_duration) == 24, "FlatScore.OFFSET_TARGET_DURATION");
+MBM_STATIC_ASSERT(offsetof(MBMScore, achieved) == 32, "FlatScore.OFFSET_ACHIEVED");
+
+MBM_STATIC_ASSERT(sizeof(MBMFeedback) == 48, "MBMFeedback must match FlatFeedback.SIZE");
+MBM_STATIC_ASSERT(offsetof(MBMFeedback, pace_zone) == 40, "FlatFeedback.OFFSET_PACE_ZONE");
+
+#undef MBM_STATIC_ASSERT
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEBEATME_FLAT_H */
@@ -0,0 +1,15 @@
+package com.mebeatme.shared.core
+
+import kotlin.concurrent.AtomicLongArray
+
+@OptIn(ExperimentalStdlibApi::class)
+internal actual class AtomicLongCells actual constructor(size: Int) {
+    private val cells = AtomicLongArray(size)
+
+    actual val size: Int get() = cells.length
+
+    actual operator fun get(index: Int): Long = cells[index]
+
+    actual fun compareAndSet(index: Int, expected: Long, newValue: Long): Boolean =
+        cells.compareAndSet(index, expected, newValue)
+}
@@ -0,0 +1,61 @@
+package com.mebeatme.shared.core
+
+import com.mebeatme.shared.service.MeBeatMeService
+import kotlinx.cinterop.ByteVar
+import kotlinx.cinterop.CPointer
+import kotlinx.cinterop.DoubleVar
+import kotlinx.cinterop.ExperimentalForeignApi
+import kotlinx.cinterop.IntVar
+import kotlinx.cinterop.LongVar
+import kotlinx.cinterop.plus
+import kotlinx.cinterop.pointed
+import kotlinx.cinterop.reinterpret
+import kotlinx.cinterop.value
+
+/*
+ * Writers into structs from shared/include/mebeatme_flat.h that Swift owns and passes in
+ * as `&value` (a void * in Shared.h). JsonRunStore.writeBests fills an MBMBests the same way.
+ */
+
+/**
+ * [MeBeatMeService.getRealTimeFeedback] written into an MBMFeedback; allocates nothing,
+ * so it can run for every sensor sample.
+ * @param out At least [FlatFeedback.SIZE] bytes, 8-aligned
+ * @return false, leaving [out] untouched, if no run is in progress
+ */
+@OptIn(ExperimentalForeignApi::class)
+fun MeBeatMeService.writeRealTimeFeedback(out: CPointer<ByteVar>, precision: ScoringPrecision = ScoringPrecision.FIXED_Q16): Boolean =
+    FlatFeedback.write(this, precision, { at, value -> out.putInt(at, value) }, { at, value -> out.putDouble(at, value) })
+
+/**
+ * [MeBeatMeService.completeSession] with the score written into an MBMScore, so the
+ * optional targets reach Swift without SharedDouble and SharedLong boxes.
+ * @param out At least [FlatScore.SIZE] bytes, 8-aligned
+ * @return false, leaving [out] untouched, if there was no session to complete
+ */
+@OptIn(ExperimentalForeignApi::class)
+fun MeBeatMeService.completeSessionFlat(out: CPointer<ByteVar>): Boolean {
+    val score = completeSession() ?: return false
+    FlatScore.write(
+        score,
+        putInt = { at, value -> out.putInt(at, value) },
+        putLong = { at, value -> out.putLong(at, value) },
+        putDouble = { at, value -> out.putDouble(at, value) }
+    )
+    return true
+}
+
+@OptIn(ExperimentalForeignApi::class)
+internal fun CPointer<ByteVar>.putInt(at: Int, value: Int) {
+    (this + at)!!.reinterpret<IntVar>().pointed.value = value
+}
+
+@OptIn(ExperimentalForeignApi::class)
+internal fun CPointer<ByteVar>.putLong(at: Int, value: Long) {
+    (this + at)!!.reinterpret<LongVar>().pointed.value = value
+}
+
+@OptIn(ExperimentalForeignApi::class)
+internal fun CPointer<ByteVar>.putDouble(at: Int, value: Double) {
+    (this + at)!!.reinterpret<DoubleVar>().pointed.value = value
+}
@@ -0,0 +1,48 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.core.calculateBestsPacked
+import com.mebeatme.shared.model.BestsDTO
+import kotlinx.cinterop.BetaInteropApi
+import kotlinx.cinterop.ExperimentalForeignApi
+import kotlinx.cinterop.addressOf
+import kotlinx.cinterop.convert
+import kotlinx.cinterop.usePinned
+import platform.Foundation.NSData
+import platform.Foundation.create
+import platform.posix.malloc
+import platform.posix.memcpy
+
+/**
+ * Every run packed by [RunBatchCodec] into one read-only NSData, which Swift reads in
+ * place (PackedRuns.swift) instead of bridging an NSArray of run objects.
+ */
+fun JsonRunStore.getAllPacked(): NSData = RunBatchCodec.encode(getAll()).toPackedNSData()
+
+/**
+ * Runs started at or after [sinceMs], packed like [getAllPacked].
+ */
+fun JsonRunStore.listSincePacked(sinceMs: Long): NSData = RunBatchCodec.encode(listSince(sinceMs)).toPackedNSData()
+
+/**
+ * Personal bests over a buffer from [getAllPacked] or [listSincePacked], without unpacking runs.
+ * @throws IllegalArgumentException if [runs] is not a run batch
+ */
+@Throws(IllegalArgumentException::class)
+fun calculateBestsPacked(runs: NSData, sinceMs: Long = 0L): BestsDTO =
+    calculateBestsPacked(RunBatch(runs.toByteArray()), sinceMs)
+
+// One copy into malloc'd memory that the NSData owns and frees, so Swift holds no Kotlin object.
+// convert() because size_t and NSUInteger are 32-bit on arm64_32 watches and 64-bit elsewhere
+@OptIn(ExperimentalForeignApi::class, BetaInteropApi::class)
+private fun ByteArray.toPackedNSData(): NSData {
+    val buffer = malloc(size.convert()) ?: throw IllegalStateException("Cannot allocate $size bytes for packed runs")
+    usePinned { pinned -> memcpy(buffer, pinned.addressOf(0), size.convert()) }
+    return NSData.create(bytesNoCopy = buffer, length = size.convert(), freeWhenDone = true)
+}
+
+@OptIn(ExperimentalForeignApi::class)
+private fun NSData.toByteArray(): ByteArray {
+    val out = ByteArray(length.toInt())
+    if (out.isNotEmpty()) out.usePinned { pinned -> memcpy(pinned.addressOf(0), bytes, length) }
+    return out
+}
@@ -0,0 +1,94 @@
+package com.mebeatme.shared.persistence
+
+import kotlinx.cinterop.BetaInteropApi
+import kotlinx.cinterop.ExperimentalForeignApi
+import kotlinx.cinterop.addressOf
+import kotlinx.cinterop.usePinned
+import platform.Foundation.NSData
+import platform.Foundation.NSFileHandle
+import platform.Foundation.NSFileManager
+import platform.Foundation.create
+import platform.Foundation.dataWithContentsOfFile
+import platform.Foundation.fileHandleForUpdatingAtPath
+import platform.Foundation.writeToFile
+import platform.posix.memcpy
+
+@OptIn(ExperimentalForeignApi::class, BetaInteropApi::class)
+actual class RunLogFile actual constructor(private val path: String) {
+    
+    private var handle: NSFileHandle? = null
+    
+    private var lastRecovery = RunLogRecovery()
+    
+    actual val recovery: RunLogRecovery get() = lastRecovery
+    
+    actual fun open(): List<RunLogRecord> {
+        lastRecovery = RunLogRecovery()
+        val bytes = NSData.dataWithContentsOfFile(path)?.toByteArray() ?: ByteArray(0)
+        if (bytes.isEmpty()) {
+            if (!NSFileManager.defaultManager.createFileAtPath(path, RunLogCodec.MAGIC.toNSData(), null)) {
+                throw IllegalStateException("Cannot create run log $path")
+            }
+        }
+        val decoded = if (bytes.isEmpty()) RunLogCodec.Decoded(emptyList(), RunLogCodec.MAGIC.size) else RunLogCodec.decode(bytes)
+        if (decoded.damagedRecords > 0) {
+            // Dropped records may be deletes; keep the log as found before the rewrite loses them for good
+            val aside = corruptCopyPath(path) { NSFileManager.defaultManager.fileExistsAtPath(it) }
+            if (!bytes.toNSData().writeToFile(aside, atomically = true)) {
+                throw IllegalStateException("Cannot keep damaged run log $path aside")
+            }
+            lastRecovery = RunLogRecovery(decoded.damagedRecords, decoded.damagedBytes.toLong(), keptAside = listOf(aside))
+        } else if (!decoded.needsRewrite && decoded.validLength < bytes.size) {
+            lastRecovery = RunLogRecovery(tornBytes = (bytes.size - decoded.validLength).toLong())
+        }
+        if (decoded.needsRewrite) {
+            // Written to a temp file and renamed over the log
+            val rewritten = RunLogCodec.MAGIC + RunLogCodec.encodeAll(decoded.records)
+            if (!rewritten.toNSData().writeToFile(path, atomically = true)) {
+                throw IllegalStateException("Cannot rewrite run log $path")
+            }
+        }
+        val opened = NSFileHandle.fileHandleForUpdatingAtPath(path) ?: throw IllegalStateException("Cannot open run log $path")
+        if (!decoded.needsRewrite && decoded.validLength < bytes.size) {
+            opened.truncateFileAtOffset(decoded.validLength.toULong())
+            opened.synchronizeFile()
+        }
+        opened.seekToEndOfFile()
+        handle = opened
+        return decoded.records
+    }
+    
+    actual fun append(records: List<RunLogRecord>) {
+        if (records.isEmpty()) return
+        val target = handle ?: throw IllegalStateException("Run log $path is not open")
+        target.writeData(RunLogCodec.encodeAll(records).toNSData())
+        target.synchronizeFile()
+    }
+    
+    actual fun reset() {
+        close()
+        if (!RunLogCodec.MAGIC.toNSData().writeToFile(path, atomically = true)) {
+            throw IllegalStateException("Cannot reset run log $path")
+        }
+        val opened = NSFileHandle.fileHandleForUpdatingAtPath(path) ?: throw IllegalStateException("Cannot open run log $path")
+        opened.seekToEndOfFile()
+        handle = opened
+    }
+    
+    actual fun close() {
+        handle?.closeFile()
+        handle = null
+    }
+}
+
+@OptIn(ExperimentalForeignApi::class, BetaInteropApi::class)
+private fun ByteArray.toNSData(): NSData = usePinned { pinned ->
+    NSData.create(bytes = pinned.addressOf(0), length = size.toULong())
+}
+
+@OptIn(ExperimentalForeignApi::class)
+private fun NSData.toByteArray(): ByteArray {
+    val out = ByteArray(length.toInt())
+    if (out.isNotEmpty()) out.usePinned { pinned -> memcpy(pinned.addressOf(0), bytes, length) }
+    return out
+}
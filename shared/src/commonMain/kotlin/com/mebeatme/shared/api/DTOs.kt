@@ -18,7 +18,9 @@ data class RunDTO(
     val avgPaceSecPerKm: Double,
     val avgHr: Int? = null,
     val ppi: Double? = null,
-    val notes: String? = null
+    val notes: String? = null,
+    val ppiCurveVersion: String? = null, // ScoringModel.version that produced ppi
+    val bestEffortsSec: Map<String, Int> = emptyMap() // fastest segment per BestEffortsEngine distance, set at import
 )
 
 @Serializable
@@ -30,6 +32,15 @@ data class BestsDTO(
     val highestPPILast90Days: Double? = null
 )
 
+@Serializable
+data class PercentilesResponse(
+    val bucket: String,
+    val metric: String,
+    val count: Long,
+    val quantiles: Map<String, Double?>, // quantile ("0.9") to value, null when the bucket is empty
+    val rank: Double? = null             // fraction of runs at or below the queried value
+)
+
 @Serializable
 data class SyncRunsResponse(
     val status: String,
@@ -0,0 +1,11 @@
+package com.mebeatme.shared.core
+
+/**
+ * Fixed-size array of longs with atomic per-cell reads and compare-and-set, all cells starting at 0.
+ * Doubles are stored as their raw bits so lock-free max-updates work on scores too.
+ */
+internal expect class AtomicLongCells(size: Int) {
+    val size: Int
+    operator fun get(index: Int): Long
+    fun compareAndSet(index: Int, expected: Long, newValue: Long): Boolean
+}
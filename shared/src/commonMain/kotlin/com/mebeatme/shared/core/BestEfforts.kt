@@ -0,0 +1,50 @@
+package com.mebeatme.shared.core
+
+import com.mebeatme.shared.model.RunSession
+import kotlin.math.roundToInt
+
+/**
+ * Fastest segment of each standard distance inside a run, found from its sample stream.
+ *
+ * With linear interpolation between samples, elapsed time over a fixed distance is
+ * piecewise linear in the segment start, so the fastest segment starts or ends on a
+ * sample. [compute] covers both cases with [sweepSpans], one pointer per target
+ * distance in each direction, which is O(n) per target with no inner search.
+ */
+object BestEffortsEngine {
+
+    /** Keys of RunDTO.bestEffortsSec and the distances they stand for. */
+    val STANDARD_DISTANCES: Map<String, Double> = linkedMapOf(
+        "1k" to 1000.0,
+        "5k" to 5000.0,
+        "10k" to 10000.0,
+        "half" to 21097.5,
+        "full" to 42195.0
+    )
+
+    /**
+     * Fastest time over each target distance.
+     * @param timesSec Sample times in seconds, non-decreasing
+     * @param distancesMeters Cumulative distance at each sample, same length as [timesSec]
+     * @param targetsMeters Segment lengths to search for
+     * @return Fastest time in seconds per target, NaN if the run never covers it
+     */
+    fun compute(timesSec: DoubleArray, distancesMeters: DoubleArray, targetsMeters: DoubleArray): DoubleArray {
+        require(timesSec.size == distancesMeters.size) { "timesSec and distancesMeters must have the same length" }
+        return sweepSpans(distancesMeters, timesSec, targetsMeters, maximize = false)
+    }
+
+    /**
+     * Fastest time per standard distance for a recorded run.
+     * Samples are prepared by [cumulativeSeries].
+     * @return Whole seconds keyed like [STANDARD_DISTANCES], only for distances the run covers
+     */
+    fun compute(session: RunSession): Map<String, Int> {
+        val (times, distances) = session.cumulativeSeries() ?: return emptyMap()
+        val names = STANDARD_DISTANCES.keys.toList()
+        val seconds = compute(times, distances, STANDARD_DISTANCES.values.toDoubleArray())
+        return names.indices
+            .filter { !seconds[it].isNaN() }
+            .associate { names[it] to seconds[it].roundToInt() }
+    }
+}
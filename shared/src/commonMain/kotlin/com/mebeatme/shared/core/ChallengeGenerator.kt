@@ -2,14 +2,17 @@ package com.mebeatme.shared.core
 
 import com.mebeatme.shared.model.ChallengeOption
 import com.mebeatme.shared.model.DistanceBucket
+import kotlin.math.roundToLong
 import kotlin.random.Random
 import kotlinx.datetime.Clock
 
 /**
  * Generates multiple-choice challenges to beat historical best performance
+ * @param paceEnvelope Merged pace curves; when set, target paces start from what the athlete has actually sustained
  */
 class ChallengeGenerator(
-    private val bucketManager: PerformanceBucketManager
+    private val bucketManager: PerformanceBucketManager,
+    private val paceEnvelope: PaceEnvelope? = null
 ) {
     
     /**
@@ -74,17 +77,16 @@ class ChallengeGenerator(
         val targetPPI = historicalBest + 5.0 // Small improvement
         
         val targetDistance = getRandomDistanceInBucket(bucket)
-        val targetPace = PurdyPointsCalculator.calculateRequiredPace(targetDistance, targetPPI)
-        val targetDuration = PurdyPointsCalculator.calculateRequiredTime(targetDistance, targetPPI)
+        val target = targetFor(targetDistance, targetPPI)
         
         return ChallengeOption(
             id = "short_fierce_${Clock.System.now().toEpochMilliseconds()}",
             title = "Short & Fierce",
-            description = "Hold ${PaceUtils.formatPace(targetPace)}/km for ${formatDuration(targetDuration)} to top your best ${bucket.label.lowercase()} equivalent",
-            targetPace = targetPace,
-            targetDuration = targetDuration,
+            description = "Hold ${PaceUtils.formatPace(target.pace)}/km for ${formatDuration(target.duration)} to top your best ${bucket.label.lowercase()} equivalent",
+            targetPace = target.pace,
+            targetDuration = target.duration,
             targetDistance = targetDistance,
-            expectedPpi = targetPPI,
+            expectedPpi = target.ppi,
             bucket = bucket
         )
     }
@@ -94,17 +96,16 @@ class ChallengeGenerator(
         val targetPPI = historicalBest + 3.0 // Moderate improvement
         
         val targetDistance = getRandomDistanceInBucket(bucket)
-        val targetPace = PurdyPointsCalculator.calculateRequiredPace(targetDistance, targetPPI)
-        val targetDuration = PurdyPointsCalculator.calculateRequiredTime(targetDistance, targetPPI)
+        val target = targetFor(targetDistance, targetPPI)
         
         return ChallengeOption(
             id = "tempo_boost_${Clock.System.now().toEpochMilliseconds()}",
             title = "Tempo Boost",
-            description = "Sustain ${PaceUtils.formatPace(targetPace)}/km for ${formatDuration(targetDuration)} to beat your tempo index",
-            targetPace = targetPace,
-            targetDuration = targetDuration,
+            description = "Sustain ${PaceUtils.formatPace(target.pace)}/km for ${formatDuration(target.duration)} to beat your tempo index",
+            targetPace = target.pace,
+            targetDuration = target.duration,
             targetDistance = targetDistance,
-            expectedPpi = targetPPI,
+            expectedPpi = target.ppi,
             bucket = bucket
         )
     }
@@ -114,17 +115,16 @@ class ChallengeGenerator(
         val targetPPI = historicalBest + 2.0 // Small improvement for longer distance
         
         val targetDistance = getRandomDistanceInBucket(bucket)
-        val targetPace = PurdyPointsCalculator.calculateRequiredPace(targetDistance, targetPPI)
-        val targetDuration = PurdyPointsCalculator.calculateRequiredTime(targetDistance, targetPPI)
+        val target = targetFor(targetDistance, targetPPI)
         
         return ChallengeOption(
             id = "ease_into_it_${Clock.System.now().toEpochMilliseconds()}",
             title = "Ease Into It",
-            description = "Cruise at ${PaceUtils.formatPace(targetPace)}/km for ${formatDuration(targetDuration)} and still crack your long-run PPI",
-            targetPace = targetPace,
-            targetDuration = targetDuration,
+            description = "Cruise at ${PaceUtils.formatPace(target.pace)}/km for ${formatDuration(target.duration)} and still crack your long-run PPI",
+            targetPace = target.pace,
+            targetDuration = target.duration,
             targetDistance = targetDistance,
-            expectedPpi = targetPPI,
+            expectedPpi = target.ppi,
             bucket = bucket
         )
     }
@@ -135,17 +135,16 @@ class ChallengeGenerator(
         val targetPPI = historicalBest + Random.nextDouble(1.0, 8.0) // Random improvement
         
         val targetDistance = getRandomDistanceInBucket(randomBucket)
-        val targetPace = PurdyPointsCalculator.calculateRequiredPace(targetDistance, targetPPI)
-        val targetDuration = PurdyPointsCalculator.calculateRequiredTime(targetDistance, targetPPI)
+        val target = targetFor(targetDistance, targetPPI)
         
         return ChallengeOption(
             id = "surprise_${Clock.System.now().toEpochMilliseconds()}",
             title = "Surprise Me",
             description = "Let MeBeatMe choose a playful but beatable run for you",
-            targetPace = targetPace,
-            targetDuration = targetDuration,
+            targetPace = target.pace,
+            targetDuration = target.duration,
             targetDistance = targetDistance,
-            expectedPpi = targetPPI,
+            expectedPpi = target.ppi,
             bucket = randomBucket
         )
     }
@@ -195,6 +194,24 @@ class ChallengeGenerator(
         )
     }
     
+    private data class Target(val pace: Double, val duration: Long, val ppi: Double)
+    
+    /**
+     * Pace, duration and PPI for a challenge over [distance].
+     * The PPI target sets the duration; if the athlete has sustained a pace for that
+     * long, the target moves just ahead of that pace and the PPI follows from it.
+     */
+    private fun targetFor(distance: Double, targetPPI: Double): Target {
+        val ppiDuration = PurdyPointsCalculator.calculateRequiredTime(distance, targetPPI)
+        val ppiTarget = Target(PurdyPointsCalculator.calculateRequiredPace(distance, targetPPI), ppiDuration, targetPPI)
+        val sustained = paceEnvelope?.sustainedPaceSecPerKm(ppiDuration.toDouble()) ?: return ppiTarget
+        val pace = sustained * (1 - SUSTAINED_IMPROVEMENT)
+        val duration = (pace * distance / 1000.0).roundToLong()
+        // calculatePPI throws on a zero duration, which a degenerate envelope pace can round to
+        if (duration <= 0) return ppiTarget
+        return Target(pace, duration, PurdyPointsCalculator.calculatePPI(distance, duration))
+    }
+    
     private fun getRandomDistanceInBucket(bucket: DistanceBucket): Double {
         val minKm = bucket.minKm
         val maxKm = bucket.maxKm
@@ -211,4 +228,9 @@ class ChallengeGenerator(
             "${remainingSeconds}s"
         }
     }
+    
+    companion object {
+        /** Fraction by which a sustained-pace target beats the athlete's best for that duration */
+        const val SUSTAINED_IMPROVEMENT = 0.01
+    }
 }
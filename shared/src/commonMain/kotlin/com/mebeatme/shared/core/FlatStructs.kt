@@ -0,0 +1,206 @@
+package com.mebeatme.shared.core
+
+import com.mebeatme.shared.model.BestsDTO
+import com.mebeatme.shared.model.DistanceBucket
+import com.mebeatme.shared.model.Score
+import com.mebeatme.shared.persistence.BestsBand
+import com.mebeatme.shared.persistence.RunBatchCodec
+import com.mebeatme.shared.service.MeBeatMeService
+import com.mebeatme.shared.service.PaceZone
+import com.mebeatme.shared.service.RealTimeFeedback
+
+/*
+ * Plain C layouts of bests, scores and live feedback, declared for Swift, JNI and C in
+ * shared/include/mebeatme_flat.h. Optional fields are flagged in a presence bitmask
+ * rather than boxed, and absent fields are zero.
+ *
+ * Platform writers fill a struct the caller owns (a CPointer on iOS and watchOS, a
+ * direct ByteBuffer on the JVM) through the inline write functions here, which hand
+ * each field over as a primitive so a refresh allocates nothing. The ByteArray
+ * encode/decode pairs use the same offsets in little-endian order, the byte order
+ * of every target, and serve tests and callers that want a copy.
+ */
+
+/** Layout of MBMBests. */
+object FlatBests {
+    const val SIZE = 32
+
+    const val OFFSET_PRESENT = 0
+    const val OFFSET_BEST_SECONDS = 4 // i32 per band, BestsBand.STANDARD order
+    const val OFFSET_HIGHEST_PPI = 24
+
+    /** Presence bit of the band at this index of [BestsBand.STANDARD]. */
+    fun hasBest(band: Int): Int = 1 shl band
+
+    const val HAS_HIGHEST_PPI = 1 shl 4
+
+    /**
+     * Write one record field by field.
+     * @param bestSeconds Best time of a [BestsBand.STANDARD] band by index, or -1 if none
+     * @param highestPpi Highest PPI of the last 90 days, or NaN if none
+     */
+    internal inline fun write(
+        bestSeconds: (band: Int) -> Int,
+        highestPpi: Double,
+        putInt: (at: Int, value: Int) -> Unit,
+        putDouble: (at: Int, value: Double) -> Unit
+    ) {
+        var present = 0
+        for (band in BestsBand.STANDARD.indices) {
+            val seconds = bestSeconds(band)
+            if (seconds >= 0) present = present or hasBest(band)
+            putInt(OFFSET_BEST_SECONDS + 4 * band, seconds.coerceAtLeast(0))
+        }
+        if (!highestPpi.isNaN()) present = present or HAS_HIGHEST_PPI
+        putDouble(OFFSET_HIGHEST_PPI, if (highestPpi.isNaN()) 0.0 else highestPpi)
+        putInt(OFFSET_PRESENT, present)
+    }
+
+    fun encode(bests: BestsDTO): ByteArray {
+        val seconds = intArrayOf(
+            bests.best5kSec ?: -1,
+            bests.best10kSec ?: -1,
+            bests.bestHalfSec ?: -1,
+            bests.bestFullSec ?: -1
+        )
+        val out = ByteArray(SIZE)
+        write(
+            bestSeconds = { seconds[it] },
+            highestPpi = bests.highestPPILast90Days ?: Double.NaN,
+            putInt = { at, value -> RunBatchCodec.writeInt(out, at, value) },
+            putDouble = { at, value -> RunBatchCodec.writeLong(out, at, value.toRawBits()) }
+        )
+        return out
+    }
+
+    fun decode(bytes: ByteArray, at: Int = 0): BestsDTO {
+        val present = RunBatchCodec.readInt(bytes, at + OFFSET_PRESENT)
+        fun best(band: Int): Int? =
+            if (present and hasBest(band) != 0) RunBatchCodec.readInt(bytes, at + OFFSET_BEST_SECONDS + 4 * band) else null
+        return BestsDTO(
+            best5kSec = best(0),
+            best10kSec = best(1),
+            bestHalfSec = best(2),
+            bestFullSec = best(3),
+            highestPPILast90Days = if (present and HAS_HIGHEST_PPI != 0) {
+                Double.fromBits(RunBatchCodec.readLong(bytes, at + OFFSET_HIGHEST_PPI))
+            } else {
+                null
+            }
+        )
+    }
+}
+
+/** Layout of MBMScore. */
+object FlatScore {
+    const val SIZE = 40
+
+    const val OFFSET_PRESENT = 0
+    const val OFFSET_BUCKET = 4 // DistanceBucket ordinal
+    const val OFFSET_PPI = 8
+    const val OFFSET_TARGET_PACE = 16
+    const val OFFSET_TARGET_DURATION = 24
+    const val OFFSET_ACHIEVED = 32
+
+    const val HAS_TARGET_PACE = 1 shl 0
+    const val HAS_TARGET_DURATION = 1 shl 1
+
+    internal inline fun write(
+        score: Score,
+        putInt: (at: Int, value: Int) -> Unit,
+        putLong: (at: Int, value: Long) -> Unit,
+        putDouble: (at: Int, value: Double) -> Unit
+    ) {
+        var present = 0
+        if (score.targetPace != null) present = present or HAS_TARGET_PACE
+        if (score.targetDuration != null) present = present or HAS_TARGET_DURATION
+        putInt(OFFSET_PRESENT, present)
+        putInt(OFFSET_BUCKET, score.bucket.ordinal)
+        putDouble(OFFSET_PPI, score.ppi)
+        putDouble(OFFSET_TARGET_PACE, score.targetPace ?: 0.0)
+        putLong(OFFSET_TARGET_DURATION, score.targetDuration ?: 0L)
+        putInt(OFFSET_ACHIEVED, if (score.achieved) 1 else 0)
+        putInt(OFFSET_ACHIEVED + 4, 0)
+    }
+
+    fun encode(score: Score): ByteArray {
+        val out = ByteArray(SIZE)
+        write(
+            score,
+            putInt = { at, value -> RunBatchCodec.writeInt(out, at, value) },
+            putLong = { at, value -> RunBatchCodec.writeLong(out, at, value) },
+            putDouble = { at, value -> RunBatchCodec.writeLong(out, at, value.toRawBits()) }
+        )
+        return out
+    }
+
+    fun decode(bytes: ByteArray, at: Int = 0): Score {
+        val present = RunBatchCodec.readInt(bytes, at + OFFSET_PRESENT)
+        return Score(
+            ppi = Double.fromBits(RunBatchCodec.readLong(bytes, at + OFFSET_PPI)),
+            bucket = DistanceBucket.entries[RunBatchCodec.readInt(bytes, at + OFFSET_BUCKET)],
+            targetPace = if (present and HAS_TARGET_PACE != 0) {
+                Double.fromBits(RunBatchCodec.readLong(bytes, at + OFFSET_TARGET_PACE))
+            } else {
+                null
+            },
+            targetDuration = if (present and HAS_TARGET_DURATION != 0) {
+                RunBatchCodec.readLong(bytes, at + OFFSET_TARGET_DURATION)
+            } else {
+                null
+            },
+            achieved = RunBatchCodec.readInt(bytes, at + OFFSET_ACHIEVED) != 0
+        )
+    }
+}
+
+/** Layout of MBMFeedback; every field is always set. */
+object FlatFeedback {
+    const val SIZE = 48
+
+    const val OFFSET_CURRENT_PACE = 0
+    const val OFFSET_TARGET_PACE = 8
+    const val OFFSET_PACE_DIFFERENCE = 16
+    const val OFFSET_PROGRESS = 24
+    const val OFFSET_CURRENT_PPI = 32
+    const val OFFSET_PACE_ZONE = 40 // PaceZone ordinal
+
+    /**
+     * Write the service's live feedback field by field.
+     * @return false, leaving the record untouched, if no run is in progress
+     */
+    internal inline fun write(
+        service: MeBeatMeService,
+        precision: ScoringPrecision,
+        putInt: (at: Int, value: Int) -> Unit,
+        putDouble: (at: Int, value: Double) -> Unit
+    ): Boolean = service.readRealTimeFeedback(precision) { currentPace, targetPace, paceDifference, paceZone, progress, currentPpi ->
+        putDouble(OFFSET_CURRENT_PACE, currentPace)
+        putDouble(OFFSET_TARGET_PACE, targetPace)
+        putDouble(OFFSET_PACE_DIFFERENCE, paceDifference)
+        putDouble(OFFSET_PROGRESS, progress)
+        putDouble(OFFSET_CURRENT_PPI, currentPpi)
+        putInt(OFFSET_PACE_ZONE, paceZone.ordinal)
+        putInt(OFFSET_PACE_ZONE + 4, 0)
+    }
+
+    fun encode(feedback: RealTimeFeedback): ByteArray {
+        val out = ByteArray(SIZE)
+        RunBatchCodec.writeLong(out, OFFSET_CURRENT_PACE, feedback.currentPace.toRawBits())
+        RunBatchCodec.writeLong(out, OFFSET_TARGET_PACE, feedback.targetPace.toRawBits())
+        RunBatchCodec.writeLong(out, OFFSET_PACE_DIFFERENCE, feedback.paceDifference.toRawBits())
+        RunBatchCodec.writeLong(out, OFFSET_PROGRESS, feedback.progressPercentage.toRawBits())
+        RunBatchCodec.writeLong(out, OFFSET_CURRENT_PPI, feedback.currentPpi.toRawBits())
+        RunBatchCodec.writeInt(out, OFFSET_PACE_ZONE, feedback.paceZone.ordinal)
+        return out
+    }
+
+    fun decode(bytes: ByteArray, at: Int = 0): RealTimeFeedback = RealTimeFeedback(
+        currentPace = Double.fromBits(RunBatchCodec.readLong(bytes, at + OFFSET_CURRENT_PACE)),
+        targetPace = Double.fromBits(RunBatchCodec.readLong(bytes, at + OFFSET_TARGET_PACE)),
+        paceDifference = Double.fromBits(RunBatchCodec.readLong(bytes, at + OFFSET_PACE_DIFFERENCE)),
+        paceZone = PaceZone.entries[RunBatchCodec.readInt(bytes, at + OFFSET_PACE_ZONE)],
+        progressPercentage = Double.fromBits(RunBatchCodec.readLong(bytes, at + OFFSET_PROGRESS)),
+        currentPpi = Double.fromBits(RunBatchCodec.readLong(bytes, at + OFFSET_CURRENT_PPI))
+    )
+}
@@ -0,0 +1,129 @@
+package com.mebeatme.shared.core
+
+import com.mebeatme.shared.model.RunDTO
+import com.mebeatme.shared.model.RunSession
+import kotlin.math.ln
+import kotlin.math.pow
+import kotlin.math.roundToInt
+
+/**
+ * Mean-maximal pace-duration curve: the farthest distance covered in any window of
+ * each duration on a log-spaced grid, found from a run's sample stream.
+ *
+ * The grid runs from 10 s to 20480 s (about 5.7 h) in quarter-octave steps, so a curve
+ * is 45 values. Each grid point is one O(n) two-pointer pass of [sweepSpans], so a run of
+ * n samples costs O(45·n), linear for the fixed grid, instead of the O(n²) of trying
+ * every window.
+ */
+object PaceCurveEngine {
+
+    /** Window lengths of the curve, 10 s × 2^(k/4) up to 20480 s. Index i of every curve refers to DURATIONS_SEC[i]. */
+    val DURATIONS_SEC: IntArray = IntArray(45) { (10 * 2.0.pow(it / 4.0)).roundToInt() }
+
+    /**
+     * Farthest distance over each window length.
+     * @param timesSec Sample times in seconds, non-decreasing
+     * @param distancesMeters Cumulative distance at each sample, same length as [timesSec]
+     * @param durationsSec Window lengths to search for
+     * @return Meters per duration, NaN if the run is shorter than it
+     */
+    fun compute(timesSec: DoubleArray, distancesMeters: DoubleArray, durationsSec: DoubleArray): DoubleArray {
+        require(timesSec.size == distancesMeters.size) { "timesSec and distancesMeters must have the same length" }
+        return sweepSpans(timesSec, distancesMeters, durationsSec, maximize = true)
+    }
+
+    /**
+     * Curve of a recorded run on [DURATIONS_SEC]. Samples are prepared by [cumulativeSeries].
+     * @return Meters per grid duration, truncated at the first duration longer than the run
+     */
+    fun compute(session: RunSession): List<Double> {
+        val (times, distances) = session.cumulativeSeries() ?: return emptyList()
+        val meters = compute(times, distances, DoubleArray(DURATIONS_SEC.size) { DURATIONS_SEC[it].toDouble() })
+        return meters.takeWhile { !it.isNaN() }
+    }
+}
+
+/**
+ * History-wide envelope of per-run pace curves: for each grid duration, the farthest
+ * distance any run covered, and so the fastest pace the athlete has sustained for that long.
+ *
+ * Merging a run is O(grid) element-wise max. Removing a run only rescans the stored
+ * curves at the grid points that run held, so deletes of non-record runs are O(grid) too.
+ * Not synchronized; the owner guards it with its own lock.
+ */
+class PaceEnvelope {
+
+    private val curves = HashMap<String, List<Double>>()
+    private val bestMeters = DoubleArray(PaceCurveEngine.DURATIONS_SEC.size)
+    private val holders = arrayOfNulls<String>(PaceCurveEngine.DURATIONS_SEC.size)
+
+    /**
+     * Merge a run's curve, replacing any earlier curve stored under the same id.
+     * @param metersByDuration Curve from [PaceCurveEngine.compute], indexed like DURATIONS_SEC
+     */
+    fun merge(id: String, metersByDuration: List<Double>) {
+        remove(id)
+        if (metersByDuration.isEmpty()) return
+        curves[id] = metersByDuration
+        for (i in metersByDuration.indices) {
+            if (i >= bestMeters.size) break
+            if (metersByDuration[i] > bestMeters[i]) {
+                bestMeters[i] = metersByDuration[i]
+                holders[i] = id
+            }
+        }
+    }
+
+    /**
+     * Remove a run's curve.
+     * @return true if the run had one
+     */
+    fun remove(id: String): Boolean {
+        if (curves.remove(id) == null) return false
+        for (i in holders.indices) {
+            if (holders[i] != id) continue
+            bestMeters[i] = 0.0
+            holders[i] = null
+            for ((otherId, curve) in curves) {
+                if (i < curve.size && curve[i] > bestMeters[i]) {
+                    bestMeters[i] = curve[i]
+                    holders[i] = otherId
+                }
+            }
+        }
+        return true
+    }
+
+    fun clear() {
+        curves.clear()
+        bestMeters.fill(0.0)
+        holders.fill(null)
+    }
+
+    /**
+     * Farthest distance covered within [durationSec], read between grid points on a log-duration scale.
+     * @return Meters, or null outside the grid or where no run is that long
+     */
+    fun maxDistanceMeters(durationSec: Double): Double? {
+        val grid = PaceCurveEngine.DURATIONS_SEC
+        if (durationSec < grid.first() || durationSec > grid.last()) return null
+        var upper = 0
+        while (grid[upper] < durationSec) upper++
+        val high = bestMeters[upper].takeIf { holders[upper] != null } ?: return null
+        if (grid[upper].toDouble() == durationSec) return high
+        val low = bestMeters[upper - 1]
+        val fraction = ln(durationSec / grid[upper - 1]) / ln(grid[upper].toDouble() / grid[upper - 1])
+        return low + fraction * (high - low)
+    }
+
+    /**
+     * Fastest average pace the athlete has held for [durationSec].
+     * @return Seconds per kilometre, or null if no run is that long
+     */
+    fun sustainedPaceSecPerKm(durationSec: Double): Double? {
+        val meters = maxDistanceMeters(durationSec)?.takeIf { it > 0.0 } ?: return null
+        return durationSec / (meters / 1000.0)
+    }
+}
+
+internal fun PaceEnvelope.merge(run: RunDTO) = merge(run.id, run.maxDistanceByDurationM)
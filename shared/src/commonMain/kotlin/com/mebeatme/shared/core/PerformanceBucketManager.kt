@@ -6,38 +6,53 @@ import com.mebeatme.shared.model.Score
 
 /**
  * Manages comparable performance bins and historical best tracking
+ *
+ * Bests live in one atomic cell per [DistanceBucket] ordinal, holding the PPI's raw
+ * bits (0 = no data yet). Updates are compare-and-swap max loops, so concurrent
+ * imports never block each other and a lower PPI never overwrites a higher one.
+ * Reads load each cell once and never wait on a writer.
  */
 class PerformanceBucketManager {
     
-    private val historicalBests = mutableMapOf<DistanceBucket, Double>()
+    private val buckets = DistanceBucket.values()
+    private val historicalBests = AtomicLongCells(buckets.size)
     
     /**
      * Update historical best PPI for a given bucket
+     * @throws IllegalArgumentException if the session has no distance or duration
      */
     fun updateHistoricalBest(session: RunSession): Double {
         val bucket = getBucketForDistance(session.distance)
         val ppi = PurdyPointsCalculator.calculatePPI(session.distance, session.duration)
-        
-        val currentBest = historicalBests[bucket] ?: 0.0
-        if (ppi > currentBest) {
-            historicalBests[bucket] = ppi
-        }
-        
+        offerBest(bucket, ppi)
         return ppi
     }
     
+    /**
+     * Raise a bucket's best to [ppi] if it is higher, retrying if another thread got there first
+     * @return true if [ppi] became the best
+     */
+    internal fun offerBest(bucket: DistanceBucket, ppi: Double): Boolean {
+        val index = bucket.ordinal
+        while (true) {
+            val currentBits = historicalBests[index]
+            if (!(ppi > Double.fromBits(currentBits))) return false
+            if (historicalBests.compareAndSet(index, currentBits, ppi.toRawBits())) return true
+        }
+    }
+    
     /**
      * Get historical best PPI for a bucket
      */
     fun getHistoricalBest(bucket: DistanceBucket): Double {
-        return historicalBests[bucket] ?: 0.0
+        return Double.fromBits(historicalBests[bucket.ordinal])
     }
     
     /**
      * Get all historical bests
      */
     fun getAllHistoricalBests(): Map<DistanceBucket, Double> {
-        return historicalBests.toMap()
+        return getBucketStats().values.filter { it.hasData }.associate { it.bucket to it.historicalBest }
     }
     
     /**
@@ -50,13 +65,15 @@ class PerformanceBucketManager {
     
     /**
      * Get bucket statistics
+     * Wait-free: each bucket is read exactly once, so a stat never mixes two updates.
      */
     fun getBucketStats(): Map<DistanceBucket, BucketStats> {
-        return DistanceBucket.values().associateWith { bucket ->
+        return buckets.associateWith { bucket ->
+            val bits = historicalBests[bucket.ordinal]
             BucketStats(
                 bucket = bucket,
-                historicalBest = getHistoricalBest(bucket),
-                hasData = historicalBests.containsKey(bucket)
+                historicalBest = Double.fromBits(bits),
+                hasData = bits != 0L
             )
         }
     }
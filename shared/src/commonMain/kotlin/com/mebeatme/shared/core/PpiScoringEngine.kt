@@ -0,0 +1,483 @@
+package com.mebeatme.shared.core
+
+import kotlin.math.exp
+import kotlin.math.ln
+import kotlin.math.log2
+import kotlin.math.pow
+import kotlin.math.roundToInt
+
+/**
+ * Scoring curves known to the shared engine.
+ * Every curve has the form PPI = 1000 × (baseline / duration)^exponent and differs
+ * only in its anchor set, baseline lookup, exponent and clamps.
+ *
+ * purdyScore, PurdyCalculator, PurdyPointsCalculator and the service all score with
+ * [PpiScoringEngine.defaultModel]. The other models are the formulas those entry points
+ * used before; they stay selectable so runs stored under their versions can be rescored.
+ */
+enum class ScoringModel(val version: String) {
+    /** Cubic over nearest anchor, the default */
+    PURDY_CUBIC("purdy.cubic.v1"),
+    /** Power -2.0 over log-log interpolated anchors (formerly PurdyCalculator.purdyScore) */
+    PURDY_INTERPOLATED("purdy.interpolated.v1"),
+    /** Power 1.07 over nearest anchor (formerly PurdyPointsCalculator.calculatePPI) */
+    PURDY_POINTS("purdy.points.v1")
+}
+
+/**
+ * One scoring curve as a fixed policy: anchor set, exponent, clamps and a
+ * duration correction hook ([correctedScore]). Each implementation is an object whose batch loop
+ * is instantiated from [scoreRows] with its own row function, so a batch pays
+ * for curve selection once and the hot loop has no per-row dispatch.
+ */
+interface PpiCurve {
+    val model: ScoringModel
+
+    /**
+     * Score one run.
+     * @param distanceMeters Distance in meters
+     * @param durationSec Duration in seconds
+     * @return PPI, or NaN if distance or duration is not positive
+     */
+    fun score(distanceMeters: Double, durationSec: Double): Double
+
+    /**
+     * Score one run after applying a duration adjustment (elevation, temperature, ...).
+     * @param adjustmentSec Seconds added to the duration before scoring
+     */
+    fun correctedScore(distanceMeters: Double, durationSec: Double, adjustmentSec: Double): Double =
+        score(distanceMeters, durationSec + adjustmentSec)
+
+    /**
+     * Score many runs over struct-of-arrays input.
+     * @param distancesMeters Distances in meters
+     * @param durationsSec Durations in seconds, same length as [distancesMeters]
+     * @param out Destination array (may be reused across calls)
+     * @return [out], filled with PPIs (NaN for invalid rows)
+     */
+    fun scoreBatch(
+        distancesMeters: DoubleArray,
+        durationsSec: DoubleArray,
+        out: DoubleArray = DoubleArray(distancesMeters.size)
+    ): DoubleArray
+
+    /**
+     * Duration needed to reach a target PPI, from the closed-form inverse of the curve.
+     * @param distanceMeters Distance in meters
+     * @param targetPpi Target PPI
+     * @return Duration in seconds, or NaN if distance or target is not positive
+     */
+    fun requiredTime(distanceMeters: Double, targetPpi: Double): Double
+
+    /**
+     * Float32 variant of [score], within [ScoringPrecision.FLOAT32] of the double result.
+     * @return PPI, or NaN if distance or duration is not positive
+     */
+    fun scoreFloat(distanceMeters: Float, durationSec: Float): Float
+
+    /**
+     * Integer variant of [score], within [ScoringPrecision.FIXED_Q16] of the double result.
+     * @param distanceMeters Whole meters
+     * @param durationSec Whole seconds
+     * @return PPI in Q16.16, or [FixedQ16.INVALID] if distance or duration is not positive
+     */
+    fun scoreFixed(distanceMeters: Int, durationSec: Int): Int
+
+    /**
+     * Float32 variant of [requiredTime].
+     * @return Duration in seconds, or NaN if distance or target is not positive
+     */
+    fun requiredTimeFloat(distanceMeters: Float, targetPpi: Float): Float
+
+    /**
+     * Integer variant of [requiredTime].
+     * @param targetPpiQ16 Target PPI in Q16.16
+     * @return Duration in Q16.16 seconds, or [FixedQ16.INVALID] if distance or target is not positive
+     */
+    fun requiredTimeFixed(distanceMeters: Int, targetPpiQ16: Int): Long
+}
+
+/**
+ * Cubic relationship P = 1000 × (T₀/T)³ over the nearest of ten anchors.
+ */
+object PurdyCubicCurve : PpiCurve {
+    override val model = ScoringModel.PURDY_CUBIC
+
+    private val anchors = NearestAnchors(
+        distancesMeters = doubleArrayOf(100.0, 200.0, 400.0, 800.0, 1500.0, 3000.0, 5000.0, 10000.0, 21097.5, 42195.0),
+        timesSec = doubleArrayOf(10.0, 20.0, 45.0, 105.0, 210.0, 450.0, 780.0, 1620.0, 3540.0, 7260.0)
+    )
+
+    override fun score(distanceMeters: Double, durationSec: Double): Double =
+        scoreRow(distanceMeters, durationSec)
+
+    override fun scoreBatch(distancesMeters: DoubleArray, durationsSec: DoubleArray, out: DoubleArray): DoubleArray =
+        scoreRows(distancesMeters, durationsSec, out) { d, t -> scoreRow(d, t) }
+
+    override fun requiredTime(distanceMeters: Double, targetPpi: Double): Double {
+        if (distanceMeters <= 0 || targetPpi <= 0) return Double.NaN
+        return anchors.baselineTime(distanceMeters) / (targetPpi / 1000.0).pow(1.0 / 3.0)
+    }
+
+    override fun scoreFloat(distanceMeters: Float, durationSec: Float): Float {
+        if (distanceMeters <= 0f || durationSec <= 0f) return Float.NaN
+        val ratio = anchors.baselineTimeFloat(distanceMeters) / durationSec
+        return (1000f * (ratio * ratio * ratio)).coerceAtLeast(0f)
+    }
+
+    override fun scoreFixed(distanceMeters: Int, durationSec: Int): Int {
+        if (distanceMeters <= 0 || durationSec <= 0) return FixedQ16.INVALID
+        // No upper clamp in double precision; Q16 saturates near 32768 points
+        return FixedQ16.powerLawScore(anchors.log2BaselineQ16(distanceMeters), durationSec, EXPONENT_Q16, 0, Int.MAX_VALUE)
+    }
+
+    override fun requiredTimeFloat(distanceMeters: Float, targetPpi: Float): Float {
+        if (distanceMeters <= 0f || targetPpi <= 0f) return Float.NaN
+        return anchors.baselineTimeFloat(distanceMeters) / (targetPpi / 1000f).pow(1f / 3f)
+    }
+
+    override fun requiredTimeFixed(distanceMeters: Int, targetPpiQ16: Int): Long {
+        if (distanceMeters <= 0 || targetPpiQ16 <= 0) return FixedQ16.INVALID.toLong()
+        return FixedQ16.powerLawTime(anchors.log2BaselineQ16(distanceMeters), targetPpiQ16, INVERSE_EXPONENT_Q16)
+    }
+
+    private fun scoreRow(distanceMeters: Double, durationSec: Double): Double {
+        if (distanceMeters <= 0 || durationSec <= 0) return Double.NaN
+        val ratio = anchors.baselineTime(distanceMeters) / durationSec
+        return (1000.0 * (ratio * ratio * ratio)).coerceAtLeast(0.0)
+    }
+
+    private val EXPONENT_Q16 = FixedQ16.fromDouble(3.0)
+    private val INVERSE_EXPONENT_Q16 = FixedQ16.fromDouble(1.0 / 3.0)
+}
+
+/**
+ * PPI = 1000 × (T / T₀)^-2 over log-log interpolated elite anchors, clamped to 100-2000.
+ */
+object PurdyInterpolatedCurve : PpiCurve {
+    override val model = ScoringModel.PURDY_INTERPOLATED
+
+    private val anchors = LogLogAnchors(
+        distancesMeters = doubleArrayOf(1500.0, 5000.0, 10000.0, 21097.0, 42195.0),
+        timesSec = doubleArrayOf(210.0, 755.0, 1571.0, 3540.0, 7460.0)
+    )
+
+    override fun score(distanceMeters: Double, durationSec: Double): Double =
+        scoreRow(distanceMeters, durationSec)
+
+    override fun scoreBatch(distancesMeters: DoubleArray, durationsSec: DoubleArray, out: DoubleArray): DoubleArray =
+        scoreRows(distancesMeters, durationsSec, out) { d, t -> scoreRow(d, t) }
+
+    override fun requiredTime(distanceMeters: Double, targetPpi: Double): Double {
+        if (distanceMeters <= 0 || targetPpi <= 0) return Double.NaN
+        return anchors.baselineTime(distanceMeters) / (targetPpi / 1000.0).pow(0.5)
+    }
+
+    /**
+     * Elite baseline time for a distance, interpolated in log-log space.
+     */
+    fun baselineTime(distanceMeters: Double): Double = anchors.baselineTime(distanceMeters)
+
+    override fun scoreFloat(distanceMeters: Float, durationSec: Float): Float {
+        if (distanceMeters <= 0f || durationSec <= 0f) return Float.NaN
+        val ratio = anchors.baselineTimeFloat(distanceMeters) / durationSec
+        return (1000f * ratio * ratio).coerceIn(100f, 2000f)
+    }
+
+    override fun scoreFixed(distanceMeters: Int, durationSec: Int): Int {
+        if (distanceMeters <= 0 || durationSec <= 0) return FixedQ16.INVALID
+        return FixedQ16.powerLawScore(anchors.log2BaselineQ16(distanceMeters), durationSec, EXPONENT_Q16, FLOOR_Q16, CEILING_Q16)
+    }
+
+    override fun requiredTimeFloat(distanceMeters: Float, targetPpi: Float): Float {
+        if (distanceMeters <= 0f || targetPpi <= 0f) return Float.NaN
+        return anchors.baselineTimeFloat(distanceMeters) / kotlin.math.sqrt(targetPpi / 1000f)
+    }
+
+    override fun requiredTimeFixed(distanceMeters: Int, targetPpiQ16: Int): Long {
+        if (distanceMeters <= 0 || targetPpiQ16 <= 0) return FixedQ16.INVALID.toLong()
+        return FixedQ16.powerLawTime(anchors.log2BaselineQ16(distanceMeters), targetPpiQ16, INVERSE_EXPONENT_Q16)
+    }
+
+    private fun scoreRow(distanceMeters: Double, durationSec: Double): Double {
+        if (distanceMeters <= 0 || durationSec <= 0) return Double.NaN
+        val ratio = anchors.baselineTime(distanceMeters) / durationSec // (actual / baseline)^-1
+        return (1000.0 * ratio * ratio).coerceIn(100.0, 2000.0)
+    }
+
+    private val EXPONENT_Q16 = FixedQ16.fromDouble(2.0)
+    private val INVERSE_EXPONENT_Q16 = FixedQ16.fromDouble(0.5)
+    private val FLOOR_Q16 = FixedQ16.fromDouble(100.0)
+    private val CEILING_Q16 = FixedQ16.fromDouble(2000.0)
+}
+
+/**
+ * Purdy Points model: PPI = 1000 × (T₀/T)^1.07 over the nearest of ten anchors, clamped to 0-2000.
+ */
+object PurdyPointsCurve : PpiCurve {
+    override val model = ScoringModel.PURDY_POINTS
+
+    private const val POWER_FACTOR = 1.07
+
+    private val anchors = NearestAnchors(
+        distancesMeters = doubleArrayOf(100.0, 200.0, 400.0, 800.0, 1500.0, 3000.0, 5000.0, 10000.0, 21097.5, 42195.0),
+        timesSec = doubleArrayOf(10.0, 20.0, 45.0, 105.0, 210.0, 450.0, 780.0, 1620.0, 3540.0, 7260.0)
+    )
+
+    override fun score(distanceMeters: Double, durationSec: Double): Double =
+        scoreRow(distanceMeters, durationSec)
+
+    override fun scoreBatch(distancesMeters: DoubleArray, durationsSec: DoubleArray, out: DoubleArray): DoubleArray =
+        scoreRows(distancesMeters, durationsSec, out) { d, t -> scoreRow(d, t) }
+
+    override fun requiredTime(distanceMeters: Double, targetPpi: Double): Double {
+        if (distanceMeters <= 0 || targetPpi <= 0) return Double.NaN
+        return anchors.baselineTime(distanceMeters) / (targetPpi / 1000.0).pow(1.0 / POWER_FACTOR)
+    }
+
+    override fun scoreFloat(distanceMeters: Float, durationSec: Float): Float {
+        if (distanceMeters <= 0f || durationSec <= 0f) return Float.NaN
+        val timeRatio = anchors.baselineTimeFloat(distanceMeters) / durationSec
+        return (1000f * timeRatio.pow(POWER_FACTOR.toFloat())).coerceIn(0f, 2000f)
+    }
+
+    override fun scoreFixed(distanceMeters: Int, durationSec: Int): Int {
+        if (distanceMeters <= 0 || durationSec <= 0) return FixedQ16.INVALID
+        return FixedQ16.powerLawScore(anchors.log2BaselineQ16(distanceMeters), durationSec, EXPONENT_Q16, 0, CEILING_Q16)
+    }
+
+    override fun requiredTimeFloat(distanceMeters: Float, targetPpi: Float): Float {
+        if (distanceMeters <= 0f || targetPpi <= 0f) return Float.NaN
+        return anchors.baselineTimeFloat(distanceMeters) / (targetPpi / 1000f).pow((1.0 / POWER_FACTOR).toFloat())
+    }
+
+    override fun requiredTimeFixed(distanceMeters: Int, targetPpiQ16: Int): Long {
+        if (distanceMeters <= 0 || targetPpiQ16 <= 0) return FixedQ16.INVALID.toLong()
+        return FixedQ16.powerLawTime(anchors.log2BaselineQ16(distanceMeters), targetPpiQ16, INVERSE_EXPONENT_Q16)
+    }
+
+    private fun scoreRow(distanceMeters: Double, durationSec: Double): Double {
+        if (distanceMeters <= 0 || durationSec <= 0) return Double.NaN
+        val timeRatio = anchors.baselineTime(distanceMeters) / durationSec
+        return (1000.0 * timeRatio.pow(POWER_FACTOR)).coerceIn(0.0, 2000.0)
+    }
+
+    private val EXPONENT_Q16 = FixedQ16.fromDouble(POWER_FACTOR)
+    private val INVERSE_EXPONENT_Q16 = FixedQ16.fromDouble(1.0 / POWER_FACTOR)
+    private val CEILING_Q16 = FixedQ16.fromDouble(2000.0)
+}
+
+/**
+ * Single runtime entry point for PPI scoring on iOS, watchOS, Android and the server.
+ * The curve is resolved once per call (once per batch for [scoreBatch]);
+ * everything after that runs inside the selected curve's own loop.
+ *
+ * Invalid input: single-run calls throw IllegalArgumentException, like [purdyScore];
+ * batch calls mark the row NaN instead, so one bad row does not fail the batch.
+ * [PpiCurve] methods are the unchecked row functions behind both.
+ *
+ * Not yet covered: core's `com.mebeatme.core.ppi.PpiEngine`, which the web and
+ * `platform/wearos` apps use, still scores with its own curves. `:core` builds for JS,
+ * which `:shared` does not, so neither module can call the other today.
+ */
+object PpiScoringEngine {
+
+    /**
+     * Curve used when callers do not ask for a specific model, and by every
+     * calculator in this module. This is the value iOS, watchOS, Android and the
+     * server store as RunDTO.ppi.
+     */
+    var defaultModel: ScoringModel = ScoringModel.PURDY_CUBIC
+
+    /**
+     * Resolve the curve implementation for a model.
+     */
+    fun curveFor(model: ScoringModel): PpiCurve = when (model) {
+        ScoringModel.PURDY_CUBIC -> PurdyCubicCurve
+        ScoringModel.PURDY_INTERPOLATED -> PurdyInterpolatedCurve
+        ScoringModel.PURDY_POINTS -> PurdyPointsCurve
+    }
+
+    /**
+     * Score one run with the given model.
+     * @param precision Arithmetic to score with; reduced modes round their inputs to Float or whole meters/seconds
+     * @return PPI
+     * @throws IllegalArgumentException if distance or duration is not positive (after rounding, for FIXED_Q16)
+     */
+    @Throws(IllegalArgumentException::class)
+    fun score(
+        distanceMeters: Double,
+        durationSec: Double,
+        model: ScoringModel = defaultModel,
+        precision: ScoringPrecision = ScoringPrecision.DOUBLE
+    ): Double {
+        val curve = curveFor(model)
+        val ppi = when (precision) {
+            ScoringPrecision.DOUBLE -> curve.score(distanceMeters, durationSec)
+            ScoringPrecision.FLOAT32 -> curve.scoreFloat(distanceMeters.toFloat(), durationSec.toFloat()).toDouble()
+            ScoringPrecision.FIXED_Q16 -> {
+                val ppi = curve.scoreFixed(distanceMeters.roundToInt(), durationSec.roundToInt())
+                if (ppi == FixedQ16.INVALID) Double.NaN else FixedQ16.toDouble(ppi)
+            }
+        }
+        // Every curve and precision returns NaN for non-positive input, so one check covers them all
+        require(!ppi.isNaN()) { "Distance and duration must be positive" }
+        return ppi
+    }
+
+    /**
+     * Score many runs with the given model. The model is resolved once for the whole batch.
+     * @return PPIs (NaN for invalid rows)
+     */
+    fun scoreBatch(
+        distancesMeters: DoubleArray,
+        durationsSec: DoubleArray,
+        model: ScoringModel = defaultModel
+    ): DoubleArray {
+        require(distancesMeters.size == durationsSec.size) { "distancesMeters and durationsSec must have the same length" }
+        return curveFor(model).scoreBatch(distancesMeters, durationsSec, DoubleArray(distancesMeters.size))
+    }
+
+    /**
+     * Duration needed to reach a target PPI with the given model.
+     * @param precision Arithmetic to solve with, as for [score]
+     * @return Duration in seconds
+     * @throws IllegalArgumentException if distance or target PPI is not positive (after rounding, for FIXED_Q16)
+     */
+    @Throws(IllegalArgumentException::class)
+    fun requiredTime(
+        distanceMeters: Double,
+        targetPpi: Double,
+        model: ScoringModel = defaultModel,
+        precision: ScoringPrecision = ScoringPrecision.DOUBLE
+    ): Double {
+        val curve = curveFor(model)
+        val time = when (precision) {
+            ScoringPrecision.DOUBLE -> curve.requiredTime(distanceMeters, targetPpi)
+            ScoringPrecision.FLOAT32 -> curve.requiredTimeFloat(distanceMeters.toFloat(), targetPpi.toFloat()).toDouble()
+            ScoringPrecision.FIXED_Q16 -> {
+                val time = curve.requiredTimeFixed(distanceMeters.roundToInt(), FixedQ16.fromDouble(targetPpi))
+                if (time == FixedQ16.INVALID.toLong()) Double.NaN else FixedQ16.toDouble(time)
+            }
+        }
+        require(!time.isNaN()) { "Distance and target PPI must be positive" }
+        return time
+    }
+
+    /**
+     * Version string of the default model, stored next to every computed PPI.
+     */
+    fun currentVersion(): String = defaultModel.version
+}
+
+/**
+ * Shared batch loop. Inlined into each curve with that curve's row function,
+ * which is what gives every model its own dispatch-free loop.
+ */
+private inline fun scoreRows(
+    distancesMeters: DoubleArray,
+    durationsSec: DoubleArray,
+    out: DoubleArray,
+    row: (Double, Double) -> Double
+): DoubleArray {
+    require(durationsSec.size == distancesMeters.size) { "distancesMeters and durationsSec must have the same length" }
+    require(out.size >= distancesMeters.size) { "out is smaller than the input" }
+    for (i in distancesMeters.indices) {
+        out[i] = row(distancesMeters[i], durationsSec[i])
+    }
+    return out
+}
+
+/**
+ * Baseline lookup that snaps to the closest anchor (ties go to the shorter one).
+ * Precomputed midpoints turn the nearest-anchor search into a count of
+ * midpoints below the distance.
+ */
+internal class NearestAnchors(distancesMeters: DoubleArray, private val timesSec: DoubleArray) {
+    private val midpoints = DoubleArray(distancesMeters.size - 1) { (distancesMeters[it] + distancesMeters[it + 1]) / 2.0 }
+
+    // Reduced-precision copies; for whole meters, d > mid is the same test as d > floor(mid)
+    private val midpointsFloat = FloatArray(midpoints.size) { midpoints[it].toFloat() }
+    private val timesSecFloat = FloatArray(timesSec.size) { timesSec[it].toFloat() }
+    private val midpointsWhole = IntArray(midpoints.size) { midpoints[it].toInt() }
+    private val log2TimesQ16 = IntArray(timesSec.size) { FixedQ16.fromDouble(log2(timesSec[it])) }
+
+    fun baselineTime(distanceMeters: Double): Double {
+        var index = 0
+        for (mid in midpoints) {
+            index += if (distanceMeters > mid) 1 else 0
+        }
+        return timesSec[index]
+    }
+
+    fun baselineTimeFloat(distanceMeters: Float): Float {
+        var index = 0
+        for (mid in midpointsFloat) {
+            index += if (distanceMeters > mid) 1 else 0
+        }
+        return timesSecFloat[index]
+    }
+
+    fun log2BaselineQ16(distanceMeters: Int): Int {
+        var index = 0
+        for (mid in midpointsWhole) {
+            index += if (distanceMeters > mid) 1 else 0
+        }
+        return log2TimesQ16[index]
+    }
+}
+
+/**
+ * Baseline lookup by piecewise-linear interpolation in log-log space, clamped to the
+ * first and last anchor. Each segment stores its slope and intercept in log space,
+ * so a lookup is one `ln`, one multiply-add and one `exp`.
+ */
+internal class LogLogAnchors(distancesMeters: DoubleArray, timesSec: DoubleArray) {
+    private val logDistances = DoubleArray(distancesMeters.size) { ln(distancesMeters[it]) }
+    private val slopes = DoubleArray(distancesMeters.size - 1) { i ->
+        (ln(timesSec[i + 1]) - ln(timesSec[i])) / (logDistances[i + 1] - logDistances[i])
+    }
+    private val intercepts = DoubleArray(distancesMeters.size - 1) { i ->
+        ln(timesSec[i]) - slopes[i] * logDistances[i]
+    }
+
+    private val logDistancesFloat = FloatArray(logDistances.size) { logDistances[it].toFloat() }
+    private val slopesFloat = FloatArray(slopes.size) { slopes[it].toFloat() }
+    private val interceptsFloat = FloatArray(intercepts.size) { intercepts[it].toFloat() }
+
+    // The slope is the same in log2 space; only the intercept and breakpoints rescale
+    private val log2DistancesQ16 = IntArray(logDistances.size) { FixedQ16.fromDouble(logDistances[it] / LN_2) }
+    private val slopesQ16 = IntArray(slopes.size) { FixedQ16.fromDouble(slopes[it]) }
+    private val log2InterceptsQ16 = IntArray(intercepts.size) { FixedQ16.fromDouble(intercepts[it] / LN_2) }
+
+    fun baselineTime(distanceMeters: Double): Double {
+        val logD = ln(distanceMeters).coerceIn(logDistances.first(), logDistances.last())
+        var segment = 0
+        for (k in 1 until logDistances.size - 1) {
+            segment += if (logD > logDistances[k]) 1 else 0
+        }
+        return exp(intercepts[segment] + slopes[segment] * logD)
+    }
+
+    fun baselineTimeFloat(distanceMeters: Float): Float {
+        val logD = ln(distanceMeters).coerceIn(logDistancesFloat.first(), logDistancesFloat.last())
+        var segment = 0
+        for (k in 1 until logDistancesFloat.size - 1) {
+            segment += if (logD > logDistancesFloat[k]) 1 else 0
+        }
+        return exp(interceptsFloat[segment] + slopesFloat[segment] * logD)
+    }
+
+    fun log2BaselineQ16(distanceMeters: Int): Int {
+        val logD = FixedQ16.log2(distanceMeters).coerceIn(log2DistancesQ16.first(), log2DistancesQ16.last())
+        var segment = 0
+        for (k in 1 until log2DistancesQ16.size - 1) {
+            segment += if (logD > log2DistancesQ16[k]) 1 else 0
+        }
+        return log2InterceptsQ16[segment] + ((slopesQ16[segment].toLong() * logD) shr 16).toInt()
+    }
+
+    private companion object {
+        val LN_2 = ln(2.0)
+    }
+}
@@ -0,0 +1,159 @@
+package com.mebeatme.shared.core
+
+import kotlinx.serialization.Serializable
+import kotlinx.serialization.Transient
+import kotlin.math.ceil
+import kotlin.math.ln
+import kotlin.math.pow
+
+/**
+ * Mergeable streaming quantile sketch with a relative error bound (DDSketch-style log bins).
+ *
+ * A positive value v lands in bin ceil(log_γ v) with γ = (1 + α) / (1 - α), and a bin
+ * reports 2γ^i / (γ + 1). Every quantile is then within α × the true value at that
+ * rank: with the default α = 1%, a reported median PPI of 500 means the true one is
+ * in 495–505. Bins are dense counts from the lowest to the highest index seen, about
+ * 380 bins for PPI 1–2000 at 1%, so a query is one pass over a small array.
+ *
+ * Sketches with the same accuracy merge by adding counts, so shards and devices can
+ * be combined in any order. Counts can be decremented again, which lets owners
+ * remove a value they added. Zero and negative values share one extra bin.
+ *
+ * @param relativeAccuracy α, the relative error bound of [quantile]
+ */
+@Serializable
+class QuantileSketch private constructor(
+    val relativeAccuracy: Double,
+    private var offset: Int,
+    private var counts: LongArray,
+    private var zeroCount: Long,
+    private var total: Long
+) {
+
+    constructor(relativeAccuracy: Double = DEFAULT_ACCURACY) : this(relativeAccuracy, 0, LongArray(0), 0L, 0L) {
+        require(relativeAccuracy > 0.0 && relativeAccuracy < 1.0) { "relativeAccuracy must be in (0, 1)" }
+    }
+
+    @Transient
+    private val gamma = (1 + relativeAccuracy) / (1 - relativeAccuracy)
+
+    @Transient
+    private val logGamma = ln(gamma)
+
+    /** Number of values in the sketch. */
+    val count: Long get() = total
+
+    /**
+     * Add [value] [count] times. NaN is ignored.
+     */
+    fun add(value: Double, count: Long = 1L) {
+        require(count > 0) { "count must be positive" }
+        if (value.isNaN()) return
+        if (value <= 0.0) {
+            zeroCount += count
+        } else {
+            val index = binOf(value)
+            ensureBin(index)
+            counts[index - offset] += count
+        }
+        total += count
+    }
+
+    /**
+     * Remove [value] once, if its bin holds anything.
+     * @return true if a count was removed
+     */
+    fun remove(value: Double): Boolean {
+        if (value.isNaN()) return false
+        if (value <= 0.0) {
+            if (zeroCount == 0L) return false
+            zeroCount--
+        } else {
+            val slot = binOf(value) - offset
+            if (slot !in counts.indices || counts[slot] == 0L) return false
+            counts[slot]--
+        }
+        total--
+        return true
+    }
+
+    /**
+     * Add every count of [other] to this sketch.
+     */
+    fun merge(other: QuantileSketch) {
+        require(other.relativeAccuracy == relativeAccuracy) { "Cannot merge sketches with different accuracy" }
+        if (other.total == 0L) return
+        for (slot in other.counts.indices) {
+            if (other.counts[slot] == 0L) continue
+            val index = other.offset + slot
+            ensureBin(index)
+            counts[index - offset] += other.counts[slot]
+        }
+        zeroCount += other.zeroCount
+        total += other.total
+    }
+
+    fun copy(): QuantileSketch = QuantileSketch(relativeAccuracy, offset, counts.copyOf(), zeroCount, total)
+
+    fun clear() {
+        offset = 0
+        counts = LongArray(0)
+        zeroCount = 0L
+        total = 0L
+    }
+
+    /**
+     * Value at quantile [q] (0 = minimum, 1 = maximum), within [relativeAccuracy] of the true one.
+     * @return null if the sketch is empty
+     */
+    fun quantile(q: Double): Double? {
+        require(q in 0.0..1.0) { "q must be in [0, 1]" }
+        if (total == 0L) return null
+        val rank = (q * (total - 1)).toLong()
+        var seen = zeroCount
+        if (rank < seen) return 0.0
+        for (slot in counts.indices) {
+            seen += counts[slot]
+            if (rank < seen) return valueOf(offset + slot)
+        }
+        return valueOf(offset + counts.lastIndex)
+    }
+
+    /**
+     * Fraction of values at or below [value], e.g. 0.9 means [value] is in the top 10%.
+     * Values sharing [value]'s bin count as below it.
+     * @return null if the sketch is empty
+     */
+    fun rank(value: Double): Double? {
+        if (total == 0L) return null
+        if (value <= 0.0) return zeroCount.toDouble() / total
+        val lastSlot = (binOf(value) - offset).coerceAtMost(counts.lastIndex)
+        var below = zeroCount
+        for (slot in 0..lastSlot) below += counts[slot]
+        return below.toDouble() / total
+    }
+
+    private fun binOf(value: Double): Int = ceil(ln(value) / logGamma).toInt()
+
+    private fun valueOf(index: Int): Double = 2 * gamma.pow(index) / (gamma + 1)
+
+    // Grow the dense range to cover [index], keeping existing counts in place
+    private fun ensureBin(index: Int) {
+        if (counts.isEmpty()) {
+            offset = index
+            counts = LongArray(1)
+            return
+        }
+        val first = minOf(offset, index)
+        val last = maxOf(offset + counts.lastIndex, index)
+        if (first == offset && last == offset + counts.lastIndex) return
+        val grown = LongArray(last - first + 1)
+        counts.copyInto(grown, destinationOffset = offset - first)
+        offset = first
+        counts = grown
+    }
+
+    companion object {
+        const val DEFAULT_ACCURACY = 0.01
+    }
+}
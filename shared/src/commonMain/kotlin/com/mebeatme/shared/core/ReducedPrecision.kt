@@ -0,0 +1,96 @@
+package com.mebeatme.shared.core
+
+import kotlin.math.pow
+import kotlin.math.roundToInt
+
+/**
+ * Arithmetic used by a scoring call.
+ * Reduced-precision kernels are meant for live loops on watches, where a score
+ * is recomputed for every sensor sample and only needs to be good enough for the UI.
+ * @param maxRelativeError Documented worst-case |reduced / double - 1| against the curve's double [PpiCurve.score]
+ */
+enum class ScoringPrecision(val maxRelativeError: Double) {
+    /** Reference double-precision kernels */
+    DOUBLE(0.0),
+    /** Float32 kernels (measured worst case about 3e-7) */
+    FLOAT32(1e-5),
+    /** Integer Q16.16 kernels with table-driven log2/exp2 (measured worst case about 1.6e-4) */
+    FIXED_Q16(3e-4)
+}
+
+/**
+ * Q16.16 fixed-point helpers for the integer scoring kernels.
+ *
+ * Every curve is PPI = 1000 × (T₀/T)^p, so in log2 space a score is one subtraction
+ * and one multiply: log2 PPI = log2 1000 + p × (log2 T₀ - log2 T). [log2] and [exp2]
+ * interpolate linearly in 257-entry tables, which keeps the whole path in integer math.
+ */
+internal object FixedQ16 {
+    const val ONE = 1 shl 16
+
+    /** Returned by the fixed-point kernels for non-positive inputs. */
+    const val INVALID = -1
+
+    private const val TABLE_BITS = 8
+    private const val TABLE_SIZE = 1 shl TABLE_BITS
+
+    // log2(1 + i / 256) and 2^(i / 256), both in Q16
+    private val log2Table = IntArray(TABLE_SIZE + 1) { fromDouble(kotlin.math.log2(1.0 + it.toDouble() / TABLE_SIZE)) }
+    private val exp2Table = IntArray(TABLE_SIZE + 1) { fromDouble(2.0.pow(it.toDouble() / TABLE_SIZE)) }
+
+    private val log2Of1000 = fromDouble(kotlin.math.log2(1000.0))
+
+    fun fromDouble(value: Double): Int = (value * ONE).roundToInt()
+
+    fun toDouble(value: Int): Double = value.toDouble() / ONE
+
+    fun toDouble(value: Long): Double = value.toDouble() / ONE
+
+    /**
+     * log2 of a positive integer, in Q16.
+     */
+    fun log2(x: Int): Int {
+        val msb = 31 - x.countLeadingZeroBits()
+        // Normalise to a 30-bit fraction, then split it into table index and remainder
+        val fraction = (x.toLong() shl (30 - msb)) - (1L shl 30)
+        val index = (fraction shr 22).toInt()
+        val remainder = fraction and ((1L shl 22) - 1)
+        val low = log2Table[index]
+        val high = log2Table[index + 1]
+        return (msb shl 16) + low + (((high - low) * remainder) shr 22).toInt()
+    }
+
+    /**
+     * 2^(y / 65536) in Q16. Saturates instead of overflowing.
+     */
+    fun exp2(y: Int): Long {
+        val whole = y shr 16
+        if (whole < -32) return 0L
+        if (whole > 40) return Long.MAX_VALUE
+        val fraction = y and 0xFFFF
+        val index = fraction shr 8
+        val remainder = fraction and 0xFF
+        val low = exp2Table[index]
+        val high = exp2Table[index + 1]
+        val mantissa = (low + (((high - low) * remainder) shr 8)).toLong()
+        return if (whole >= 0) mantissa shl whole else mantissa shr -whole
+    }
+
+    /**
+     * Power-law score in Q16 from a Q16 log2 baseline.
+     */
+    fun powerLawScore(log2BaselineQ16: Int, durationSec: Int, exponentQ16: Int, floorQ16: Int, ceilingQ16: Int): Int {
+        val logRatio = log2BaselineQ16 - log2(durationSec)
+        val logPpi = log2Of1000 + ((exponentQ16.toLong() * logRatio) shr 16).toInt()
+        return exp2(logPpi).coerceIn(floorQ16.toLong(), ceilingQ16.toLong()).toInt()
+    }
+
+    /**
+     * Inverse of [powerLawScore]: duration in Q16 seconds for a Q16 target.
+     */
+    fun powerLawTime(log2BaselineQ16: Int, targetPpiQ16: Int, inverseExponentQ16: Int): Long {
+        val logTarget = log2(targetPpiQ16) - (16 shl 16)
+        val logRatio = ((inverseExponentQ16.toLong() * (logTarget - log2Of1000)) shr 16).toInt()
+        return exp2(log2BaselineQ16 - logRatio)
+    }
+}
@@ -3,6 +3,12 @@ package com.mebeatme.shared.core
 import com.mebeatme.shared.model.RunDTO
 import com.mebeatme.shared.model.BestsDTO
 import com.mebeatme.shared.model.RunSession
+import com.mebeatme.shared.persistence.BestsBand
+import com.mebeatme.shared.persistence.BestsIndex
+import com.mebeatme.shared.persistence.RunBatch
+import com.mebeatme.shared.persistence.RunBatchCodec
+import com.mebeatme.shared.persistence.toBestsDTO
+import com.mebeatme.shared.persistence.upsert
 import kotlinx.datetime.Clock
 import kotlin.math.*
 
@@ -27,29 +33,8 @@ fun purdyScore(distanceMeters: Double, durationSec: Int): Double {
         throw IllegalArgumentException("Duration must be positive")
     }
     
-    // Purdy baseline times for different distances (in seconds)
-    val baselineTimes = mapOf(
-        100.0 to 10.0,      // 100m in 10.0s
-        200.0 to 20.0,      // 200m in 20.0s
-        400.0 to 45.0,      // 400m in 45.0s
-        800.0 to 105.0,     // 800m in 1:45
-        1500.0 to 210.0,    // 1500m in 3:30
-        3000.0 to 450.0,    // 3000m in 7:30
-        5000.0 to 780.0,    // 5000m in 13:00
-        10000.0 to 1620.0,  // 10000m in 27:00
-        21097.5 to 3540.0,  // Half marathon in 59:00
-        42195.0 to 7260.0   // Marathon in 2:01:00
-    )
-    
-    // Find closest baseline distance
-    val closestDistance = baselineTimes.keys.minByOrNull { abs(it - distanceMeters) } ?: 5000.0
-    val baselineTime = baselineTimes[closestDistance]!!
-    
-    // Calculate Purdy score using cubic relationship: P = 1000 × (T₀/T)³
-    val ratio = baselineTime.toDouble() / durationSec.toDouble()
-    val score = 1000.0 * (ratio * ratio * ratio)
-    
-    return score.coerceAtLeast(0.0)
+    // Cubic over the nearest baseline anchor, the engine's default curve
+    return PpiScoringEngine.score(distanceMeters, durationSec.toDouble())
 }
 
 /**
@@ -95,36 +80,49 @@ fun highestPpiInWindow(runs: List<RunDTO>, nowMs: Long, days: Int = 90): Double?
  * @return BestsDTO with best times for 5K, 10K, Half, Full
  */
 fun calculateBests(runs: List<RunDTO>, sinceMs: Long = 0L): BestsDTO {
-    val filteredRuns = runs.filter { it.startedAtEpochMs >= sinceMs }
-    
-    val best5k = filteredRuns
-        .filter { it.distanceMeters >= 4900 && it.distanceMeters <= 5100 }
-        .minByOrNull { it.elapsedSeconds }
-        ?.elapsedSeconds
-    
-    val best10k = filteredRuns
-        .filter { it.distanceMeters >= 9900 && it.distanceMeters <= 10100 }
-        .minByOrNull { it.elapsedSeconds }
-        ?.elapsedSeconds
-    
-    val bestHalf = filteredRuns
-        .filter { it.distanceMeters >= 20900 && it.distanceMeters <= 21100 }
-        .minByOrNull { it.elapsedSeconds }
-        ?.elapsedSeconds
-    
-    val bestFull = filteredRuns
-        .filter { it.distanceMeters >= 41900 && it.distanceMeters <= 42200 }
-        .minByOrNull { it.elapsedSeconds }
-        ?.elapsedSeconds
+    // One pass over the list; stores keep a BestsIndex instead (JsonRunStore.getBests)
+    val bests = BestsIndex()
+    runs.forEach { run ->
+        if (run.startedAtEpochMs >= sinceMs) bests.upsert(run)
+    }
     
     val highestPPILast90Days = highestPpiInWindow(runs, Clock.System.now().toEpochMilliseconds(), 90)
     
+    return bests.toBestsDTO(sinceMs, highestPPILast90Days)
+}
+
+/**
+ * Calculate best times for standard distances from packed runs, reading fields in place.
+ * Gives the same result as [calculateBests] without unpacking a run; a separate name so
+ * Swift sees two distinct methods rather than a mangled overload.
+ * @param runs Runs packed by [RunBatchCodec], e.g. from JsonRunStore.getAllPacked on iOS
+ * @param sinceMs Only consider runs after this timestamp (default 0 = all time)
+ * @return BestsDTO with best times for 5K, 10K, Half, Full
+ */
+fun calculateBestsPacked(runs: RunBatch, sinceMs: Long = 0L): BestsDTO {
+    val bands = BestsBand.STANDARD
+    val best = IntArray(bands.size) { Int.MAX_VALUE }
+    val cutoffMs = Clock.System.now().toEpochMilliseconds() - 90 * 24L * 3600_000
+    var highestPpi: Double? = null
+    for (i in 0 until runs.size) {
+        val startedAtEpochMs = runs.startedAtEpochMs(i)
+        val ppi = runs.ppi(i)
+        if (ppi != null && startedAtEpochMs >= cutoffMs && (highestPpi == null || ppi > highestPpi)) highestPpi = ppi
+        if (startedAtEpochMs < sinceMs) continue
+        val distanceMeters = runs.distanceMeters(i)
+        bands.forEachIndexed { band, range ->
+            if (range.contains(distanceMeters)) best[band] = minOf(best[band], runs.elapsedSeconds(i))
+            runs.bestEffortSeconds(i, band)?.let { best[band] = minOf(best[band], it) }
+        }
+    }
+    val bestSeconds = best.map { it.takeUnless { seconds -> seconds == Int.MAX_VALUE } }
+    
     return BestsDTO(
-        best5kSec = best5k,
-        best10kSec = best10k,
-        bestHalfSec = bestHalf,
-        bestFullSec = bestFull,
-        highestPPILast90Days = highestPPILast90Days
+        best5kSec = bestSeconds[0],
+        best10kSec = bestSeconds[1],
+        bestHalfSec = bestSeconds[2],
+        bestFullSec = bestSeconds[3],
+        highestPPILast90Days = highestPpi
     )
 }
 
@@ -140,15 +138,22 @@ fun RunSession.toRunDTO(): RunDTO {
         distanceMeters = this.distance,
         elapsedSeconds = this.duration.toInt(),
         avgPaceSecPerKm = this.pace,
-        ppi = null // Will be calculated separately
+        ppi = null, // Will be calculated separately
+        bestEffortsSec = BestEffortsEngine.compute(this), // Computed once here, reused by every bests query
+        maxDistanceByDurationM = PaceCurveEngine.compute(this)
     )
 }
 
 /**
- * Calculate PPI for a RunDTO using the Purdy score function.
+ * Calculate PPI for a RunDTO using the engine's default scoring model.
+ * @throws IllegalArgumentException if the run's distance or elapsed time is not positive
  */
+@Throws(IllegalArgumentException::class)
 fun RunDTO.calculatePpi(): RunDTO {
-    return this.copy(ppi = purdyScore(this.distanceMeters, this.elapsedSeconds))
+    return this.copy(
+        ppi = PpiScoringEngine.score(this.distanceMeters, this.elapsedSeconds.toDouble()),
+        ppiCurveVersion = PpiScoringEngine.currentVersion()
+    )
 }
 
 
@@ -0,0 +1,84 @@
+package com.mebeatme.shared.core
+
+import com.mebeatme.shared.model.RunSession
+
+/**
+ * Extreme change in [ys] over every window of fixed length in [xs], for several lengths at once.
+ *
+ * Both series are cumulative and non-decreasing (time and distance of a run), and
+ * values between samples are linearly interpolated. The change over a window is then
+ * piecewise linear in the window position, so the extreme sits on a window that starts
+ * or ends on a sample. One pass anchors windows at their end sample and one at their
+ * start sample, each keeping a monotone pointer per span: O(n) per span.
+ *
+ * Best efforts are the minimum time over a distance span (xs = distance, ys = time);
+ * the pace-duration curve is the maximum distance over a time span (xs = time, ys = distance).
+ *
+ * @param spans Window lengths in units of [xs]
+ * @param maximize Look for the largest change instead of the smallest
+ * @return Extreme change per span, NaN where the series is shorter than the span
+ */
+internal fun sweepSpans(xs: DoubleArray, ys: DoubleArray, spans: DoubleArray, maximize: Boolean): DoubleArray {
+    val n = xs.size
+    val best = DoubleArray(spans.size) { if (maximize) Double.NEGATIVE_INFINITY else Double.POSITIVE_INFINITY }
+    fun offer(k: Int, value: Double) {
+        best[k] = if (maximize) maxOf(best[k], value) else minOf(best[k], value)
+    }
+
+    // Windows ending on sample j: start is interpolated between starts[k] and starts[k] + 1
+    val starts = IntArray(spans.size)
+    for (j in 0 until n) {
+        for (k in spans.indices) {
+            val startX = xs[j] - spans[k]
+            if (startX < xs[0]) continue
+            var i = starts[k]
+            while (i + 1 < j && xs[i + 1] <= startX) i++
+            starts[k] = i
+            offer(k, ys[j] - interpolate(xs, ys, i, startX))
+        }
+    }
+
+    // Windows starting on sample i: end is interpolated between ends[k] - 1 and ends[k]
+    val ends = IntArray(spans.size)
+    for (i in 0 until n) {
+        for (k in spans.indices) {
+            val endX = xs[i] + spans[k]
+            var j = maxOf(ends[k], i + 1)
+            while (j < n && xs[j] < endX) j++
+            ends[k] = j
+            if (j >= n) continue
+            offer(k, interpolate(xs, ys, j - 1, endX) - ys[i])
+        }
+    }
+
+    return DoubleArray(best.size) { if (best[it].isInfinite()) Double.NaN else best[it] }
+}
+
+// Value of ys where xs reaches [x], between samples [index] and [index] + 1
+private fun interpolate(xs: DoubleArray, ys: DoubleArray, index: Int, x: Double): Double {
+    val next = index + 1
+    if (next >= xs.size) return ys[index]
+    val span = xs[next] - xs[index]
+    if (span <= 0.0) return ys[index]
+    val fraction = ((x - xs[index]) / span).coerceIn(0.0, 1.0)
+    return ys[index] + fraction * (ys[next] - ys[index])
+}
+
+/**
+ * Sample times in seconds from the first sample and cumulative distance, ready for [sweepSpans].
+ * Samples are taken in timestamp order and distance is made non-decreasing to absorb GPS jitter.
+ * @return null if the session has fewer than two samples
+ */
+internal fun RunSession.cumulativeSeries(): Pair<DoubleArray, DoubleArray>? {
+    if (samples.size < 2) return null
+    val ordered = samples.sortedBy { it.timestamp }
+    val origin = ordered.first().timestamp.toEpochMilliseconds()
+    val times = DoubleArray(ordered.size) { (ordered[it].timestamp.toEpochMilliseconds() - origin) / 1000.0 }
+    val distances = DoubleArray(ordered.size)
+    var covered = 0.0
+    for (i in ordered.indices) {
+        covered = maxOf(covered, ordered[i].distance)
+        distances[i] = covered
+    }
+    return times to distances
+}
@@ -1,5 +1,6 @@
 package com.mebeatme.shared.model
 
+import com.mebeatme.shared.persistence.PackedSamplesSerializer
 import kotlinx.serialization.Serializable
 import kotlinx.datetime.Instant
 
@@ -15,7 +16,10 @@ data class RunDTO(
     val avgPaceSecPerKm: Double,
     val avgHr: Int? = null,
     val ppi: Double? = null,
-    val notes: String? = null
+    val notes: String? = null,
+    val ppiCurveVersion: String? = null, // ScoringModel.version that produced ppi
+    val bestEffortsSec: Map<String, Int> = emptyMap(), // fastest segment per BestEffortsEngine distance, set at import
+    val maxDistanceByDurationM: List<Double> = emptyList() // PaceCurveEngine curve on DURATIONS_SEC, set at import
 )
 
 @Serializable
@@ -28,6 +32,14 @@ data class BestsDTO(
 )
 
 // Legacy models for backward compatibility
+/**
+ * A recorded run with its samples.
+ *
+ * In JSON, [samples] is a Base64 [com.mebeatme.shared.persistence.SampleCodec] string
+ * (a legacy array of sample objects is still read). Samples that round-trip through it
+ * come back quantized: distance to whole centimetres, pace to 0.01 s/km, timestamps to
+ * whole milliseconds, coordinates to 1e-7° and elevation to decimetres.
+ */
 @Serializable
 data class RunSession(
     val id: String,
@@ -35,14 +47,19 @@ data class RunSession(
     val duration: Long, // in seconds
     val timestamp: Instant,
     val pace: Double, // seconds per kilometer
-    val samples: List<RunSample> = emptyList()
+    @Serializable(with = PackedSamplesSerializer::class)
+    val samples: List<RunSample> = emptyList() // in time order; a Base64 SampleCodec string in JSON
 )
 
 @Serializable
 data class RunSample(
     val timestamp: Instant,
     val distance: Double,
-    val pace: Double
+    val pace: Double,
+    val latitude: Double? = null, // degrees
+    val longitude: Double? = null, // degrees
+    val elevation: Double? = null, // in meters
+    val heartRate: Int? = null // bpm
 )
 
 @Serializable
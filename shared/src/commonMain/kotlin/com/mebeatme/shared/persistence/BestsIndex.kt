@@ -0,0 +1,212 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.BestsDTO
+import com.mebeatme.shared.model.RunDTO
+
+/**
+ * Distance range that counts towards one personal best.
+ * @param minMeters Inclusive lower bound
+ * @param maxMeters Inclusive upper bound
+ */
+data class BestsBand(
+    val name: String,
+    val minMeters: Double,
+    val maxMeters: Double
+) {
+    fun contains(distanceMeters: Double): Boolean = distanceMeters >= minMeters && distanceMeters <= maxMeters
+
+    companion object {
+        val FIVE_K = BestsBand("5k", 4900.0, 5100.0)
+        val TEN_K = BestsBand("10k", 9900.0, 10100.0)
+        val HALF = BestsBand("half", 20900.0, 21100.0)
+        val FULL = BestsBand("full", 41900.0, 42200.0)
+
+        /** Ranges used by calculateBests and the client stores */
+        val STANDARD = listOf(FIVE_K, TEN_K, HALF, FULL)
+
+        /**
+         * The four standard distances with a relative tolerance around each, as the server matches them.
+         * @param tolerance Fraction of the target distance, e.g. 0.05 for ±5%
+         */
+        fun withTolerance(tolerance: Double): List<BestsBand> =
+            listOf("5k" to 5000.0, "10k" to 10000.0, "half" to 21097.0, "full" to 42195.0).map { (name, target) ->
+                BestsBand(name, target * (1 - tolerance), target * (1 + tolerance))
+            }
+    }
+}
+
+/**
+ * Personal bests per distance band, maintained incrementally as runs are stored and deleted.
+ *
+ * Each band keeps its runs in an indexed min-heap ordered by elapsed time, so the
+ * current best is read in O(1), and an upsert or delete costs O(log n) in the size of
+ * that band. Deleting the best lets the next fastest run surface. Queries with a
+ * `sinceMs` answer from the heap top when the all-time best is recent enough and
+ * otherwise scan that band only, never the full history.
+ *
+ * The index is field-based so it serves both RunDTO types (model and api).
+ * It is not synchronized; the owning store guards it with its own lock.
+ */
+class BestsIndex(val bands: List<BestsBand> = BestsBand.STANDARD) {
+
+    private val heaps = List(bands.size) { BandHeap() }
+    private val bandOf = HashMap<String, IntArray>()
+
+    /**
+     * Insert a run, or move it if it was indexed before with different values.
+     * @param effortSeconds Fastest segments inside the run keyed by band name (see BestEffortsEngine),
+     * so a 5k inside a longer run counts too; the whole run still counts when its distance is in a band
+     */
+    fun upsert(
+        id: String,
+        distanceMeters: Double,
+        elapsedSeconds: Int,
+        startedAtEpochMs: Long,
+        effortSeconds: Map<String, Int> = emptyMap()
+    ) {
+        remove(id)
+        val matched = mutableListOf<Int>()
+        for (index in bands.indices) {
+            val band = bands[index]
+            val whole = if (band.contains(distanceMeters)) elapsedSeconds else null
+            val seconds = listOfNotNull(whole, effortSeconds[band.name]).minOrNull() ?: continue
+            heaps[index].add(BestEntry(id, seconds, startedAtEpochMs))
+            matched.add(index)
+        }
+        if (matched.isNotEmpty()) bandOf[id] = matched.toIntArray()
+    }
+
+    /**
+     * Remove a run.
+     * @return true if the run was in any band
+     */
+    fun remove(id: String): Boolean {
+        val indexes = bandOf.remove(id) ?: return false
+        indexes.forEach { heaps[it].remove(id) }
+        return true
+    }
+
+    fun clear() {
+        heaps.forEach { it.clear() }
+        bandOf.clear()
+    }
+
+    /**
+     * Best elapsed time in a band.
+     * @param sinceMs Only consider runs started at or after this timestamp (0 = all time)
+     * @return Seconds, or null if no run qualifies
+     */
+    fun bestSeconds(band: BestsBand, sinceMs: Long = 0L): Int? {
+        val index = bands.indexOf(band)
+        require(index >= 0) { "Unknown band ${band.name}" }
+        return heaps[index].best(sinceMs)
+    }
+
+    /**
+     * Best elapsed time per band, in the order of [bands].
+     */
+    fun bestSecondsByBand(sinceMs: Long = 0L): List<Int?> = heaps.map { it.best(sinceMs) }
+
+    /**
+     * Best elapsed time in the band at [bandIndex] of [bands], unboxed for the flat bests record.
+     * @return Seconds, or -1 if no run qualifies
+     */
+    fun bestSecondsAt(bandIndex: Int, sinceMs: Long = 0L): Int = heaps[bandIndex].bestOrNone(sinceMs)
+}
+
+internal fun BestsIndex.upsert(run: RunDTO) =
+    upsert(run.id, run.distanceMeters, run.elapsedSeconds, run.startedAtEpochMs, run.bestEffortsSec)
+
+/**
+ * Bests for the standard bands as a [BestsDTO].
+ */
+internal fun BestsIndex.toBestsDTO(sinceMs: Long, highestPpiLast90Days: Double?): BestsDTO {
+    return BestsDTO(
+        best5kSec = bestSeconds(BestsBand.FIVE_K, sinceMs),
+        best10kSec = bestSeconds(BestsBand.TEN_K, sinceMs),
+        bestHalfSec = bestSeconds(BestsBand.HALF, sinceMs),
+        bestFullSec = bestSeconds(BestsBand.FULL, sinceMs),
+        highestPPILast90Days = highestPpiLast90Days
+    )
+}
+
+internal data class BestEntry(val id: String, val elapsedSeconds: Int, val startedAtEpochMs: Long)
+
+/**
+ * Binary min-heap with a position map, so any entry can be removed by id in O(log n).
+ * Ties on elapsed time break on id to keep the order deterministic.
+ */
+internal class BandHeap {
+    private val entries = ArrayList<BestEntry>()
+    private val positions = HashMap<String, Int>()
+
+    fun add(entry: BestEntry) {
+        entries.add(entry)
+        positions[entry.id] = entries.lastIndex
+        siftUp(entries.lastIndex)
+    }
+
+    fun remove(id: String) {
+        val index = positions.remove(id) ?: return
+        val last = entries.removeAt(entries.lastIndex)
+        if (index == entries.size) return
+        entries[index] = last
+        positions[last.id] = index
+        siftDown(index)
+        siftUp(index)
+    }
+
+    fun clear() {
+        entries.clear()
+        positions.clear()
+    }
+
+    fun best(sinceMs: Long): Int? = bestOrNone(sinceMs).takeUnless { it < 0 }
+
+    // -1 if no entry started at or after sinceMs; a plain loop so the query allocates nothing
+    fun bestOrNone(sinceMs: Long): Int {
+        if (entries.isEmpty()) return -1
+        if (entries[0].startedAtEpochMs >= sinceMs) return entries[0].elapsedSeconds
+        var best = -1
+        for (i in entries.indices) {
+            val entry = entries[i]
+            if (entry.startedAtEpochMs >= sinceMs && (best < 0 || entry.elapsedSeconds < best)) best = entry.elapsedSeconds
+        }
+        return best
+    }
+
+    private fun less(a: BestEntry, b: BestEntry): Boolean =
+        a.elapsedSeconds < b.elapsedSeconds || (a.elapsedSeconds == b.elapsedSeconds && a.id < b.id)
+
+    private fun siftUp(start: Int) {
+        var i = start
+        while (i > 0) {
+            val parent = (i - 1) / 2
+            if (!less(entries[i], entries[parent])) break
+            swap(i, parent)
+            i = parent
+        }
+    }
+
+    private fun siftDown(start: Int) {
+        var i = start
+        while (true) {
+            val left = 2 * i + 1
+            if (left >= entries.size) break
+            val right = left + 1
+            val child = if (right < entries.size && less(entries[right], entries[left])) right else left
+            if (!less(entries[child], entries[i])) break
+            swap(i, child)
+            i = child
+        }
+    }
+
+    private fun swap(a: Int, b: Int) {
+        val entryA = entries[a]
+        val entryB = entries[b]
+        entries[a] = entryB
+        entries[b] = entryA
+        positions[entryB.id] = a
+        positions[entryA.id] = b
+    }
+}
@@ -1,19 +1,25 @@
 package com.mebeatme.shared.persistence
 
+import com.mebeatme.shared.model.BestsDTO
 import com.mebeatme.shared.model.RunDTO
-import com.mebeatme.shared.core.highestPpiInWindow
+import kotlinx.datetime.TimeZone
 
 /**
- * JSON-based persistence layer for MeBeatMe
+ * Persistence layer for MeBeatMe
  * Following the HYBRID PROMPT specifications
  * 
  * Features:
- * - Append-only JSON storage
- * - Atomic writes (temp file → move)
+ * - Append-only binary run log ([RunLogCodec]), fsynced per write
+ * - JSON import/export
  * - Thread-safe operations
  * - 90-day computation support
  */
-expect class JsonRunStore(dataFile: Any) {
+expect class JsonRunStore(dataFile: Any, timeZone: TimeZone) {
+    
+    /**
+     * Open a store whose rollups follow the device's current time zone
+     */
+    constructor(dataFile: Any)
     
     /**
      * Add or update runs in the store
@@ -22,6 +28,13 @@ expect class JsonRunStore(dataFile: Any) {
      */
     fun upsertAll(newRuns: List<RunDTO>): Int
     
+    /**
+     * Replace runs only where the stored run still equals the one read, as one write
+     * @param updates Pairs of the run as read and its replacement with the same ID
+     * @return Number of runs replaced; a run edited or deleted since it was read is left alone
+     */
+    fun replaceIfUnchanged(updates: List<Pair<RunDTO, RunDTO>>): Int
+    
     /**
      * Get all runs since a specific timestamp
      * @param sinceMs Timestamp in milliseconds
@@ -43,6 +56,45 @@ expect class JsonRunStore(dataFile: Any) {
      */
     fun getHighestPpiLast90Days(nowMs: Long, days: Int = 90): Double?
     
+    /**
+     * Get highest PPI for several lookback windows in one query
+     * @param nowMs Current time in milliseconds
+     * @param days Lookback lengths in days, e.g. 7, 30, 90, 365
+     * @return Highest PPI per window (null if no runs), in the order of [days]
+     */
+    fun getHighestPpiInWindows(nowMs: Long, days: List<Int>): List<Double?>
+    
+    /**
+     * Get personal bests from the incrementally maintained [BestsIndex]
+     * @param nowMs Current time in milliseconds, for the 90-day PPI
+     * @param sinceMs Only consider runs after this timestamp (default 0 = all time)
+     * @return Best times for 5K, 10K, Half, Full
+     */
+    fun getBests(nowMs: Long, sinceMs: Long = 0L): BestsDTO
+    
+    /**
+     * Get materialized rollup rows for a time range
+     * Days, weeks and months are calendar periods in the store's time zone
+     * @param period Day, ISO week or month
+     * @param fromMs Range start in milliseconds
+     * @param toMs Range end in milliseconds
+     * @return Non-empty rows whose period overlaps the range, oldest first
+     */
+    fun getRollups(period: RollupPeriod, fromMs: Long, toMs: Long): List<RollupRow>
+    
+    /**
+     * Get the fastest pace held for a duration across all stored runs
+     * @param durationSec Window length in seconds, 10 s to 20480 s (about 5.7 h)
+     * @return Seconds per kilometre from the merged pace curves, or null if no run is that long
+     */
+    fun getSustainedPaceSecPerKm(durationSec: Double): Double?
+    
+    /**
+     * Get the PPI and pace quantile sketches per distance bucket
+     * @return Copy of the sketches, safe to query, serialize or merge elsewhere
+     */
+    fun getSketches(): RunSketches
+    
     /**
      * Get run by ID
      * @param id Run ID
@@ -62,9 +114,29 @@ expect class JsonRunStore(dataFile: Any) {
      */
     fun clear()
     
+    /**
+     * Export all runs as a JSON array
+     * @return Pretty-printed JSON of every run
+     */
+    fun exportJson(): String
+    
+    /**
+     * Import runs from a JSON array, upserting by ID
+     * @param jsonString JSON produced by [exportJson] or the legacy runs.json
+     * @return Number of runs stored
+     */
+    fun importJson(jsonString: String): Int
+    
     /**
      * Get run count
      * @return Number of runs
      */
     fun size(): Int
+    
+    /**
+     * Get what opening the run log had to repair: damaged records dropped and where the
+     * original was kept aside, or torn tails cut off
+     * @return Repairs since the store was created; empty when the log was intact
+     */
+    fun getLogRecovery(): RunLogRecovery
 }
@@ -0,0 +1,192 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+
+/**
+ * Highest PPI over any start-time window, maintained incrementally as runs are stored and deleted.
+ *
+ * Runs are kept in a treap ordered by (startedAtEpochMs, id) where every node also
+ * carries the highest PPI in its subtree. A window query walks two root-to-leaf paths,
+ * so any lookback costs O(log n) no matter how long the history is. Nodes are never
+ * mutated: updates copy the O(log n) nodes on their path, so a root that a reader
+ * already holds stays valid while a writer builds the next one.
+ *
+ * Runs without a PPI are not indexed.
+ */
+class PpiWindowIndex {
+
+    private var root: WindowNode? = null
+    private val startedAtById = HashMap<String, Long>()
+
+    val size: Int get() = startedAtById.size
+
+    /**
+     * Insert a run, or move it if it was indexed before with a different start time or PPI.
+     */
+    fun upsert(id: String, startedAtEpochMs: Long, ppi: Double?) {
+        remove(id)
+        if (ppi == null || ppi.isNaN()) return
+        val (left, right) = split(root, startedAtEpochMs, id)
+        root = merge(merge(left, WindowNode(startedAtEpochMs, id, ppi, priorityOf(id), null, null)), right)
+        startedAtById[id] = startedAtEpochMs
+    }
+
+    /**
+     * Remove a run.
+     * @return true if the run was indexed
+     */
+    fun remove(id: String): Boolean {
+        val startedAt = startedAtById.remove(id) ?: return false
+        root = remove(root, startedAt, id)
+        return true
+    }
+
+    fun clear() {
+        root = null
+        startedAtById.clear()
+    }
+
+    /**
+     * Highest PPI among runs started in [fromMs, toMs].
+     * @return Highest PPI, or null if no run in the window has one
+     */
+    fun maxPpi(fromMs: Long, toMs: Long = Long.MAX_VALUE): Double? = maxPpiOrNaN(fromMs, toMs).takeUnless { it.isNaN() }
+
+    /**
+     * [maxPpi] without boxing the result, for the flat bests record.
+     * @return Highest PPI, or NaN if no run in the window has one
+     */
+    fun maxPpiOrNaN(fromMs: Long, toMs: Long = Long.MAX_VALUE): Double {
+        if (fromMs > toMs) return Double.NaN
+
+        // Descend to the first node inside the window; both bounds split off from there
+        var node = root
+        while (node != null && (node.startedAt < fromMs || node.startedAt > toMs)) {
+            node = if (node.startedAt < fromMs) node.right else node.left
+        }
+        if (node == null) return Double.NaN
+
+        var best = node.ppi
+        var left = node.left
+        while (left != null) {
+            if (left.startedAt >= fromMs) {
+                best = maxOf(best, left.ppi, left.right.subtreeMax())
+                left = left.left
+            } else {
+                left = left.right
+            }
+        }
+        var right = node.right
+        while (right != null) {
+            if (right.startedAt <= toMs) {
+                best = maxOf(best, right.ppi, right.left.subtreeMax())
+                right = right.right
+            } else {
+                right = right.left
+            }
+        }
+        return best
+    }
+
+    /**
+     * Highest PPI among runs started in the last [days] days (same window as highestPpiInWindow).
+     */
+    fun maxPpiInWindow(nowMs: Long, days: Int): Double? = maxPpi(nowMs - days * MS_PER_DAY)
+
+    /** [maxPpiInWindow], NaN if no run in the window has a PPI. */
+    fun maxPpiInWindowOrNaN(nowMs: Long, days: Int): Double = maxPpiOrNaN(nowMs - days * MS_PER_DAY)
+
+    /**
+     * Highest PPI over several lookbacks ending now, e.g. 7/30/90/365 days.
+     * Windows are nested, so each one only queries the slice it adds to the next shorter one.
+     * @param days Lookback lengths, any order
+     * @return Highest PPI per entry of [days], in the same order
+     */
+    fun maxPpiInWindows(nowMs: Long, days: List<Int>): List<Double?> {
+        val order = days.indices.sortedBy { days[it] }
+        val results = arrayOfNulls<Double>(days.size)
+        var running: Double? = null
+        var coveredFromMs = Long.MAX_VALUE
+        for (i in order) {
+            val cutoffMs = nowMs - days[i] * MS_PER_DAY
+            if (cutoffMs < coveredFromMs) {
+                val slice = if (coveredFromMs == Long.MAX_VALUE) maxPpi(cutoffMs) else maxPpi(cutoffMs, coveredFromMs - 1)
+                running = maxOfNullable(running, slice)
+                coveredFromMs = cutoffMs
+            }
+            results[i] = running
+        }
+        return results.toList()
+    }
+
+    private companion object {
+        const val MS_PER_DAY = 24L * 3600_000
+
+        fun maxOfNullable(a: Double?, b: Double?): Double? = when {
+            a == null -> b
+            b == null -> a
+            else -> maxOf(a, b)
+        }
+
+        fun WindowNode?.subtreeMax(): Double = this?.maxPpi ?: Double.NEGATIVE_INFINITY
+
+        // Deterministic priority from the id (SplitMix64 finaliser), so rebuilt indexes have the same shape
+        fun priorityOf(id: String): Long {
+            var z = id.hashCode().toLong() + -0x61c8864680b583ebL
+            z = (z xor (z ushr 30)) * -0x40a7b892e31b1a47L
+            z = (z xor (z ushr 27)) * -0x6b2fb644ecceee15L
+            return z xor (z ushr 31)
+        }
+
+        fun keyBefore(startedAt: Long, id: String, node: WindowNode): Boolean =
+            startedAt < node.startedAt || (startedAt == node.startedAt && id < node.id)
+
+        /** Split into keys before (startedAt, id) and keys at or after it. */
+        fun split(node: WindowNode?, startedAt: Long, id: String): Pair<WindowNode?, WindowNode?> {
+            if (node == null) return null to null
+            return if (keyBefore(startedAt, id, node)) {
+                val (left, right) = split(node.left, startedAt, id)
+                left to node.with(left = right)
+            } else {
+                val (left, right) = split(node.right, startedAt, id)
+                node.with(right = left) to right
+            }
+        }
+
+        /** Merge two treaps where every key of [a] is before every key of [b]. */
+        fun merge(a: WindowNode?, b: WindowNode?): WindowNode? {
+            if (a == null) return b
+            if (b == null) return a
+            return if (a.priority > b.priority) {
+                a.with(right = merge(a.right, b))
+            } else {
+                b.with(left = merge(a, b.left))
+            }
+        }
+
+        fun remove(node: WindowNode?, startedAt: Long, id: String): WindowNode? {
+            if (node == null) return null
+            return when {
+                node.startedAt == startedAt && node.id == id -> merge(node.left, node.right)
+                keyBefore(startedAt, id, node) -> node.with(left = remove(node.left, startedAt, id))
+                else -> node.with(right = remove(node.right, startedAt, id))
+            }
+        }
+    }
+}
+
+internal class WindowNode(
+    val startedAt: Long,
+    val id: String,
+    val ppi: Double,
+    val priority: Long,
+    val left: WindowNode?,
+    val right: WindowNode?
+) {
+    val maxPpi: Double = maxOf(ppi, left?.maxPpi ?: Double.NEGATIVE_INFINITY, right?.maxPpi ?: Double.NEGATIVE_INFINITY)
+
+    fun with(left: WindowNode? = this.left, right: WindowNode? = this.right): WindowNode =
+        WindowNode(startedAt, id, ppi, priority, left, right)
+}
+
+internal fun PpiWindowIndex.upsert(run: RunDTO) = upsert(run.id, run.startedAtEpochMs, run.ppi)
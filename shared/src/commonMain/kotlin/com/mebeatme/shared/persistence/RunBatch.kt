@@ -0,0 +1,253 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+
+/**
+ * Runs packed into one contiguous, read-only buffer of fixed-layout records, so a whole
+ * history crosses to Swift as a single NSData that is read in place, instead of one bridge
+ * object per run with boxed optional fields.
+ *
+ * All integers and doubles are little-endian, the byte order of every Apple CPU:
+ *
+ *     [8 magic][u16 version][u16 record size][u32 count][u32 strings offset][u32 strings length]
+ *     [count × record]
+ *     [u32 string count][u32 offsets × (string count + 1)][UTF-8 bytes]
+ *
+ * A record is [RECORD_SIZE] bytes at 8-aligned offsets, with the fields at the OFFSET_
+ * constants. Missing values are NaN (doubles) or -1 (integers and string indexes). Strings
+ * are indexes into the string table, where string i is the bytes between offsets i and
+ * i + 1; equal strings are stored once, so sources and curve versions cost a few bytes per
+ * batch. Best efforts are the four [BestsBand.STANDARD] bands. Pace curves stay in the store.
+ *
+ * Later versions only append fields to a record, so readers step by the header's record
+ * size and can read older fields from newer batches.
+ */
+object RunBatchCodec {
+    val MAGIC: ByteArray = byteArrayOf('M'.code.toByte(), 'B'.code.toByte(), 'M'.code.toByte(), 'R'.code.toByte(), 'U'.code.toByte(), 'N'.code.toByte(), 'S'.code.toByte(), 0)
+
+    const val VERSION = 1
+    const val HEADER_SIZE = 24
+    const val RECORD_SIZE = 80
+
+    const val OFFSET_STARTED_AT = 0
+    const val OFFSET_ENDED_AT = 8
+    const val OFFSET_DISTANCE = 16
+    const val OFFSET_AVG_PACE = 24
+    const val OFFSET_PPI = 32
+    const val OFFSET_ELAPSED = 40
+    const val OFFSET_AVG_HR = 44
+    const val OFFSET_ID = 48
+    const val OFFSET_SOURCE = 52
+    const val OFFSET_NOTES = 56
+    const val OFFSET_CURVE_VERSION = 60
+    const val OFFSET_BEST_EFFORTS = 64
+
+    fun encode(runs: List<RunDTO>): ByteArray {
+        val strings = StringTable()
+        val stringIndexes = IntArray(runs.size * 4)
+        runs.forEachIndexed { i, run ->
+            stringIndexes[4 * i] = strings.add(run.id)
+            stringIndexes[4 * i + 1] = strings.add(run.source)
+            stringIndexes[4 * i + 2] = run.notes?.let { strings.add(it) } ?: -1
+            stringIndexes[4 * i + 3] = run.ppiCurveVersion?.let { strings.add(it) } ?: -1
+        }
+        val stringsOffset = HEADER_SIZE + runs.size * RECORD_SIZE
+        val stringsLength = 4 * (strings.size + 2) + strings.byteCount
+        val out = ByteArray(stringsOffset + stringsLength)
+
+        MAGIC.copyInto(out)
+        writeShort(out, 8, VERSION)
+        writeShort(out, 10, RECORD_SIZE)
+        writeInt(out, 12, runs.size)
+        writeInt(out, 16, stringsOffset)
+        writeInt(out, 20, stringsLength)
+
+        runs.forEachIndexed { i, run ->
+            val at = HEADER_SIZE + i * RECORD_SIZE
+            writeLong(out, at + OFFSET_STARTED_AT, run.startedAtEpochMs)
+            writeLong(out, at + OFFSET_ENDED_AT, run.endedAtEpochMs)
+            writeLong(out, at + OFFSET_DISTANCE, run.distanceMeters.toRawBits())
+            writeLong(out, at + OFFSET_AVG_PACE, run.avgPaceSecPerKm.toRawBits())
+            writeLong(out, at + OFFSET_PPI, (run.ppi ?: Double.NaN).toRawBits())
+            writeInt(out, at + OFFSET_ELAPSED, run.elapsedSeconds)
+            writeInt(out, at + OFFSET_AVG_HR, run.avgHr ?: -1)
+            for (field in 0 until 4) writeInt(out, at + OFFSET_ID + 4 * field, stringIndexes[4 * i + field])
+            BestsBand.STANDARD.forEachIndexed { band, range ->
+                writeInt(out, at + OFFSET_BEST_EFFORTS + 4 * band, run.bestEffortsSec[range.name] ?: -1)
+            }
+        }
+
+        writeInt(out, stringsOffset, strings.size)
+        var offset = 0
+        var data = stringsOffset + 4 * (strings.size + 2)
+        strings.encoded.forEachIndexed { i, bytes ->
+            writeInt(out, stringsOffset + 4 * (i + 1), offset)
+            bytes.copyInto(out, data)
+            offset += bytes.size
+            data += bytes.size
+        }
+        writeInt(out, stringsOffset + 4 * (strings.size + 1), offset)
+        return out
+    }
+
+    internal fun writeShort(out: ByteArray, at: Int, value: Int) {
+        out[at] = value.toByte()
+        out[at + 1] = (value ushr 8).toByte()
+    }
+
+    internal fun writeInt(out: ByteArray, at: Int, value: Int) {
+        for (i in 0 until 4) out[at + i] = (value ushr (8 * i)).toByte()
+    }
+
+    internal fun writeLong(out: ByteArray, at: Int, value: Long) {
+        for (i in 0 until 8) out[at + i] = (value ushr (8 * i)).toByte()
+    }
+
+    internal fun readShort(bytes: ByteArray, at: Int): Int =
+        (bytes[at].toInt() and 0xFF) or ((bytes[at + 1].toInt() and 0xFF) shl 8)
+
+    internal fun readInt(bytes: ByteArray, at: Int): Int {
+        var value = 0
+        for (i in 3 downTo 0) value = (value shl 8) or (bytes[at + i].toInt() and 0xFF)
+        return value
+    }
+
+    internal fun readLong(bytes: ByteArray, at: Int): Long {
+        var value = 0L
+        for (i in 7 downTo 0) value = (value shl 8) or (bytes[at + i].toLong() and 0xFF)
+        return value
+    }
+
+    // Interns strings in first-use order
+    private class StringTable {
+        private val indexes = HashMap<String, Int>()
+        val encoded = ArrayList<ByteArray>()
+        var byteCount = 0
+            private set
+
+        val size: Int get() = encoded.size
+
+        fun add(value: String): Int = indexes.getOrPut(value) {
+            val bytes = value.encodeToByteArray()
+            encoded.add(bytes)
+            byteCount += bytes.size
+            encoded.lastIndex
+        }
+    }
+}
+
+/**
+ * Read access to a [RunBatchCodec] buffer without unpacking it; fields are decoded on each call.
+ * The header and string table are bounds-checked up front, so a damaged buffer fails here
+ * with IllegalArgumentException rather than reading past its end later.
+ * @throws IllegalArgumentException if [bytes] is not a run batch this version can read
+ */
+class RunBatch(val bytes: ByteArray) {
+
+    /** Number of runs. */
+    val size: Int
+
+    private val recordSize: Int
+    private val stringCount: Int
+    private val stringOffsets: Int
+    private val stringData: Int
+
+    init {
+        require(bytes.size >= RunBatchCodec.HEADER_SIZE && RunBatchCodec.MAGIC.indices.all { bytes[it] == RunBatchCodec.MAGIC[it] }) {
+            "Not a run batch"
+        }
+        require(RunBatchCodec.readShort(bytes, 8) >= 1) { "Unknown run batch version" }
+        recordSize = RunBatchCodec.readShort(bytes, 10)
+        require(recordSize >= RunBatchCodec.RECORD_SIZE) { "Run batch records are too short" }
+        size = RunBatchCodec.readInt(bytes, 12)
+        val stringsOffset = RunBatchCodec.readInt(bytes, 16)
+        val stringsLength = RunBatchCodec.readInt(bytes, 20)
+        require(size >= 0 && stringsLength >= 4) { "Run batch header is corrupt" }
+        require(RunBatchCodec.HEADER_SIZE + size.toLong() * recordSize <= stringsOffset) { "Run batch is truncated" }
+        require(stringsOffset.toLong() + stringsLength <= bytes.size) { "Run batch is truncated" }
+        stringCount = RunBatchCodec.readInt(bytes, stringsOffset)
+        require(stringCount >= 0 && 4L * (stringCount + 2) <= stringsLength) { "Run batch string table is truncated" }
+        stringOffsets = stringsOffset + 4
+        stringData = stringOffsets + 4 * (stringCount + 1)
+        // Offsets must climb from 0 to at most the string bytes, so string() stays inside the table
+        val stringBytes = stringsOffset + stringsLength - stringData
+        var previous = 0
+        for (i in 0..stringCount) {
+            val offset = RunBatchCodec.readInt(bytes, stringOffsets + 4 * i)
+            require(offset >= previous && offset <= stringBytes && (i > 0 || offset == 0)) { "Run batch string table is corrupt" }
+            previous = offset
+        }
+    }
+
+    fun startedAtEpochMs(index: Int): Long = long(index, RunBatchCodec.OFFSET_STARTED_AT)
+
+    fun endedAtEpochMs(index: Int): Long = long(index, RunBatchCodec.OFFSET_ENDED_AT)
+
+    fun distanceMeters(index: Int): Double = Double.fromBits(long(index, RunBatchCodec.OFFSET_DISTANCE))
+
+    fun avgPaceSecPerKm(index: Int): Double = Double.fromBits(long(index, RunBatchCodec.OFFSET_AVG_PACE))
+
+    fun ppi(index: Int): Double? = Double.fromBits(long(index, RunBatchCodec.OFFSET_PPI)).takeUnless { it.isNaN() }
+
+    fun elapsedSeconds(index: Int): Int = int(index, RunBatchCodec.OFFSET_ELAPSED)
+
+    fun avgHr(index: Int): Int? = int(index, RunBatchCodec.OFFSET_AVG_HR).takeUnless { it < 0 }
+
+    fun id(index: Int): String = requireNotNull(string(int(index, RunBatchCodec.OFFSET_ID))) { "Run $index has no id" }
+
+    fun source(index: Int): String = requireNotNull(string(int(index, RunBatchCodec.OFFSET_SOURCE))) { "Run $index has no source" }
+
+    fun notes(index: Int): String? = string(int(index, RunBatchCodec.OFFSET_NOTES))
+
+    fun ppiCurveVersion(index: Int): String? = string(int(index, RunBatchCodec.OFFSET_CURVE_VERSION))
+
+    /**
+     * Best effort in one of the [BestsBand.STANDARD] bands.
+     * @param band Index into [BestsBand.STANDARD]
+     */
+    fun bestEffortSeconds(index: Int, band: Int): Int? {
+        require(band in BestsBand.STANDARD.indices) { "Unknown band $band" }
+        return int(index, RunBatchCodec.OFFSET_BEST_EFFORTS + 4 * band).takeUnless { it < 0 }
+    }
+
+    /** Unpack one run; its pace curve is not in the batch and comes back empty. */
+    operator fun get(index: Int): RunDTO = RunDTO(
+        id = id(index),
+        source = source(index),
+        startedAtEpochMs = startedAtEpochMs(index),
+        endedAtEpochMs = endedAtEpochMs(index),
+        distanceMeters = distanceMeters(index),
+        elapsedSeconds = elapsedSeconds(index),
+        avgPaceSecPerKm = avgPaceSecPerKm(index),
+        avgHr = avgHr(index),
+        ppi = ppi(index),
+        notes = notes(index),
+        ppiCurveVersion = ppiCurveVersion(index),
+        bestEffortsSec = BestsBand.STANDARD.indices
+            .mapNotNull { band -> bestEffortSeconds(index, band)?.let { BestsBand.STANDARD[band].name to it } }
+            .toMap()
+    )
+
+    fun toList(): List<RunDTO> = List(size) { get(it) }
+
+    private fun recordAt(index: Int): Int {
+        if (index !in 0 until size) throw IndexOutOfBoundsException("Run $index of $size")
+        return RunBatchCodec.HEADER_SIZE + index * recordSize
+    }
+
+    private fun long(index: Int, field: Int): Long = RunBatchCodec.readLong(bytes, recordAt(index) + field)
+
+    private fun int(index: Int, field: Int): Int = RunBatchCodec.readInt(bytes, recordAt(index) + field)
+
+    private fun string(stringIndex: Int): String? {
+        if (stringIndex < 0) return null
+        require(stringIndex < stringCount) { "Run batch string $stringIndex of $stringCount" }
+        val from = RunBatchCodec.readInt(bytes, stringOffsets + 4 * stringIndex)
+        val to = RunBatchCodec.readInt(bytes, stringOffsets + 4 * (stringIndex + 1))
+        return bytes.decodeToString(stringData + from, stringData + to)
+    }
+
+    companion object {
+        fun of(runs: List<RunDTO>): RunBatch = RunBatch(RunBatchCodec.encode(runs))
+    }
+}
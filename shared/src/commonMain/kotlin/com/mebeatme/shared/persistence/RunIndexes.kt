@@ -0,0 +1,62 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.core.FlatBests
+import com.mebeatme.shared.core.PaceEnvelope
+import com.mebeatme.shared.core.merge
+import com.mebeatme.shared.model.RunDTO
+import kotlinx.datetime.TimeZone
+
+/**
+ * Secondary indexes every JsonRunStore actual keeps next to its run list.
+ * Each write goes to all of them, so reads never have to scan the history.
+ * @param timeZone The user's zone, whose calendar days the rollups follow
+ */
+internal class RunIndexes(timeZone: TimeZone) {
+    val bests = BestsIndex()
+    val ppiWindows = PpiWindowIndex()
+    val rollups = RunRollups(timeZone)
+    val paceEnvelope = PaceEnvelope()
+    val sketches = RunSketches()
+
+    fun upsert(run: RunDTO) {
+        bests.upsert(run)
+        ppiWindows.upsert(run)
+        rollups.upsert(run)
+        paceEnvelope.merge(run)
+        sketches.upsert(run)
+    }
+
+    fun remove(id: String) {
+        bests.remove(id)
+        ppiWindows.remove(id)
+        rollups.remove(id)
+        paceEnvelope.remove(id)
+        sketches.remove(id)
+    }
+
+    fun clear() {
+        bests.clear()
+        ppiWindows.clear()
+        rollups.clear()
+        paceEnvelope.clear()
+        sketches.clear()
+    }
+
+    fun rebuild(runs: List<RunDTO>) {
+        clear()
+        runs.forEach { upsert(it) }
+    }
+
+    /**
+     * The getBests result as a [FlatBests] record, written through [putInt] and [putDouble]
+     * straight from the indexes without building a BestsDTO.
+     */
+    inline fun writeFlatBests(
+        nowMs: Long,
+        sinceMs: Long,
+        putInt: (at: Int, value: Int) -> Unit,
+        putDouble: (at: Int, value: Double) -> Unit
+    ) {
+        FlatBests.write({ band -> bests.bestSecondsAt(band, sinceMs) }, ppiWindows.maxPpiInWindowOrNaN(nowMs, 90), putInt, putDouble)
+    }
+}
@@ -0,0 +1,360 @@
+package com.mebeatme.shared.persistence
+
+import kotlinx.serialization.KSerializer
+import kotlinx.serialization.json.Json
+
+/**
+ * Operation recorded in the run log.
+ */
+enum class RunLogOp(val code: Byte) {
+    /** Payload: the run as compact JSON */
+    UPSERT(1),
+    /** Payload: the run id as UTF-8 */
+    DELETE(2),
+    /** No payload */
+    CLEAR(3);
+
+    companion object {
+        fun fromCode(code: Byte): RunLogOp? = values().find { it.code == code }
+    }
+}
+
+/**
+ * One log record. [seq] increases strictly through a log.
+ */
+class RunLogRecord(val seq: Long, val op: RunLogOp, val payload: ByteArray)
+
+/**
+ * Byte layout of the append-only run log shared by every platform's store.
+ *
+ * A log is an 8-byte magic header followed by records, all integers big-endian:
+ *
+ *     [u32 payload length][u32 CRC-32C of seq..payload][u64 seq][u8 op][payload]
+ *
+ * A record is valid if it is complete, its op is known, its checksum matches and its
+ * sequence number is above the previous valid record's. Recovery is one sequential
+ * scan of the framing; payloads are not parsed. When a record is invalid, decoding
+ * looks for the next valid record further on: if there is none, the bad bytes are a
+ * torn tail from a crash mid-append and [Decoded.validLength] says where to truncate;
+ * if there is one, a record in the middle was damaged, only that record is dropped and
+ * [Decoded.needsRewrite] asks for the log to be rewritten without it. Dropped spans are
+ * counted in [Decoded.damagedRecords]: a lost DELETE or CLEAR brings runs back, so
+ * [RunLogFile] keeps the original file aside before rewriting and reports the loss.
+ *
+ * Logs from before CRC-32C (header version 1, CRC-32) are still read, and flagged for
+ * rewriting in the current format.
+ */
+object RunLogCodec {
+    val MAGIC: ByteArray = byteArrayOf('M'.code.toByte(), 'B'.code.toByte(), 'M'.code.toByte(), 'L'.code.toByte(), 'O'.code.toByte(), 'G'.code.toByte(), 0, 2)
+
+    private val MAGIC_V1: ByteArray = MAGIC.copyOf().also { it[7] = 1 }
+
+    /** Bytes a record adds on top of its payload. */
+    const val RECORD_OVERHEAD = 4 + 4 + 8 + 1
+
+    /** Larger lengths are treated as corruption rather than allocated. */
+    const val MAX_PAYLOAD = 16 * 1024 * 1024
+
+    /**
+     * @param records Intact records in log order
+     * @param validLength Bytes up to the end of the last intact record, header included
+     * @param needsRewrite The file holds damaged records before [validLength] or an older
+     *   format, so it should be replaced by [MAGIC] plus [records] rather than truncated
+     * @param damagedRecords Damaged spans skipped before [validLength], each at least one lost record
+     * @param damagedBytes Bytes in those spans
+     */
+    class Decoded(
+        val records: List<RunLogRecord>,
+        val validLength: Int,
+        val needsRewrite: Boolean = false,
+        val damagedRecords: Int = 0,
+        val damagedBytes: Int = 0
+    )
+
+    fun encode(record: RunLogRecord): ByteArray {
+        val out = ByteArray(RECORD_OVERHEAD + record.payload.size)
+        writeInt(out, 0, record.payload.size)
+        writeLong(out, 8, record.seq)
+        out[16] = record.op.code
+        record.payload.copyInto(out, 17)
+        writeInt(out, 4, Crc32c.compute(out, 8, out.size))
+        return out
+    }
+
+    fun encodeAll(records: List<RunLogRecord>): ByteArray {
+        val parts = records.map { encode(it) }
+        val out = ByteArray(parts.sumOf { it.size })
+        var position = 0
+        parts.forEach { part ->
+            part.copyInto(out, position)
+            position += part.size
+        }
+        return out
+    }
+
+    /**
+     * Decode a whole log file.
+     * @throws IllegalArgumentException if [bytes] does not start with a run log header
+     */
+    fun decode(bytes: ByteArray): Decoded {
+        val current = hasHeader(bytes, MAGIC)
+        require(current || hasHeader(bytes, MAGIC_V1)) { "Not a run log" }
+        val checksum: (ByteArray, Int, Int) -> Int = if (current) Crc32c::compute else Crc32::compute
+        val records = mutableListOf<RunLogRecord>()
+        var position = MAGIC.size
+        var validLength = position
+        var lastSeq = Long.MIN_VALUE
+        var damagedRecords = 0
+        var damagedBytes = 0
+        while (bytes.size - position >= RECORD_OVERHEAD) {
+            var end = recordEnd(bytes, position, lastSeq, checksum)
+            if (end < 0) {
+                // Resynchronize on the next valid record, if any; otherwise this is the torn tail
+                val next = (position + 1..bytes.size - RECORD_OVERHEAD).firstOrNull { recordEnd(bytes, it, lastSeq, checksum) >= 0 } ?: break
+                damagedRecords++
+                damagedBytes += next - position
+                position = next
+                end = recordEnd(bytes, position, lastSeq, checksum)
+            }
+            val seq = readLong(bytes, position + 8)
+            records.add(RunLogRecord(seq, RunLogOp.fromCode(bytes[position + 16])!!, bytes.copyOfRange(position + 17, end)))
+            lastSeq = seq
+            position = end
+            validLength = end
+        }
+        return Decoded(records, validLength, damagedRecords > 0 || !current, damagedRecords, damagedBytes)
+    }
+
+    /**
+     * Size of the record at [at] as its length field gives it, for reading a record back by offset.
+     * @param bytes At least [RECORD_OVERHEAD] bytes from [at]
+     * @return Header plus payload bytes, or -1 if the length is not plausible
+     */
+    fun recordSize(bytes: ByteArray, at: Int = 0): Int {
+        val length = readInt(bytes, at)
+        return if (length < 0 || length > MAX_PAYLOAD) -1 else RECORD_OVERHEAD + length
+    }
+
+    /**
+     * Decode one current-format record, e.g. one read back by offset from a file of them.
+     * @return The record, or null if it is incomplete, has an unknown op or fails its checksum
+     */
+    fun decodeRecord(bytes: ByteArray, at: Int = 0): RunLogRecord? {
+        if (bytes.size - at < RECORD_OVERHEAD) return null
+        val end = recordEnd(bytes, at, Long.MIN_VALUE, Crc32c::compute)
+        if (end < 0) return null
+        return RunLogRecord(readLong(bytes, at + 8), RunLogOp.fromCode(bytes[at + 16])!!, bytes.copyOfRange(at + 17, end))
+    }
+
+    // End of the valid record at [position], or -1; cheap field checks come before the checksum
+    private fun recordEnd(bytes: ByteArray, position: Int, lastSeq: Long, checksum: (ByteArray, Int, Int) -> Int): Int {
+        val length = readInt(bytes, position)
+        if (length < 0 || length > MAX_PAYLOAD || bytes.size - position - RECORD_OVERHEAD < length) return -1
+        if (RunLogOp.fromCode(bytes[position + 16]) == null) return -1
+        val end = position + RECORD_OVERHEAD + length
+        if (checksum(bytes, position + 8, end) != readInt(bytes, position + 4)) return -1
+        if (readLong(bytes, position + 8) <= lastSeq) return -1
+        return end
+    }
+
+    private fun hasHeader(bytes: ByteArray, magic: ByteArray): Boolean =
+        bytes.size >= magic.size && magic.indices.all { bytes[it] == magic[it] }
+
+    private fun writeInt(out: ByteArray, at: Int, value: Int) {
+        for (i in 0 until 4) out[at + i] = (value ushr (24 - 8 * i)).toByte()
+    }
+
+    private fun writeLong(out: ByteArray, at: Int, value: Long) {
+        for (i in 0 until 8) out[at + i] = (value ushr (56 - 8 * i)).toByte()
+    }
+
+    private fun readInt(bytes: ByteArray, at: Int): Int {
+        var value = 0
+        for (i in 0 until 4) value = (value shl 8) or (bytes[at + i].toInt() and 0xFF)
+        return value
+    }
+
+    private fun readLong(bytes: ByteArray, at: Int): Long {
+        var value = 0L
+        for (i in 0 until 8) value = (value shl 8) or (bytes[at + i].toLong() and 0xFF)
+        return value
+    }
+}
+
+/**
+ * CRC-32 (IEEE 802.3), table-driven so it runs the same on every target.
+ * Only used to read version 1 logs; current logs use [Crc32c].
+ */
+internal object Crc32 {
+    private val table = IntArray(256) { n ->
+        var c = n
+        repeat(8) { c = if (c and 1 != 0) (c ushr 1) xor 0xEDB88320.toInt() else c ushr 1 }
+        c
+    }
+
+    fun compute(bytes: ByteArray, from: Int = 0, to: Int = bytes.size): Int {
+        var crc = -1
+        for (i in from until to) crc = table[(crc xor bytes[i].toInt()) and 0xFF] xor (crc ushr 8)
+        return crc.inv()
+    }
+}
+
+/**
+ * CRC-32C (Castagnoli), which catches more of the multi-bit errors seen on storage
+ * than CRC-32. Slicing-by-8: eight table lookups per eight bytes, in pure Kotlin so
+ * every target computes the same value.
+ */
+internal object Crc32c {
+    private val tables = Array(8) { IntArray(256) }
+
+    init {
+        for (n in 0 until 256) {
+            var c = n
+            repeat(8) { c = if (c and 1 != 0) (c ushr 1) xor 0x82F63B78.toInt() else c ushr 1 }
+            tables[0][n] = c
+        }
+        for (n in 0 until 256) {
+            for (k in 1 until 8) tables[k][n] = (tables[k - 1][n] ushr 8) xor tables[0][tables[k - 1][n] and 0xFF]
+        }
+    }
+
+    fun compute(bytes: ByteArray, from: Int = 0, to: Int = bytes.size): Int {
+        val t0 = tables[0]
+        val t1 = tables[1]
+        val t2 = tables[2]
+        val t3 = tables[3]
+        val t4 = tables[4]
+        val t5 = tables[5]
+        val t6 = tables[6]
+        val t7 = tables[7]
+        var crc = -1
+        var i = from
+        while (to - i >= 8) {
+            val one = crc xor littleEndianInt(bytes, i)
+            val two = littleEndianInt(bytes, i + 4)
+            crc = t7[one and 0xFF] xor t6[(one ushr 8) and 0xFF] xor t5[(one ushr 16) and 0xFF] xor t4[one ushr 24] xor
+                t3[two and 0xFF] xor t2[(two ushr 8) and 0xFF] xor t1[(two ushr 16) and 0xFF] xor t0[two ushr 24]
+            i += 8
+        }
+        while (i < to) {
+            crc = t0[(crc xor bytes[i].toInt()) and 0xFF] xor (crc ushr 8)
+            i++
+        }
+        return crc.inv()
+    }
+
+    private fun littleEndianInt(bytes: ByteArray, at: Int): Int =
+        (bytes[at].toInt() and 0xFF) or ((bytes[at + 1].toInt() and 0xFF) shl 8) or
+            ((bytes[at + 2].toInt() and 0xFF) shl 16) or ((bytes[at + 3].toInt() and 0xFF) shl 24)
+}
+
+/**
+ * Typed records and replay for one run type, so the model and API stores share the log format.
+ * Assigns sequence numbers; not synchronized, the owning store serializes writes.
+ * @param idOf Run id, the key upserts and deletes refer to
+ */
+class RunLog<T>(private val serializer: KSerializer<T>, private val idOf: (T) -> String) {
+
+    private val json = Json { ignoreUnknownKeys = true }
+
+    /** Sequence number of the last record created or replayed. */
+    var lastSeq: Long = 0L
+        private set
+
+    fun upsert(run: T): RunLogRecord =
+        RunLogRecord(++lastSeq, RunLogOp.UPSERT, json.encodeToString(serializer, run).encodeToByteArray())
+
+    fun delete(id: String): RunLogRecord = RunLogRecord(++lastSeq, RunLogOp.DELETE, id.encodeToByteArray())
+
+    fun clear(): RunLogRecord = RunLogRecord(++lastSeq, RunLogOp.CLEAR, ByteArray(0))
+
+    /**
+     * Apply [records] in order and continue numbering after the last one.
+     * @return Surviving runs; an upsert of a known id keeps that run's position, as upsertAll does
+     */
+    fun replay(records: List<RunLogRecord>): List<T> {
+        val runs = LinkedHashMap<String, T>()
+        replay(records, upsert = { runs[idOf(it)] = it }, delete = { runs.remove(it) }, clear = { runs.clear() })
+        return runs.values.toList()
+    }
+
+    /**
+     * Apply [records] in order on top of existing state, e.g. a snapshot followed by several log segments.
+     * Replaying records the state already reflects leaves it unchanged, so a crash between writing
+     * a snapshot and deleting the segments it covers is harmless.
+     */
+    fun replay(records: List<RunLogRecord>, upsert: (T) -> Unit, delete: (String) -> Unit, clear: () -> Unit) {
+        records.forEach { record ->
+            when (record.op) {
+                RunLogOp.UPSERT -> upsert(json.decodeFromString(serializer, record.payload.decodeToString()))
+                RunLogOp.DELETE -> delete(record.payload.decodeToString())
+                RunLogOp.CLEAR -> clear()
+            }
+            lastSeq = maxOf(lastSeq, record.seq)
+        }
+    }
+}
+
+/**
+ * What [RunLogFile.open] had to repair, summed over the files a store opened.
+ * @param damagedRecords Damaged spans dropped from the middle of a log, each at least one record
+ * @param damagedBytes Bytes in those spans
+ * @param tornBytes Bytes of incomplete records cut from the end of a log
+ * @param keptAside Copies of damaged logs as they were before the rewrite, for manual recovery
+ */
+data class RunLogRecovery(
+    val damagedRecords: Int = 0,
+    val damagedBytes: Long = 0L,
+    val tornBytes: Long = 0L,
+    val keptAside: List<String> = emptyList()
+) {
+    operator fun plus(other: RunLogRecovery): RunLogRecovery = RunLogRecovery(
+        damagedRecords + other.damagedRecords,
+        damagedBytes + other.damagedBytes,
+        tornBytes + other.tornBytes,
+        keptAside + other.keptAside
+    )
+}
+
+/**
+ * Where [RunLogFile.open] keeps a damaged log before rewriting it: "<path>.corrupt",
+ * numbered when earlier copies exist so none is overwritten.
+ */
+internal fun corruptCopyPath(path: String, exists: (String) -> Boolean): String {
+    var candidate = "$path.corrupt"
+    var n = 1
+    while (exists(candidate)) candidate = "$path.corrupt.${n++}"
+    return candidate
+}
+
+/**
+ * Append-only file holding a run log, opened once per store.
+ * Actuals use java.nio on the JVM and Android and NSFileHandle on iOS and watchOS.
+ */
+expect class RunLogFile(path: String) {
+
+    /**
+     * Create the file with its header if missing and read every intact record. A torn tail
+     * is cut off; a log with damaged records in the middle or in an older format is replaced
+     * atomically by one holding just the intact records. A damaged log is first copied
+     * aside (see [corruptCopyPath]); [recovery] reports what was dropped.
+     * @throws IllegalArgumentException if the file exists but is not a run log
+     */
+    fun open(): List<RunLogRecord>
+
+    /** Repairs made by the last [open]. */
+    val recovery: RunLogRecovery
+
+    /**
+     * Append records with a single write and flush them to the device before returning.
+     */
+    fun append(records: List<RunLogRecord>)
+
+    /**
+     * Replace the log atomically by an empty one, once its records are saved elsewhere
+     * (a tiered store's cold segment). Appends continue into the new file.
+     */
+    fun reset()
+
+    fun close()
+}
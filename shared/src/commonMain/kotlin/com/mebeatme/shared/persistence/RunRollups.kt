@@ -0,0 +1,192 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.DistanceBucket
+import com.mebeatme.shared.model.RunDTO
+import kotlinx.datetime.DayOfWeek
+import kotlinx.datetime.Instant
+import kotlinx.datetime.LocalDate
+import kotlinx.datetime.TimeZone
+import kotlinx.datetime.atStartOfDayIn
+import kotlinx.datetime.isoDayNumber
+import kotlinx.datetime.toLocalDateTime
+import kotlinx.serialization.Serializable
+
+/**
+ * Calendar granularity of a rollup row. Weeks are ISO weeks starting on Monday.
+ */
+@Serializable
+enum class RollupPeriod {
+    DAY,
+    WEEK,
+    MONTH
+}
+
+/**
+ * Aggregates for the runs started in one day, week or month.
+ * @param startEpochMs Start of the period in the rollup time zone
+ * @param maxPpi Highest PPI in the period, null if no run has one
+ * @param bestPaceSecPerKm Fastest average pace in the period
+ * @param bucketCounts Runs per distance bucket (buckets without runs are omitted)
+ */
+@Serializable
+data class RollupRow(
+    val period: RollupPeriod,
+    val startEpochMs: Long,
+    val runCount: Int,
+    val totalDistanceMeters: Double,
+    val totalSeconds: Long,
+    val maxPpi: Double?,
+    val bestPaceSecPerKm: Double?,
+    val bucketCounts: Map<DistanceBucket, Int>
+)
+
+/**
+ * Materialized daily, weekly and monthly rollups, maintained incrementally as runs are stored and deleted.
+ *
+ * A write re-aggregates the run's day from that day's runs, then its week from seven
+ * day rows and its month from at most 31, so the cost of a write does not depend on
+ * the size of the history. Range queries touch one map entry per period in the range,
+ * which is what dashboards read instead of the raw run list.
+ *
+ * Not synchronized; the owning store guards it with its own lock.
+ */
+class RunRollups(private val timeZone: TimeZone = TimeZone.UTC) {
+
+    private class Member(
+        val day: Int,
+        val distanceMeters: Double,
+        val elapsedSeconds: Int,
+        val ppi: Double?,
+        val bucket: DistanceBucket?
+    )
+
+    private val members = HashMap<String, Member>()
+    private val dayMembers = HashMap<Int, MutableSet<String>>()
+    private val days = HashMap<Int, RollupRow>()
+    private val weeks = HashMap<Int, RollupRow>()
+    private val months = HashMap<Int, RollupRow>()
+
+    /**
+     * Insert a run, or move it if it was rolled up before with different values.
+     */
+    fun upsert(id: String, startedAtEpochMs: Long, distanceMeters: Double, elapsedSeconds: Int, ppi: Double?) {
+        remove(id)
+        val day = dayOf(startedAtEpochMs)
+        val bucket = DistanceBucket.values().find { it.contains(distanceMeters / 1000.0) }
+        members[id] = Member(day, distanceMeters, elapsedSeconds, ppi?.takeUnless { it.isNaN() }, bucket)
+        dayMembers.getOrPut(day) { mutableSetOf() }.add(id)
+        refresh(day)
+    }
+
+    /**
+     * Remove a run.
+     * @return true if the run was rolled up
+     */
+    fun remove(id: String): Boolean {
+        val member = members.remove(id) ?: return false
+        dayMembers[member.day]?.let { ids ->
+            ids.remove(id)
+            if (ids.isEmpty()) dayMembers.remove(member.day)
+        }
+        refresh(member.day)
+        return true
+    }
+
+    fun clear() {
+        members.clear()
+        dayMembers.clear()
+        days.clear()
+        weeks.clear()
+        months.clear()
+    }
+
+    /**
+     * Rollup rows whose period overlaps [fromMs, toMs], oldest first. Empty periods are skipped.
+     */
+    fun rows(period: RollupPeriod, fromMs: Long, toMs: Long): List<RollupRow> {
+        if (fromMs > toMs) return emptyList()
+        val firstDay = dayOf(fromMs)
+        val lastDay = dayOf(toMs)
+        return when (period) {
+            RollupPeriod.DAY -> rowsInRange(days, firstDay, lastDay, 1)
+            RollupPeriod.WEEK -> rowsInRange(weeks, weekOf(firstDay), weekOf(lastDay), 7)
+            RollupPeriod.MONTH -> rowsInRange(months, monthOf(firstDay), monthOf(lastDay), 1)
+        }
+    }
+
+    // Probe key by key for dashboard-sized ranges; sort the populated keys for open-ended ones
+    private fun rowsInRange(rows: Map<Int, RollupRow>, firstKey: Int, lastKey: Int, step: Int): List<RollupRow> {
+        val span = (lastKey.toLong() - firstKey) / step
+        if (span > rows.size) {
+            return rows.entries.filter { it.key in firstKey..lastKey }.sortedBy { it.key }.map { it.value }
+        }
+        return (firstKey..lastKey step step).mapNotNull { rows[it] }
+    }
+
+    private fun refresh(day: Int) {
+        val ids = dayMembers[day].orEmpty()
+        if (ids.isEmpty()) days.remove(day) else days[day] = aggregateMembers(day, ids.mapNotNull { members[it] })
+
+        val week = weekOf(day)
+        val weekRow = combine(RollupPeriod.WEEK, startOfDay(week), (week until week + 7).mapNotNull { days[it] })
+        if (weekRow == null) weeks.remove(week) else weeks[week] = weekRow
+
+        val month = monthOf(day)
+        val firstOfMonth = LocalDate(month / 12, month % 12 + 1, 1)
+        val monthDays = firstOfMonth.toEpochDays() until nextMonth(firstOfMonth).toEpochDays()
+        val monthRow = combine(RollupPeriod.MONTH, startOfDay(firstOfMonth.toEpochDays()), monthDays.mapNotNull { days[it] })
+        if (monthRow == null) months.remove(month) else months[month] = monthRow
+    }
+
+    private fun aggregateMembers(day: Int, dayRuns: List<Member>): RollupRow {
+        val buckets = mutableMapOf<DistanceBucket, Int>()
+        dayRuns.forEach { run -> run.bucket?.let { buckets[it] = (buckets[it] ?: 0) + 1 } }
+        return RollupRow(
+            period = RollupPeriod.DAY,
+            startEpochMs = startOfDay(day),
+            runCount = dayRuns.size,
+            totalDistanceMeters = dayRuns.sumOf { it.distanceMeters },
+            totalSeconds = dayRuns.sumOf { it.elapsedSeconds.toLong() },
+            maxPpi = dayRuns.mapNotNull { it.ppi }.maxOrNull(),
+            bestPaceSecPerKm = dayRuns.filter { it.distanceMeters > 0 }.minOfOrNull { it.elapsedSeconds / (it.distanceMeters / 1000.0) },
+            bucketCounts = buckets
+        )
+    }
+
+    private fun combine(period: RollupPeriod, startEpochMs: Long, rows: List<RollupRow>): RollupRow? {
+        if (rows.isEmpty()) return null
+        val buckets = mutableMapOf<DistanceBucket, Int>()
+        rows.forEach { row -> row.bucketCounts.forEach { (bucket, count) -> buckets[bucket] = (buckets[bucket] ?: 0) + count } }
+        return RollupRow(
+            period = period,
+            startEpochMs = startEpochMs,
+            runCount = rows.sumOf { it.runCount },
+            totalDistanceMeters = rows.sumOf { it.totalDistanceMeters },
+            totalSeconds = rows.sumOf { it.totalSeconds },
+            maxPpi = rows.mapNotNull { it.maxPpi }.maxOrNull(),
+            bestPaceSecPerKm = rows.mapNotNull { it.bestPaceSecPerKm }.minOrNull(),
+            bucketCounts = buckets
+        )
+    }
+
+    // Keys: epoch day for days, epoch day of the Monday for weeks, year * 12 + month - 1 for months
+    private fun dayOf(epochMs: Long): Int =
+        Instant.fromEpochMilliseconds(epochMs).toLocalDateTime(timeZone).date.toEpochDays()
+
+    private fun weekOf(day: Int): Int =
+        day - (LocalDate.fromEpochDays(day).dayOfWeek.isoDayNumber - DayOfWeek.MONDAY.isoDayNumber)
+
+    private fun monthOf(day: Int): Int {
+        val date = LocalDate.fromEpochDays(day)
+        return date.year * 12 + date.monthNumber - 1
+    }
+
+    private fun nextMonth(firstOfMonth: LocalDate): LocalDate =
+        if (firstOfMonth.monthNumber == 12) LocalDate(firstOfMonth.year + 1, 1, 1) else LocalDate(firstOfMonth.year, firstOfMonth.monthNumber + 1, 1)
+
+    private fun startOfDay(day: Int): Long =
+        LocalDate.fromEpochDays(day).atStartOfDayIn(timeZone).toEpochMilliseconds()
+}
+
+internal fun RunRollups.upsert(run: RunDTO) =
+    upsert(run.id, run.startedAtEpochMs, run.distanceMeters, run.elapsedSeconds, run.ppi)
@@ -0,0 +1,159 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.core.QuantileSketch
+import com.mebeatme.shared.model.DistanceBucket
+import com.mebeatme.shared.model.RunDTO
+import kotlinx.serialization.Serializable
+import kotlinx.serialization.Transient
+
+/**
+ * Per-run value a [RunSketches] tracks.
+ */
+@Serializable
+enum class RunMetric {
+    PPI,
+    PACE
+}
+
+/**
+ * Quantile sketches of PPI and pace per distance bucket, updated as runs are stored and deleted.
+ *
+ * Answers "where does this run rank among my 3–8 km runs" and population percentiles
+ * without sorting runs per request; see [QuantileSketch] for the error bound. The
+ * serialized form holds only the sketches, so it stays a few kilobytes however many
+ * runs it covers, and sketches from other devices or server shards fold in with [merge]
+ * (or, keyed by source, through [MergedRunSketches]). Stores keep them in memory only and
+ * rebuild them from the runs on open.
+ *
+ * Runs are remembered by id so [upsert] and [remove] can take back what they added.
+ * That bookkeeping is not serialized: a decoded or merged sketch still answers
+ * queries, but only runs upserted into this instance can be removed from it.
+ *
+ * Not synchronized; the owning store guards it with its own lock.
+ */
+@Serializable
+class RunSketches(
+    val relativeAccuracy: Double = QuantileSketch.DEFAULT_ACCURACY
+) {
+
+    private val ppi = mutableMapOf<DistanceBucket, QuantileSketch>()
+    private val pace = mutableMapOf<DistanceBucket, QuantileSketch>()
+
+    private class Member(val bucket: DistanceBucket, val ppi: Double?, val paceSecPerKm: Double)
+
+    @Transient
+    private val members = HashMap<String, Member>()
+
+    /**
+     * Insert a run, or replace what was added for it before.
+     */
+    fun upsert(id: String, distanceMeters: Double, ppi: Double?, paceSecPerKm: Double) {
+        remove(id)
+        val bucket = DistanceBucket.values().find { it.contains(distanceMeters / 1000.0) } ?: return
+        val member = Member(bucket, ppi?.takeUnless { it.isNaN() }, paceSecPerKm)
+        member.ppi?.let { sketch(RunMetric.PPI, bucket).add(it) }
+        sketch(RunMetric.PACE, bucket).add(member.paceSecPerKm)
+        members[id] = member
+    }
+
+    /**
+     * Remove a run upserted into this instance.
+     * @return true if the run was known
+     */
+    fun remove(id: String): Boolean {
+        val member = members.remove(id) ?: return false
+        member.ppi?.let { sketch(RunMetric.PPI, member.bucket).remove(it) }
+        sketch(RunMetric.PACE, member.bucket).remove(member.paceSecPerKm)
+        return true
+    }
+
+    fun clear() {
+        ppi.clear()
+        pace.clear()
+        members.clear()
+    }
+
+    /**
+     * Fold another set of sketches (another device, another shard) into this one.
+     */
+    fun merge(other: RunSketches) {
+        require(other.relativeAccuracy == relativeAccuracy) { "Cannot merge sketches with different accuracy" }
+        other.ppi.forEach { (bucket, sketch) -> sketch(RunMetric.PPI, bucket).merge(sketch) }
+        other.pace.forEach { (bucket, sketch) -> sketch(RunMetric.PACE, bucket).merge(sketch) }
+    }
+
+    /**
+     * Sketches only, for export; see the class comment on removals.
+     */
+    fun copy(): RunSketches = RunSketches(relativeAccuracy).also { it.merge(this) }
+
+    fun count(bucket: DistanceBucket, metric: RunMetric): Long = sketches(metric)[bucket]?.count ?: 0L
+
+    /**
+     * Value at quantile [q] for a bucket, e.g. q = 0.9 for the 90th percentile PPI.
+     * @return null if the bucket has no runs
+     */
+    fun quantile(bucket: DistanceBucket, metric: RunMetric, q: Double): Double? =
+        sketches(metric)[bucket]?.quantile(q)
+
+    /**
+     * Fraction of runs in the bucket at or below [value].
+     * For PPI, 0.9 means top 10%; for pace (seconds per km) lower is faster, so 0.1 means top 10%.
+     * @return null if the bucket has no runs
+     */
+    fun rank(bucket: DistanceBucket, metric: RunMetric, value: Double): Double? =
+        sketches(metric)[bucket]?.rank(value)
+
+    private fun sketches(metric: RunMetric): MutableMap<DistanceBucket, QuantileSketch> =
+        if (metric == RunMetric.PPI) ppi else pace
+
+    private fun sketch(metric: RunMetric, bucket: DistanceBucket): QuantileSketch =
+        sketches(metric).getOrPut(bucket) { QuantileSketch(relativeAccuracy) }
+}
+
+internal fun RunSketches.upsert(run: RunDTO) =
+    upsert(run.id, run.distanceMeters, run.ppi, run.avgPaceSecPerKm)
+
+/**
+ * [local] sketches plus the latest export of each other source (a device, a server shard).
+ *
+ * A source's export already holds everything it has seen, so [put] replaces what that
+ * source sent before instead of adding to it: pushing the same sketches twice counts
+ * their runs once. Sources never re-export what they received, only their own sketches.
+ *
+ * Not synchronized; the owner guards it with the same lock as [local].
+ */
+class MergedRunSketches(private val local: RunSketches) {
+
+    private val sources = HashMap<String, RunSketches>()
+    private var combined: RunSketches? = null
+
+    val sourceIds: Set<String> get() = sources.keys
+
+    /**
+     * Replace what [source] sent before with [sketches].
+     */
+    fun put(source: String, sketches: RunSketches) {
+        require(source.isNotBlank()) { "Sketch source id must not be blank" }
+        require(sketches.relativeAccuracy == local.relativeAccuracy) { "Cannot merge sketches with different accuracy" }
+        sources[source] = sketches.copy()
+        combined = null
+    }
+
+    fun remove(source: String): Boolean = (sources.remove(source) != null).also { if (it) combined = null }
+
+    /**
+     * Call after changing [local], so the next query sees it.
+     */
+    fun invalidate() {
+        combined = null
+    }
+
+    /**
+     * Local and received sketches folded together, rebuilt only after a change.
+     */
+    fun combined(): RunSketches = combined ?: local.copy().also { merged ->
+        sources.values.forEach { merged.merge(it) }
+        combined = merged
+    }
+}
@@ -0,0 +1,212 @@
+package com.mebeatme.shared.persistence
+
+/**
+ * Runs in insertion order with an id index, so upserts, lookups and deletes are O(1) expected.
+ *
+ * Runs sit in a slot vector; a delete leaves a hole instead of shifting later runs,
+ * and the vector is compacted once holes outnumber live runs, which keeps deletes
+ * amortized O(1). Replacing a run keeps its slot, so iteration order matches the
+ * order runs were first stored, as the list-based stores had it.
+ *
+ * Not synchronized; the owning store guards it with its own lock.
+ */
+internal class RunTable<T : Any>(private val idOf: (T) -> String) {
+
+    private var slots = arrayOfNulls<Any>(16)
+    private var used = 0
+    private val index = IdIndex()
+
+    /** Number of runs stored. */
+    var size: Int = 0
+        private set
+
+    /** Changes whenever runs move to other slots (compaction, clear), so copies made by slot know to start over. */
+    var generation: Int = 0
+        private set
+
+    /** One past the last slot in use; slots below it may be holes. */
+    val slotCount: Int get() = used
+
+    /**
+     * Insert a run, or replace the run with the same id in place.
+     * @return true if the id was new
+     */
+    fun upsert(run: T): Boolean {
+        val id = idOf(run)
+        val slot = index.get(id)
+        if (slot >= 0) {
+            slots[slot] = run
+            return false
+        }
+        if (used == slots.size) slots = slots.copyOf(slots.size * 2)
+        slots[used] = run
+        index.put(id, used)
+        used++
+        size++
+        return true
+    }
+
+    /** Slot holding [id], or -1. */
+    fun slotOf(id: String): Int = index.get(id)
+
+    /** Slots [from, to) as stored, holes as null. */
+    fun copySlots(from: Int, to: Int): Array<Any?> = slots.copyOfRange(from, to)
+
+    operator fun get(id: String): T? {
+        val slot = index.get(id)
+        @Suppress("UNCHECKED_CAST")
+        return if (slot >= 0) slots[slot] as T else null
+    }
+
+    /**
+     * Remove a run.
+     * @return true if it was stored
+     */
+    fun remove(id: String): Boolean {
+        val slot = index.remove(id)
+        if (slot < 0) return false
+        slots[slot] = null
+        size--
+        if (used - size > size && used > COMPACT_MIN_SLOTS) compact()
+        return true
+    }
+
+    fun clear() {
+        slots = arrayOfNulls(16)
+        used = 0
+        size = 0
+        generation++
+        index.clear()
+    }
+
+    /** Runs in storage order. */
+    fun toList(): List<T> = filter { true }
+
+    fun filter(predicate: (T) -> Boolean): List<T> {
+        val out = ArrayList<T>(size)
+        for (i in 0 until used) {
+            @Suppress("UNCHECKED_CAST")
+            val run = slots[i] as T? ?: continue
+            if (predicate(run)) out.add(run)
+        }
+        return out
+    }
+
+    // Slide live runs down over the holes and point the index at their new slots
+    private fun compact() {
+        var write = 0
+        for (read in 0 until used) {
+            @Suppress("UNCHECKED_CAST")
+            val run = slots[read] as T? ?: continue
+            slots[write] = run
+            if (write != read) index.put(idOf(run), write)
+            write++
+        }
+        slots.fill(null, write, used)
+        used = write
+        generation++
+    }
+
+    private companion object {
+        const val COMPACT_MIN_SLOTS = 64
+    }
+}
+
+/**
+ * Open-addressing hash map from run id to slot, with linear probing.
+ *
+ * A delete marks its cell as a tombstone so probe chains through it stay intact;
+ * inserts reuse the first tombstone they pass. The table is rebuilt, dropping all
+ * tombstones, when live plus dead cells pass half its capacity.
+ */
+internal class IdIndex {
+
+    private var keys = arrayOfNulls<String>(INITIAL_CAPACITY)
+    private var values = IntArray(INITIAL_CAPACITY)
+    private var states = ByteArray(INITIAL_CAPACITY)
+    private var live = 0
+    private var tombstones = 0
+
+    /** Slot stored for [id], or -1. */
+    fun get(id: String): Int {
+        val cell = find(id)
+        return if (cell >= 0) values[cell] else -1
+    }
+
+    /** Store or overwrite the slot for [id]. */
+    fun put(id: String, slot: Int) {
+        val existing = find(id)
+        if (existing >= 0) {
+            values[existing] = slot
+            return
+        }
+        if ((live + tombstones + 1) * 2 > keys.size) rehash(if ((live + 1) * 4 > keys.size) keys.size * 2 else keys.size)
+        val mask = keys.size - 1
+        var cell = mix(id.hashCode()) and mask
+        while (states[cell] == FULL) cell = (cell + 1) and mask
+        if (states[cell] == DELETED) tombstones--
+        keys[cell] = id
+        values[cell] = slot
+        states[cell] = FULL
+        live++
+    }
+
+    /**
+     * Remove [id].
+     * @return The slot it had, or -1
+     */
+    fun remove(id: String): Int {
+        val cell = find(id)
+        if (cell < 0) return -1
+        keys[cell] = null
+        states[cell] = DELETED
+        live--
+        tombstones++
+        return values[cell]
+    }
+
+    fun clear() {
+        keys = arrayOfNulls(INITIAL_CAPACITY)
+        values = IntArray(INITIAL_CAPACITY)
+        states = ByteArray(INITIAL_CAPACITY)
+        live = 0
+        tombstones = 0
+    }
+
+    private fun find(id: String): Int {
+        val mask = keys.size - 1
+        var cell = mix(id.hashCode()) and mask
+        while (states[cell] != EMPTY) {
+            if (states[cell] == FULL && keys[cell] == id) return cell
+            cell = (cell + 1) and mask
+        }
+        return -1
+    }
+
+    private fun rehash(capacity: Int) {
+        val oldKeys = keys
+        val oldValues = values
+        val oldStates = states
+        keys = arrayOfNulls(capacity)
+        values = IntArray(capacity)
+        states = ByteArray(capacity)
+        live = 0
+        tombstones = 0
+        for (i in oldKeys.indices) {
+            if (oldStates[i] == FULL) put(oldKeys[i]!!, oldValues[i])
+        }
+    }
+
+    private companion object {
+        const val INITIAL_CAPACITY = 16
+        const val EMPTY: Byte = 0
+        const val FULL: Byte = 1
+        const val DELETED: Byte = 2
+
+        // Spread String.hashCode so ids with common prefixes don't cluster under the mask
+        fun mix(hash: Int): Int {
+            val h = hash * -0x61c88647
+            return h xor (h ushr 16)
+        }
+    }
+}
@@ -0,0 +1,457 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+import kotlinx.serialization.json.Json
+
+/**
+ * How much of the history a tiered store keeps in memory.
+ *
+ * Runs started within [hotDays] of now stay resident, up to [maxResidentRuns]; the rest
+ * live only in the cold segment on disk and are read back per query.
+ * Only the watchOS store is tiered. The JVM store keeps just the runs written since its
+ * last compaction resident and reads older ones from the mapped snapshot; the iOS store
+ * keeps every run in memory.
+ * @param maxResidentRuns Hard cap on resident runs; past it the oldest go cold even inside [hotDays]
+ * @param maxLogBytes Run log size at which its runs are checkpointed into the cold segment and the log restarts
+ * @param maxDeadRatio Share of the cold segment held by superseded records at which it is rewritten
+ */
+data class TierPolicy(
+    val hotDays: Int = 30,
+    val maxResidentRuns: Int = 256,
+    val maxLogBytes: Long = 256L * 1024,
+    val maxDeadRatio: Double = 0.5
+) {
+    init {
+        require(hotDays >= 0) { "hotDays must not be negative" }
+        require(maxResidentRuns >= 0) { "maxResidentRuns must not be negative" }
+        require(maxLogBytes > 0) { "maxLogBytes must be positive" }
+        require(maxDeadRatio > 0.0 && maxDeadRatio < 1.0) { "maxDeadRatio must be in (0, 1)" }
+    }
+}
+
+/**
+ * Tier counters of a tiered store.
+ * @param coldReads Runs read back from the cold segment since the store opened
+ * @param checkpoints Times the run log was folded into the cold segment and restarted
+ * @param rewrites Times the cold segment was rewritten to drop superseded records
+ */
+data class TierMetrics(
+    val residentRuns: Int,
+    val coldRuns: Int,
+    val coldReads: Long,
+    val coldSegmentBytes: Long,
+    val deadColdBytes: Long,
+    val checkpoints: Long,
+    val rewrites: Long
+)
+
+/**
+ * File holding a tiered store's cold segment: a run log in [RunLogCodec]'s format whose
+ * records are read back one at a time by offset.
+ */
+internal interface ColdSegmentFile {
+
+    /** Size in bytes; 0 if the file is new. */
+    val length: Long
+
+    fun read(offset: Long, length: Int): ByteArray
+
+    /** Append with a single write and flush to the device before returning. */
+    fun append(bytes: ByteArray)
+
+    /** Cut off a torn tail, durably. */
+    fun truncate(length: Long)
+
+    /**
+     * Replace the whole file atomically and durably by the chunks [write] emits. Reads
+     * from [write] still see the old contents.
+     */
+    fun rewrite(write: ((ByteArray) -> Unit) -> Unit)
+
+    fun close()
+}
+
+/**
+ * Cold segment kept in memory, for stores without a data file.
+ */
+internal class MemoryColdSegmentFile : ColdSegmentFile {
+
+    private var bytes = ByteArray(0)
+
+    override var length: Long = 0L
+        private set
+
+    override fun read(offset: Long, length: Int): ByteArray =
+        bytes.copyOfRange(offset.toInt(), (offset + length).toInt())
+
+    override fun append(bytes: ByteArray) {
+        val end = length.toInt() + bytes.size
+        if (end > this.bytes.size) this.bytes = this.bytes.copyOf(maxOf(end, this.bytes.size * 2))
+        bytes.copyInto(this.bytes, length.toInt())
+        length = end.toLong()
+    }
+
+    override fun truncate(length: Long) {
+        this.length = length
+    }
+
+    override fun rewrite(write: ((ByteArray) -> Unit) -> Unit) {
+        val replacement = MemoryColdSegmentFile()
+        write { replacement.append(it) }
+        bytes = replacement.bytes
+        length = replacement.length
+    }
+
+    override fun close() = Unit
+}
+
+/**
+ * Runs split into a resident hot tier and a cold tier on disk, so a store's memory stays
+ * bounded however long the history grows.
+ *
+ * Every run keeps its slot in one [RunTable], so iteration order is the order runs were
+ * first stored, as in the untiered stores. An entry holds the run itself (resident), the
+ * position of its latest record in the cold segment (cold), or both. A resident run with
+ * no record there yet is dirty: only the store's run log has it.
+ *
+ * The cold segment is a run log too. The store's state on disk is the segment replayed,
+ * then its run log on top, so [checkpoint] only appends the dirty runs and deletes of runs
+ * the segment holds before the store restarts its run log. Demoting a dirty run appends it
+ * first; demoting a clean one just drops the object. Superseded records are reclaimed by
+ * rewriting the segment once they pass [TierPolicy.maxDeadRatio].
+ *
+ * A cold run costs its id, start time and record position in memory, tens of bytes; the
+ * run with its efforts and pace curve is read back on demand, in segment order and large
+ * chunks when a query needs many. Not synchronized; the owning store serializes access.
+ */
+internal class TieredRunTable(
+    private val segment: ColdSegmentFile,
+    private val nowMs: () -> Long
+) {
+
+    private class Entry(val id: String, val startedAtEpochMs: Long, var run: RunDTO?) {
+        /** Start of this run's latest record in the segment, or -1 */
+        var offset = -1L
+        var length = 0
+        /** The segment holds a record for this id, possibly superseded, so a remove must cancel it */
+        var inSegment = false
+    }
+
+    var policy = TierPolicy()
+
+    private val json = Json { ignoreUnknownKeys = true }
+    private val entries = RunTable<Entry> { it.id }
+    private val resident = HashMap<String, Entry>()
+    private val cancelInSegment = HashSet<String>()
+    private var segmentSeq = 0L
+    private var segmentBytes = 0L
+    private var deadBytes = 0L
+    private var coldReads = 0L
+    private var checkpoints = 0L
+    private var rewrites = 0L
+
+    val size: Int get() = entries.size
+
+    /**
+     * Read the cold segment, reporting each record's effect so the store can build its indexes.
+     * Runs inside the hot window stay resident; the rest only keep their position.
+     * A torn tail from a crash mid-append is cut off; its runs are still in the run log.
+     * @throws IllegalStateException if a record before the tail is damaged
+     */
+    fun load(upsert: (RunDTO) -> Unit, delete: (String) -> Unit, clear: () -> Unit) {
+        val fileLength = segment.length
+        if (fileLength == 0L) {
+            segment.rewrite { it(RunLogCodec.MAGIC) }
+            segmentBytes = RunLogCodec.MAGIC.size.toLong()
+            return
+        }
+        require(fileLength >= RunLogCodec.MAGIC.size && segment.read(0, RunLogCodec.MAGIC.size).contentEquals(RunLogCodec.MAGIC)) {
+            "Not a cold run segment"
+        }
+        val reader = SegmentReader(segment, fileLength)
+        val hotFromMs = hotFromMs()
+        var position = RunLogCodec.MAGIC.size.toLong()
+        while (position < fileLength) {
+            val at = reader.load(position, RunLogCodec.RECORD_OVERHEAD)
+            if (reader.available(position) < RunLogCodec.RECORD_OVERHEAD) break
+            val size = RunLogCodec.recordSize(reader.chunk, at)
+            if (size > fileLength - position) break
+            val record = if (size < 0) null else RunLogCodec.decodeRecord(reader.chunk, reader.load(position, size))
+            if (record == null || record.seq <= segmentSeq) {
+                // A crash mid-append leaves an incomplete last record or zeros; anything else is damage
+                check(position + size == fileLength || reader.zerosFrom(position)) { "Cold run segment is damaged at offset $position" }
+                break
+            }
+            segmentSeq = record.seq
+            when (record.op) {
+                RunLogOp.UPSERT -> {
+                    val run = decode(record.payload)
+                    val entry = Entry(run.id, run.startedAtEpochMs, if (run.startedAtEpochMs >= hotFromMs) run else null)
+                    entry.offset = position
+                    entry.length = size
+                    entry.inSegment = true
+                    put(entry)
+                    upsert(run)
+                    if (resident.size > policy.maxResidentRuns) evict(policy.maxResidentRuns * 3 / 4)
+                }
+                // The segment already cancels the run, so unlike remove() this queues no DELETE
+                RunLogOp.DELETE -> {
+                    val id = record.payload.decodeToString()
+                    entries[id]?.let { entry ->
+                        if (entry.offset >= 0) deadBytes += entry.length
+                        resident.remove(id)
+                        entries.remove(id)
+                    }
+                    deadBytes += size
+                    delete(id)
+                }
+                // [clear] rewrites the segment rather than appending one, but the format allows it
+                RunLogOp.CLEAR -> {
+                    entries.clear()
+                    resident.clear()
+                    cancelInSegment.clear()
+                    deadBytes = position + size - RunLogCodec.MAGIC.size
+                    clear()
+                }
+            }
+            position += size
+        }
+        if (position < fileLength) segment.truncate(position)
+        segmentBytes = position
+    }
+
+    /**
+     * Insert a run resident and dirty, or replace the run with the same id in place.
+     * @return true if the id was new
+     */
+    fun upsert(run: RunDTO): Boolean = put(Entry(run.id, run.startedAtEpochMs, run))
+
+    operator fun contains(id: String): Boolean = entries[id] != null
+
+    /** The run, read back from the cold segment if it is not resident. */
+    operator fun get(id: String): RunDTO? {
+        val entry = entries[id] ?: return null
+        return entry.run ?: materialize(listOf(entry))[0]
+    }
+
+    /**
+     * Remove a run.
+     * @return true if it was stored
+     */
+    fun remove(id: String): Boolean {
+        if (entries[id] == null) return false
+        discard(id)
+        return true
+    }
+
+    /** Remove every run and empty the cold segment. */
+    fun clear() {
+        segment.rewrite { it(RunLogCodec.MAGIC) }
+        entries.clear()
+        resident.clear()
+        cancelInSegment.clear()
+        segmentSeq = 0L
+        segmentBytes = RunLogCodec.MAGIC.size.toLong()
+        deadBytes = 0L
+    }
+
+    /** Runs started at or after [sinceMs], in storage order; only those are read back. */
+    fun startedSince(sinceMs: Long): List<RunDTO> = materialize(entries.filter { it.startedAtEpochMs >= sinceMs })
+
+    /** Every run in storage order; reads the whole cold tier. */
+    fun toList(): List<RunDTO> = materialize(entries.toList())
+
+    /**
+     * Demote runs that left the hot window, then the oldest residents until at most
+     * [TierPolicy.maxResidentRuns] remain. Called after every write.
+     */
+    fun settle() {
+        val hotFromMs = hotFromMs()
+        if (resident.size > policy.maxResidentRuns || resident.values.any { it.startedAtEpochMs < hotFromMs }) {
+            evict(policy.maxResidentRuns)
+        }
+    }
+
+    /**
+     * Save everything only the run log has into the cold segment, after which the store
+     * may restart its run log.
+     */
+    fun checkpoint() {
+        appendToSegment(resident.values.filter { it.offset < 0 }, cancelInSegment.toList())
+        cancelInSegment.clear()
+        checkpoints++
+        if (segmentBytes >= MIN_REWRITE_BYTES && deadBytes > segmentBytes * policy.maxDeadRatio) rewrite()
+    }
+
+    fun metrics(): TierMetrics =
+        TierMetrics(resident.size, entries.size - resident.size, coldReads, segmentBytes, deadBytes, checkpoints, rewrites)
+
+    fun close() = segment.close()
+
+    private fun put(entry: Entry): Boolean {
+        val previous = entries[entry.id]
+        if (previous != null && previous.offset >= 0) deadBytes += previous.length
+        // An older record of the id stays in the segment until a rewrite, whether this entry replaces it or re-adds a removed run
+        if (cancelInSegment.remove(entry.id) || previous?.inSegment == true) entry.inSegment = true
+        if (entry.run != null) resident[entry.id] = entry else resident.remove(entry.id)
+        return entries.upsert(entry)
+    }
+
+    private fun discard(id: String) {
+        val entry = entries[id] ?: return
+        if (entry.offset >= 0) deadBytes += entry.length
+        if (entry.inSegment) cancelInSegment.add(id)
+        resident.remove(id)
+        entries.remove(id)
+    }
+
+    // Oldest residents first: everything outside the hot window, then down to [target]
+    private fun evict(target: Int) {
+        val hotFromMs = hotFromMs()
+        val candidates = resident.values.sortedBy { it.startedAtEpochMs }
+        var kept = candidates.size
+        val demoted = ArrayList<Entry>()
+        for (entry in candidates) {
+            if (kept <= target && entry.startedAtEpochMs >= hotFromMs) break
+            demoted.add(entry)
+            kept--
+        }
+        appendToSegment(demoted.filter { it.offset < 0 }, emptyList())
+        demoted.forEach { entry ->
+            entry.run = null
+            resident.remove(entry.id)
+        }
+    }
+
+    private fun appendToSegment(runs: List<Entry>, deletes: List<String>) {
+        if (runs.isEmpty() && deletes.isEmpty()) return
+        val records = runs.map { RunLogRecord(++segmentSeq, RunLogOp.UPSERT, encode(it.run!!)) } +
+            deletes.map { RunLogRecord(++segmentSeq, RunLogOp.DELETE, it.encodeToByteArray()) }
+        segment.append(RunLogCodec.encodeAll(records))
+        var position = segmentBytes
+        records.forEachIndexed { i, record ->
+            val size = RunLogCodec.RECORD_OVERHEAD + record.payload.size
+            if (i < runs.size) {
+                runs[i].offset = position
+                runs[i].length = size
+                runs[i].inSegment = true
+            } else {
+                deadBytes += size
+            }
+            position += size
+        }
+        segmentBytes = position
+    }
+
+    // One record per stored run, renumbered; superseded records and deletes are dropped
+    private fun rewrite() {
+        val all = entries.toList()
+        val offsets = LongArray(all.size)
+        val lengths = IntArray(all.size)
+        val reader = SegmentReader(segment, segmentBytes)
+        var seq = 0L
+        var position = 0L
+        segment.rewrite { emit ->
+            emit(RunLogCodec.MAGIC)
+            position = RunLogCodec.MAGIC.size.toLong()
+            all.forEachIndexed { i, entry ->
+                val payload = entry.run?.let { encode(it) } ?: readRecord(reader, entry).payload
+                val bytes = RunLogCodec.encode(RunLogRecord(++seq, RunLogOp.UPSERT, payload))
+                emit(bytes)
+                offsets[i] = position
+                lengths[i] = bytes.size
+                position += bytes.size
+            }
+        }
+        all.forEachIndexed { i, entry ->
+            entry.offset = offsets[i]
+            entry.length = lengths[i]
+            entry.inSegment = true
+        }
+        cancelInSegment.clear()
+        segmentSeq = seq
+        segmentBytes = position
+        deadBytes = 0L
+        rewrites++
+    }
+
+    // Runs for [selected] in the same order; cold ones are read in segment order through one reader
+    private fun materialize(selected: List<Entry>): List<RunDTO> {
+        val out = arrayOfNulls<RunDTO>(selected.size)
+        val cold = ArrayList<Int>()
+        selected.forEachIndexed { i, entry ->
+            val run = entry.run
+            if (run != null) out[i] = run else cold.add(i)
+        }
+        if (cold.isNotEmpty()) {
+            // A lone lookup reads just its record
+            val chunkBytes = if (cold.size == 1) selected[cold[0]].length else SegmentReader.CHUNK_BYTES
+            val reader = SegmentReader(segment, segmentBytes, chunkBytes)
+            cold.sortedBy { selected[it].offset }.forEach { i -> out[i] = decode(readRecord(reader, selected[i]).payload) }
+            coldReads += cold.size
+        }
+        @Suppress("UNCHECKED_CAST")
+        return out.asList() as List<RunDTO>
+    }
+
+    private fun readRecord(reader: SegmentReader, entry: Entry): RunLogRecord {
+        val record = RunLogCodec.decodeRecord(reader.chunk, reader.load(entry.offset, entry.length))
+        return checkNotNull(record) { "Cold run segment record of ${entry.id} is damaged" }
+    }
+
+    private fun hotFromMs(): Long = nowMs() - policy.hotDays * MS_PER_DAY
+
+    private fun encode(run: RunDTO): ByteArray = json.encodeToString(RunDTO.serializer(), run).encodeToByteArray()
+
+    private fun decode(payload: ByteArray): RunDTO = json.decodeFromString(RunDTO.serializer(), payload.decodeToString())
+
+    private companion object {
+        const val MS_PER_DAY = 24L * 3600_000
+        const val MIN_REWRITE_BYTES = 64L * 1024
+    }
+}
+
+/**
+ * Reads a cold segment in large chunks, so a scan or a batch of nearby records costs
+ * a few reads instead of one per record.
+ */
+private class SegmentReader(
+    private val segment: ColdSegmentFile,
+    private val end: Long,
+    private val chunkBytes: Int = CHUNK_BYTES
+) {
+
+    var chunk = ByteArray(0)
+        private set
+
+    private var chunkStart = 0L
+
+    /**
+     * Make bytes [position, position + count) available in [chunk], as far as the file goes.
+     * @return Index of [position] in [chunk]
+     */
+    fun load(position: Long, count: Int): Int {
+        if (position >= chunkStart && position + count <= chunkStart + chunk.size) return (position - chunkStart).toInt()
+        chunk = segment.read(position, minOf(maxOf(count, chunkBytes).toLong(), end - position).toInt())
+        chunkStart = position
+        return 0
+    }
+
+    /** Bytes of [chunk] from [position] on. */
+    fun available(position: Long): Int = (chunkStart + chunk.size - position).toInt()
+
+    /** Whether everything from [position] to the end is zero, as a preallocated tail is. */
+    fun zerosFrom(position: Long): Boolean {
+        var at = position
+        while (at < end) {
+            val index = load(at, chunkBytes)
+            for (i in index until chunk.size) if (chunk[i] != 0.toByte()) return false
+            at += chunk.size - index
+        }
+        return true
+    }
+
+    companion object {
+        const val CHUNK_BYTES = 64 * 1024
+    }
+}
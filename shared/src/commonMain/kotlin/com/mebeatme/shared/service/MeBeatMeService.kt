@@ -1,8 +1,12 @@
 package com.mebeatme.shared.service
 
 import com.mebeatme.shared.core.ChallengeGenerator
+import com.mebeatme.shared.core.PaceCurveEngine
+import com.mebeatme.shared.core.PaceEnvelope
 import com.mebeatme.shared.core.PerformanceBucketManager
+import com.mebeatme.shared.core.PpiScoringEngine
 import com.mebeatme.shared.core.PurdyPointsCalculator
+import com.mebeatme.shared.core.ScoringPrecision
 import com.mebeatme.shared.model.ChallengeOption
 import com.mebeatme.shared.model.RunSession
 import com.mebeatme.shared.model.Score
@@ -17,7 +21,8 @@ import kotlinx.coroutines.flow.asStateFlow
 class MeBeatMeService {
     
     private val bucketManager = PerformanceBucketManager()
-    private val challengeGenerator = ChallengeGenerator(bucketManager)
+    private val paceEnvelope = PaceEnvelope()
+    private val challengeGenerator = ChallengeGenerator(bucketManager, paceEnvelope)
     
     private val _currentChallenges = MutableStateFlow<List<ChallengeOption>>(emptyList())
     val currentChallenges: StateFlow<List<ChallengeOption>> = _currentChallenges.asStateFlow()
@@ -79,11 +84,13 @@ class MeBeatMeService {
         val session = _currentSession.value ?: return null
         val challenge = _selectedChallenge.value ?: return null
         
-        // Calculate actual PPI
-        val actualPPI = PurdyPointsCalculator.calculatePPI(session.distance, session.duration)
+        // Calculate actual PPI; a session with no distance or time scores 0
+        val scored = session.distance > 0 && session.duration > 0
+        val actualPPI = if (scored) PurdyPointsCalculator.calculatePPI(session.distance, session.duration) else 0.0
         
         // Update historical best
-        bucketManager.updateHistoricalBest(session)
+        if (scored) bucketManager.updateHistoricalBest(session)
+        paceEnvelope.merge(session.id, PaceCurveEngine.compute(session))
         
         // Create score
         val score = Score(
@@ -102,11 +109,35 @@ class MeBeatMeService {
     }
     
     /**
-     * Get real-time feedback during the run
+     * Get real-time feedback during the run.
+     * Called for every sensor sample, so the live PPI defaults to the fixed-point kernel.
+     * @param precision Arithmetic for the live PPI
      */
-    fun getRealTimeFeedback(): RealTimeFeedback? {
-        val session = _currentSession.value ?: return null
-        val challenge = _selectedChallenge.value ?: return null
+    fun getRealTimeFeedback(precision: ScoringPrecision = ScoringPrecision.FIXED_Q16): RealTimeFeedback? {
+        var feedback: RealTimeFeedback? = null
+        readRealTimeFeedback(precision) { currentPace, targetPace, paceDifference, paceZone, progress, currentPpi ->
+            feedback = RealTimeFeedback(
+                currentPace = currentPace,
+                targetPace = targetPace,
+                paceDifference = paceDifference,
+                paceZone = paceZone,
+                progressPercentage = progress,
+                currentPpi = currentPpi
+            )
+        }
+        return feedback
+    }
+    
+    /**
+     * Live feedback handed to [read] as primitives, so the flat writer (FlatFeedback) builds no object.
+     * @return false if no run is in progress
+     */
+    internal inline fun readRealTimeFeedback(
+        precision: ScoringPrecision,
+        read: (currentPace: Double, targetPace: Double, paceDifference: Double, paceZone: PaceZone, progress: Double, currentPpi: Double) -> Unit
+    ): Boolean {
+        val session = currentSession.value ?: return false
+        val challenge = selectedChallenge.value ?: return false
         
         val currentPace = session.pace
         val targetPace = challenge.targetPace
@@ -118,16 +149,11 @@ class MeBeatMeService {
             else -> PaceZone.TOO_SLOW
         }
         
-        return RealTimeFeedback(
-            currentPace = currentPace,
-            targetPace = targetPace,
-            paceDifference = paceDifference,
-            paceZone = paceZone,
-            progressPercentage = calculateProgress(session, challenge)
-        )
+        read(currentPace, targetPace, paceDifference, paceZone, calculateProgress(session, challenge), calculateLivePpi(session, precision))
+        return true
     }
     
-    private fun calculateProgress(session: RunSession, challenge: ChallengeOption): Double {
+    internal fun calculateProgress(session: RunSession, challenge: ChallengeOption): Double {
         val distanceProgress = (session.distance / challenge.targetDistance).coerceAtMost(1.0)
         val timeProgress = (session.duration.toDouble() / challenge.targetDuration).coerceAtMost(1.0)
         
@@ -135,6 +161,13 @@ class MeBeatMeService {
         return minOf(distanceProgress, timeProgress)
     }
     
+    // Same curve as completeSession (the engine's default), so the live value tracks the final score
+    internal fun calculateLivePpi(session: RunSession, precision: ScoringPrecision): Double {
+        // Nothing to score until the run has covered some distance
+        if (session.distance < 1 || session.duration <= 0) return 0.0
+        return PpiScoringEngine.score(session.distance, session.duration.toDouble(), precision = precision)
+    }
+    
     private fun generateSessionId(): String {
         return "session_${Clock.System.now().toEpochMilliseconds()}_${(1000..9999).random()}"
     }
@@ -145,7 +178,8 @@ data class RealTimeFeedback(
     val targetPace: Double,
     val paceDifference: Double,
     val paceZone: PaceZone,
-    val progressPercentage: Double
+    val progressPercentage: Double,
+    val currentPpi: Double = 0.0
 )
 
 enum class PaceZone {
@@ -0,0 +1,125 @@
+package com.mebeatme.shared.service
+
+import com.mebeatme.shared.core.PpiScoringEngine
+import com.mebeatme.shared.core.ScoringModel
+import com.mebeatme.shared.model.RunDTO
+import com.mebeatme.shared.persistence.JsonRunStore
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.async
+import kotlinx.coroutines.awaitAll
+import kotlinx.coroutines.coroutineScope
+import kotlinx.serialization.Serializable
+import kotlin.time.TimeSource
+
+/**
+ * Progress marker for an interrupted rescore.
+ * Resuming relies on the curve version stamped on each run rather than a position,
+ * so runs added or edited since the checkpoint are still picked up; [lastRunId] is
+ * the last run written, for progress reporting, and [rescored] carries the count over.
+ */
+@Serializable
+data class RescoreCheckpoint(
+    val curveVersion: String,
+    val lastRunId: String?,
+    val rescored: Int
+)
+
+/**
+ * Outcome of a rescore pass.
+ */
+data class RescoreReport(
+    val curveVersion: String,
+    val scanned: Int,
+    val rescored: Int,
+    val elapsedMs: Long,
+    val runsPerSecond: Double
+)
+
+/**
+ * Recomputes every stored PPI after the scoring model or its anchors change.
+ *
+ * Runs not yet scored with the target curve version are streamed in store order
+ * through the batch scorer in chunks. The chunks of one wave are scored in parallel
+ * on [Dispatchers.Default]; each run is then read again and only its PPI fields are
+ * replaced, so an edit made while the wave was scored is kept, and a run whose
+ * distance or time changed meanwhile is left for the next pass. The wave goes back
+ * in a single [JsonRunStore.replaceIfUnchanged], so a run edited between that read
+ * and the write is skipped rather than overwritten, and is reported through the
+ * checkpoint callback. Runs already on the target version are skipped, which is also
+ * how an interrupted job resumes; that includes runs the curve cannot score, which
+ * keep a null PPI with the version.
+ */
+class RescoreJob(
+    private val store: JsonRunStore,
+    private val model: ScoringModel = PpiScoringEngine.defaultModel,
+    private val chunkSize: Int = 4096,
+    private val chunksPerWave: Int = 8
+) {
+
+    init {
+        require(chunkSize > 0) { "chunkSize must be positive" }
+        require(chunksPerWave > 0) { "chunksPerWave must be positive" }
+    }
+
+    /**
+     * Rescore the whole store.
+     * @param resumeFrom Checkpoint from a previous interrupted run, ignored if it was for another curve version
+     * @param onCheckpoint Called after each wave has been written to the store
+     * @return Throughput report for this pass
+     */
+    suspend fun run(
+        resumeFrom: RescoreCheckpoint? = null,
+        onCheckpoint: (RescoreCheckpoint) -> Unit = {}
+    ): RescoreReport {
+        val started = TimeSource.Monotonic.markNow()
+        val version = model.version
+        val resumed = resumeFrom?.takeIf { it.curveVersion == version }
+
+        val pending = store.getAll()
+            .asSequence()
+            .filter { it.ppiCurveVersion != version }
+
+        var scanned = 0
+        var rescored = resumed?.rescored ?: 0
+        for (wave in pending.chunked(chunkSize * chunksPerWave)) {
+            val scored = coroutineScope {
+                wave.chunked(chunkSize)
+                    .map { chunk -> async(Dispatchers.Default) { rescoreChunk(chunk, version) } }
+                    .awaitAll()
+                    .flatten()
+            }
+            val updated = scored.mapNotNull { run -> latest(run, version) }
+            val written = if (updated.isEmpty()) 0 else store.replaceIfUnchanged(updated)
+            scanned += wave.size
+            rescored += written
+            onCheckpoint(RescoreCheckpoint(version, updated.lastOrNull()?.first?.id ?: wave.last().id, rescored))
+        }
+
+        val elapsedMs = started.elapsedNow().inWholeMilliseconds
+        return RescoreReport(
+            curveVersion = version,
+            scanned = scanned,
+            rescored = rescored,
+            elapsedMs = elapsedMs,
+            runsPerSecond = if (elapsedMs > 0) scanned * 1000.0 / elapsedMs else scanned.toDouble()
+        )
+    }
+
+    // The stored run and its rescored copy, or null if it was deleted, rescored or changed while the wave was scored
+    private fun latest(scored: RunDTO, version: String): Pair<RunDTO, RunDTO>? {
+        val current = store.getById(scored.id) ?: return null
+        if (current.ppiCurveVersion == version) return null
+        if (current.distanceMeters != scored.distanceMeters || current.elapsedSeconds != scored.elapsedSeconds) return null
+        return current to current.copy(ppi = scored.ppi, ppiCurveVersion = version)
+    }
+
+    private fun rescoreChunk(chunk: List<RunDTO>, version: String): List<RunDTO> {
+        val distances = DoubleArray(chunk.size) { chunk[it].distanceMeters }
+        val durations = DoubleArray(chunk.size) { chunk[it].elapsedSeconds.toDouble() }
+        val scores = PpiScoringEngine.curveFor(model).scoreBatch(distances, durations, DoubleArray(chunk.size))
+
+        return chunk.mapIndexed { i, run ->
+            run.copy(ppi = scores[i].takeUnless { it.isNaN() }, ppiCurveVersion = version)
+        }
+    }
+}
@@ -0,0 +1,92 @@
+package com.mebeatme.shared.core
+
+import com.mebeatme.shared.model.RunSample
+import com.mebeatme.shared.model.RunSession
+import com.mebeatme.shared.persistence.BestsBand
+import com.mebeatme.shared.persistence.BestsIndex
+import kotlinx.datetime.Instant
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+class BestEffortsTest {
+    
+    @Test
+    fun testEvenPaceRun() {
+        // 12 km at 300 s/km, one sample every 10 s
+        val times = DoubleArray(361) { it * 10.0 }
+        val distances = DoubleArray(361) { it * 10.0 / 0.3 }
+        
+        val best = BestEffortsEngine.compute(times, distances, doubleArrayOf(1000.0, 5000.0, 10000.0, 21097.5))
+        
+        assertEquals(300.0, best[0], 1e-6)
+        assertEquals(1500.0, best[1], 1e-6)
+        assertEquals(3000.0, best[2], 1e-6)
+        assertTrue(best[3].isNaN())
+    }
+    
+    @Test
+    fun testFindsFastSegmentInsideLongerRun() {
+        // 3 km easy (360 s/km), 5 km hard (240 s/km), 4 km easy, sampled every 7 s
+        val times = mutableListOf(0.0)
+        val distances = mutableListOf(0.0)
+        while (distances.last() < 12_000.0) {
+            val pace = if (distances.last() in 3000.0..8000.0) 240.0 else 360.0
+            times.add(times.last() + 7.0)
+            distances.add(distances.last() + 7.0 / pace * 1000.0)
+        }
+        
+        val best = BestEffortsEngine.compute(times.toDoubleArray(), distances.toDoubleArray(), doubleArrayOf(5000.0))
+        
+        assertEquals(1200.0, best[0], 10.0)
+    }
+    
+    @Test
+    fun testMatchesBruteForce() {
+        val random = Random(4)
+        val n = 400
+        val times = DoubleArray(n)
+        val distances = DoubleArray(n)
+        for (i in 1 until n) {
+            times[i] = times[i - 1] + random.nextDouble(1.0, 15.0)
+            distances[i] = distances[i - 1] + random.nextDouble(0.0, 60.0)
+        }
+        val targets = doubleArrayOf(400.0, 1000.0, 5000.0)
+        
+        val best = BestEffortsEngine.compute(times, distances, targets)
+        
+        targets.forEachIndexed { k, target ->
+            var expected = Double.POSITIVE_INFINITY
+            for (i in 0 until n) {
+                val end = (i + 1 until n).firstOrNull { distances[it] >= distances[i] + target } ?: continue
+                val fraction = (distances[i] + target - distances[end - 1]) / (distances[end] - distances[end - 1])
+                expected = minOf(expected, times[end - 1] + fraction * (times[end] - times[end - 1]) - times[i])
+            }
+            for (j in 0 until n) {
+                val start = (j - 1 downTo 0).firstOrNull { distances[it] <= distances[j] - target } ?: continue
+                val fraction = (distances[j] - target - distances[start]) / (distances[start + 1] - distances[start])
+                expected = minOf(expected, times[j] - (times[start] + fraction * (times[start + 1] - times[start])))
+            }
+            assertEquals(expected, best[k], 1e-6, "target $target")
+        }
+    }
+    
+    @Test
+    fun testSessionEffortsFeedBests() {
+        val samples = (0..400).map { i ->
+            RunSample(timestamp = Instant.fromEpochMilliseconds(i * 10_000L), distance = i * 30.0, pace = 333.3)
+        }
+        val session = RunSession("s1", distance = 12_000.0, duration = 4000L, timestamp = Instant.fromEpochMilliseconds(0), pace = 333.3, samples = samples)
+        
+        val run = session.toRunDTO()
+        assertEquals(1667, run.bestEffortsSec["5k"])
+        assertFalse("half" in run.bestEffortsSec)
+        
+        val bests = BestsIndex()
+        bests.upsert(run.id, run.distanceMeters, run.elapsedSeconds, run.startedAtEpochMs, run.bestEffortsSec)
+        assertEquals(1667, bests.bestSeconds(BestsBand.FIVE_K))
+        assertEquals(3333, bests.bestSeconds(BestsBand.TEN_K))
+    }
+}
@@ -0,0 +1,135 @@
+package com.mebeatme.shared.core
+
+import com.mebeatme.shared.model.BestsDTO
+import com.mebeatme.shared.model.ChallengeOption
+import com.mebeatme.shared.model.DistanceBucket
+import com.mebeatme.shared.model.RunDTO
+import com.mebeatme.shared.model.Score
+import com.mebeatme.shared.persistence.RunBatchCodec
+import com.mebeatme.shared.persistence.RunIndexes
+import com.mebeatme.shared.persistence.toBestsDTO
+import com.mebeatme.shared.service.MeBeatMeService
+import kotlinx.datetime.TimeZone
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+class FlatStructsTest {
+
+    private val nowMs = 1757300000000L
+    private val dayMs = 24L * 3600 * 1000
+
+    @Test
+    fun testBestsRecordFlagsPresentFields() {
+        val bests = BestsDTO(best5kSec = 1500, bestHalfSec = 6000, highestPPILast90Days = 612.5)
+        val bytes = FlatBests.encode(bests)
+
+        // Positions as declared in mebeatme_flat.h
+        assertEquals(FlatBests.SIZE, bytes.size)
+        assertEquals(0b10101, RunBatchCodec.readInt(bytes, FlatBests.OFFSET_PRESENT))
+        assertEquals(1500, RunBatchCodec.readInt(bytes, 4))
+        assertEquals(0, RunBatchCodec.readInt(bytes, 8))
+        assertEquals(6000, RunBatchCodec.readInt(bytes, 12))
+        assertEquals(612.5, Double.fromBits(RunBatchCodec.readLong(bytes, 24)))
+        assertEquals(bests, FlatBests.decode(bytes))
+
+        assertContentEquals(ByteArray(FlatBests.SIZE), FlatBests.encode(BestsDTO()))
+    }
+
+    @Test
+    fun testIndexesWriteTheGetBestsRecord() {
+        val indexes = RunIndexes(TimeZone.UTC)
+        val out = ByteArray(FlatBests.SIZE)
+        fun write(sinceMs: Long) = indexes.writeFlatBests(
+            nowMs,
+            sinceMs,
+            { at, value -> RunBatchCodec.writeInt(out, at, value) },
+            { at, value -> RunBatchCodec.writeLong(out, at, value.toRawBits()) }
+        )
+
+        write(0L)
+        assertContentEquals(ByteArray(FlatBests.SIZE), out)
+
+        indexes.rebuild(listOf(
+            createRunDTO("old-fast-5k", 5000.0, 1200, nowMs - 200 * dayMs, ppi = 700.0),
+            createRunDTO("recent-5k", 5000.0, 1400, nowMs - 10 * dayMs, ppi = 500.0),
+            createRunDTO("recent-10k", 10000.0, 2900, nowMs - 5 * dayMs, ppi = 550.0, efforts = mapOf("5k" to 1380)),
+            createRunDTO("recent-jog", 3000.0, 1100, nowMs - dayMs, ppi = null)
+        ))
+        for (sinceMs in listOf(0L, nowMs - 30 * dayMs, nowMs)) {
+            write(sinceMs)
+            val expected = indexes.bests.toBestsDTO(sinceMs, indexes.ppiWindows.maxPpiInWindow(nowMs, 90))
+            assertContentEquals(FlatBests.encode(expected), out)
+            assertEquals(expected, FlatBests.decode(out))
+        }
+
+        // The 5k inside the 10k beats the recent 5k; the fastest 5k and highest PPI are too old
+        write(nowMs - 30 * dayMs)
+        assertEquals(BestsDTO(best5kSec = 1380, best10kSec = 2900, highestPPILast90Days = 550.0), FlatBests.decode(out))
+    }
+
+    @Test
+    fun testScoreRecordKeepsOptionalTargets() {
+        val scores = listOf(
+            Score(ppi = 480.25, bucket = DistanceBucket.MEDIUM_RUN, targetPace = 295.5, targetDuration = 3600L, achieved = true),
+            Score(ppi = 0.0, bucket = DistanceBucket.SHORT_SPRINT, targetDuration = 0L),
+            Score(ppi = 312.0, bucket = DistanceBucket.SHORT_RUN)
+        )
+        scores.forEach { score ->
+            val bytes = FlatScore.encode(score)
+            assertEquals(FlatScore.SIZE, bytes.size)
+            assertEquals(score, FlatScore.decode(bytes))
+        }
+
+        val bytes = FlatScore.encode(scores[1])
+        assertEquals(FlatScore.HAS_TARGET_DURATION, RunBatchCodec.readInt(bytes, FlatScore.OFFSET_PRESENT))
+        assertEquals(DistanceBucket.SHORT_SPRINT.ordinal, RunBatchCodec.readInt(bytes, FlatScore.OFFSET_BUCKET))
+    }
+
+    @Test
+    fun testFeedbackRecordMatchesRealTimeFeedback() {
+        val service = MeBeatMeService()
+        val out = ByteArray(FlatFeedback.SIZE)
+        fun write() = FlatFeedback.write(
+            service,
+            ScoringPrecision.FIXED_Q16,
+            { at, value -> RunBatchCodec.writeInt(out, at, value) },
+            { at, value -> RunBatchCodec.writeLong(out, at, value.toRawBits()) }
+        )
+
+        assertFalse(write())
+        assertContentEquals(ByteArray(FlatFeedback.SIZE), out)
+
+        service.selectChallenge(ChallengeOption("c1", "Beat 5K", "", 300.0, 1500L, 5000.0, 450.0, DistanceBucket.SHORT_RUN))
+        for ((distance, duration, pace) in listOf(Triple(1000.0, 290L, 290.0), Triple(2500.0, 760L, 304.0), Triple(4000.0, 1300L, 325.0))) {
+            service.updateSession(distance, duration, pace)
+            assertTrue(write())
+            val feedback = service.getRealTimeFeedback()
+            assertEquals(feedback, FlatFeedback.decode(out))
+            assertContentEquals(FlatFeedback.encode(feedback!!), out)
+        }
+    }
+
+    private fun createRunDTO(
+        id: String,
+        distanceMeters: Double,
+        elapsedSeconds: Int,
+        startedAtEpochMs: Long,
+        ppi: Double?,
+        efforts: Map<String, Int> = emptyMap()
+    ): RunDTO {
+        return RunDTO(
+            id = id,
+            source = "test",
+            startedAtEpochMs = startedAtEpochMs,
+            endedAtEpochMs = startedAtEpochMs + elapsedSeconds * 1000L,
+            distanceMeters = distanceMeters,
+            elapsedSeconds = elapsedSeconds,
+            avgPaceSecPerKm = elapsedSeconds / (distanceMeters / 1000.0),
+            ppi = ppi,
+            bestEffortsSec = efforts
+        )
+    }
+}
@@ -0,0 +1,92 @@
+package com.mebeatme.shared.core
+
+import com.mebeatme.shared.model.RunSample
+import com.mebeatme.shared.model.RunSession
+import kotlinx.datetime.Instant
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class PaceCurveTest {
+
+    @Test
+    fun testGridSpansTenSecondsToSixHours() {
+        val grid = PaceCurveEngine.DURATIONS_SEC
+        assertEquals(10, grid.first())
+        assertTrue(grid.last() in 20_000..21_600)
+        assertTrue((1 until grid.size).all { grid[it] > grid[it - 1] })
+    }
+
+    @Test
+    fun testMatchesDenseBruteForce() {
+        val random = Random(12)
+        val n = 200
+        val times = DoubleArray(n)
+        val distances = DoubleArray(n)
+        for (i in 1 until n) {
+            times[i] = times[i - 1] + random.nextDouble(1.0, 12.0)
+            distances[i] = distances[i - 1] + random.nextDouble(0.0, 50.0)
+        }
+        val durations = doubleArrayOf(10.0, 60.0, 300.0, 900.0)
+
+        val best = PaceCurveEngine.compute(times, distances, durations)
+
+        fun distanceAt(t: Double): Double {
+            val j = (1 until n).first { times[it] >= t }
+            val fraction = (t - times[j - 1]) / (times[j] - times[j - 1])
+            return distances[j - 1] + fraction * (distances[j] - distances[j - 1])
+        }
+        durations.forEachIndexed { k, duration ->
+            var expected = 0.0
+            var start = 0.0
+            while (start + duration <= times.last()) {
+                expected = maxOf(expected, distanceAt(start + duration) - distanceAt(start))
+                start += 0.05
+            }
+            // The dense scan never beats the sweep and misses its optimum by at most one step at 50 m/s
+            assertTrue(best[k] >= expected - 1e-6, "duration $duration")
+            assertEquals(expected, best[k], 2 * 50.0 * 0.05, "duration $duration")
+        }
+    }
+
+    @Test
+    fun testSessionCurveStopsAtRunLength() {
+        // 20 minutes at 4 m/s, one sample every 5 s
+        val samples = (0..240).map { i ->
+            RunSample(timestamp = Instant.fromEpochMilliseconds(i * 5_000L), distance = i * 20.0, pace = 250.0)
+        }
+        val session = RunSession("s1", distance = 4800.0, duration = 1200L, timestamp = Instant.fromEpochMilliseconds(0), pace = 250.0, samples = samples)
+
+        val curve = session.toRunDTO().maxDistanceByDurationM
+
+        assertEquals(PaceCurveEngine.DURATIONS_SEC.count { it <= 1200 }, curve.size)
+        curve.forEachIndexed { i, meters -> assertEquals(PaceCurveEngine.DURATIONS_SEC[i] * 4.0, meters, 1e-6) }
+    }
+
+    @Test
+    fun testEnvelopeMergesAndRemoves() {
+        val grid = PaceCurveEngine.DURATIONS_SEC
+        val sprinter = List(12) { grid[it] * 5.0 }     // 5 m/s, short only
+        val steady = List(30) { grid[it] * 3.5 }       // 3.5 m/s, longer
+        val envelope = PaceEnvelope()
+
+        envelope.merge("sprint", sprinter)
+        envelope.merge("steady", steady)
+
+        assertEquals(200.0, envelope.sustainedPaceSecPerKm(grid[3].toDouble())!!, 1e-6)
+        assertEquals(1000.0 / 3.5, envelope.sustainedPaceSecPerKm(grid[20].toDouble())!!, 1e-6)
+        assertNull(envelope.sustainedPaceSecPerKm(grid[40].toDouble()))
+
+        // Between grid points the distance is interpolated on a log scale
+        val between = envelope.maxDistanceMeters(45.0)!!
+        assertTrue(between > grid[8] * 5.0 && between < grid[9] * 5.0)
+
+        envelope.remove("sprint")
+        assertEquals(1000.0 / 3.5, envelope.sustainedPaceSecPerKm(grid[3].toDouble())!!, 1e-6)
+
+        envelope.merge("steady", emptyList())
+        assertNull(envelope.sustainedPaceSecPerKm(grid[3].toDouble()))
+    }
+}
@@ -0,0 +1,131 @@
+package com.mebeatme.shared.core
+
+import com.mebeatme.shared.model.RunDTO
+import kotlin.math.abs
+import kotlin.math.pow
+import kotlin.math.roundToInt
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertTrue
+
+class PpiScoringEngineTest {
+    
+    private val distances = doubleArrayOf(400.0, 1000.0, 1500.0, 3000.0, 5000.0, 7500.0, 10000.0, 21097.5, 30000.0, 42195.0)
+    private val durations = doubleArrayOf(70.0, 240.0, 330.0, 720.0, 1500.0, 2300.0, 3000.0, 6300.0, 9000.0, 12600.0)
+    
+    @Test
+    fun `cubic curve matches the cross-platform purdyScore values`() {
+        assertEquals(140.6, PurdyCubicCurve.score(5000.0, 1500.0), 1.0)
+        assertEquals(1000.0, PurdyCubicCurve.score(10000.0, 1620.0), 1.0)
+        assertEquals(191.3, PurdyCubicCurve.score(42195.0, 12600.0), 1.0)
+    }
+    
+    @Test
+    fun `points curve matches the 1_07 power over nearest anchor`() {
+        // 5K reference is 780 s
+        val expected = 1000.0 * (780.0 / 1200.0).pow(1.07)
+        assertEquals(expected, PurdyPointsCurve.score(5000.0, 1200.0), 1e-9)
+    }
+    
+    @Test
+    fun `every shared calculator scores with the default model`() {
+        for (i in distances.indices) {
+            val expected = PpiScoringEngine.score(distances[i], durations[i])
+            val seconds = durations[i].toInt()
+            assertEquals(expected, purdyScore(distances[i], seconds), 1e-9)
+            assertEquals(expected, PurdyCalculator.purdyScore(distances[i], seconds), 1e-9)
+            assertEquals(expected, PurdyPointsCalculator.calculatePPI(distances[i], seconds.toLong()), 1e-9)
+        }
+        assertEquals(PurdyCubicCurve.requiredTime(5000.0, 500.0) / 5.0, PurdyPointsCalculator.calculateRequiredPace(5000.0, 500.0), 1e-9)
+    }
+    
+    @Test
+    fun `interpolated curve hits 1000 at every elite anchor`() {
+        assertEquals(1000.0, PurdyInterpolatedCurve.score(5000.0, 755.0), 1e-6)
+        assertEquals(1000.0, PurdyInterpolatedCurve.score(21097.0, 3540.0), 1e-6)
+    }
+    
+    @Test
+    fun `batch scores match scalar scores for every model`() {
+        for (model in ScoringModel.values()) {
+            val curve = PpiScoringEngine.curveFor(model)
+            val batch = PpiScoringEngine.scoreBatch(distances, durations, model)
+            for (i in distances.indices) {
+                assertEquals(curve.score(distances[i], durations[i]), batch[i], 1e-9, "$model row $i")
+            }
+        }
+    }
+    
+    @Test
+    fun `required time inverts score for every model`() {
+        for (model in ScoringModel.values()) {
+            val curve = PpiScoringEngine.curveFor(model)
+            for (distance in listOf(1500.0, 5000.0, 10000.0, 42195.0)) {
+                val time = curve.requiredTime(distance, 500.0)
+                assertTrue(abs(curve.score(distance, time) - 500.0) < 1e-6, "$model at $distance")
+            }
+        }
+    }
+    
+    @Test
+    fun `single-run entry points throw on invalid input`() {
+        assertFailsWith<IllegalArgumentException> { PpiScoringEngine.score(5000.0, -1.0) }
+        assertFailsWith<IllegalArgumentException> { PurdyPointsCalculator.calculatePPI(5000.0, 0L) }
+        assertFailsWith<IllegalArgumentException> { PurdyPointsCalculator.calculatePPI(0.0, 1200L) }
+        val run = RunDTO("r1", "test", 0L, 0L, distanceMeters = 0.0, elapsedSeconds = 1200, avgPaceSecPerKm = 0.0)
+        assertFailsWith<IllegalArgumentException> { run.calculatePpi() }
+        assertEquals(PpiScoringEngine.currentVersion(), run.copy(distanceMeters = 5000.0).calculatePpi().ppiCurveVersion)
+    }
+    
+    @Test
+    fun `invalid rows score as NaN`() {
+        val batch = PpiScoringEngine.scoreBatch(doubleArrayOf(0.0, 5000.0), doubleArrayOf(1200.0, -1.0))
+        assertTrue(batch[0].isNaN())
+        assertTrue(batch[1].isNaN())
+    }
+    
+    @Test
+    fun `reduced precision scores stay within the documented error`() {
+        for (model in ScoringModel.values()) {
+            for (precision in listOf(ScoringPrecision.FLOAT32, ScoringPrecision.FIXED_Q16)) {
+                var worst = 0.0
+                for (distance in 200..45_000 step 97) {
+                    for (speed in listOf(2.0, 3.0, 4.5, 6.0)) {
+                        val duration = (distance / speed).roundToInt().toDouble()
+                        val exact = PpiScoringEngine.score(distance.toDouble(), duration, model)
+                        val reduced = PpiScoringEngine.score(distance.toDouble(), duration, model, precision)
+                        worst = maxOf(worst, abs(reduced / exact - 1))
+                    }
+                }
+                assertTrue(worst <= precision.maxRelativeError, "$model $precision: $worst")
+            }
+        }
+    }
+    
+    @Test
+    fun `reduced precision required time stays within the documented error`() {
+        for (model in ScoringModel.values()) {
+            for (precision in listOf(ScoringPrecision.FLOAT32, ScoringPrecision.FIXED_Q16)) {
+                for (distance in listOf(1500.0, 5000.0, 10000.0, 42195.0)) {
+                    for (target in listOf(300.0, 650.0, 1000.0, 1400.0)) {
+                        val exact = PpiScoringEngine.requiredTime(distance, target, model)
+                        val reduced = PpiScoringEngine.requiredTime(distance, target, model, precision)
+                        assertTrue(abs(reduced / exact - 1) <= precision.maxRelativeError, "$model $precision at $distance/$target")
+                    }
+                }
+            }
+        }
+    }
+    
+    @Test
+    fun `every precision rejects invalid input`() {
+        for (model in ScoringModel.values()) {
+            for (precision in ScoringPrecision.values()) {
+                assertFailsWith<IllegalArgumentException>("$model $precision") { PpiScoringEngine.score(0.0, 1200.0, model, precision) }
+                assertFailsWith<IllegalArgumentException>("$model $precision") { PpiScoringEngine.requiredTime(5000.0, 0.0, model, precision) }
+                assertFailsWith<IllegalArgumentException>("$model $precision") { PpiScoringEngine.requiredTime(-5000.0, 500.0, model, precision) }
+            }
+        }
+    }
+}
@@ -0,0 +1,100 @@
+package com.mebeatme.shared.core
+
+import com.mebeatme.shared.model.DistanceBucket
+import com.mebeatme.shared.persistence.MergedRunSketches
+import com.mebeatme.shared.persistence.RunMetric
+import com.mebeatme.shared.persistence.RunSketches
+import kotlinx.serialization.encodeToString
+import kotlinx.serialization.json.Json
+import kotlin.math.abs
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class QuantileSketchTest {
+
+    @Test
+    fun testQuantilesWithinRelativeAccuracy() {
+        val random = Random(14)
+        val values = List(50_000) { 200.0 + random.nextDouble() * random.nextDouble() * 1500.0 }
+        val sketch = QuantileSketch()
+        values.forEach { sketch.add(it) }
+        val sorted = values.sorted()
+
+        listOf(0.0, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 1.0).forEach { q ->
+            val exact = sorted[(q * (sorted.size - 1)).toInt()]
+            val estimate = sketch.quantile(q)!!
+            assertTrue(abs(estimate - exact) <= sketch.relativeAccuracy * exact, "q=$q exact=$exact estimate=$estimate")
+        }
+    }
+
+    @Test
+    fun testRankAndEmptySketch() {
+        val sketch = QuantileSketch()
+        assertNull(sketch.quantile(0.5))
+        assertNull(sketch.rank(10.0))
+
+        (1..100).forEach { sketch.add(it * 10.0) }
+        assertEquals(0.9, sketch.rank(900.0)!!, 0.011)
+        assertEquals(1.0, sketch.rank(5000.0)!!, 1e-9)
+        assertEquals(0.0, sketch.rank(1.0)!!, 1e-9)
+    }
+
+    @Test
+    fun testMergeMatchesSingleSketchAndRemoveUndoesAdd() {
+        val random = Random(3)
+        val values = List(10_000) { random.nextDouble(100.0, 1000.0) }
+        val whole = QuantileSketch()
+        val left = QuantileSketch()
+        val right = QuantileSketch()
+        values.forEachIndexed { i, value ->
+            whole.add(value)
+            if (i % 3 == 0) left.add(value) else right.add(value)
+        }
+
+        left.merge(right)
+        assertEquals(whole.count, left.count)
+        listOf(0.1, 0.5, 0.9).forEach { assertEquals(whole.quantile(it), left.quantile(it)) }
+
+        left.add(5000.0)
+        assertTrue(left.remove(5000.0))
+        assertFalse(left.remove(20_000.0))
+        assertEquals(whole.quantile(1.0), left.quantile(1.0))
+    }
+
+    @Test
+    fun testRunSketchesSerializeAndMerge() {
+        val device = RunSketches()
+        (1..200).forEach { device.upsert("run$it", 5000.0, 300.0 + it, 330.0 - it * 0.1) }
+        device.upsert("run1", 12_000.0, 600.0, 290.0)       // moves to another bucket
+        assertTrue(device.remove("run2"))
+
+        val json = Json.encodeToString(device)
+        val decoded = Json.decodeFromString(RunSketches.serializer(), json)
+        assertEquals(198L, decoded.count(DistanceBucket.SHORT_RUN, RunMetric.PPI))
+        assertEquals(1L, decoded.count(DistanceBucket.MEDIUM_RUN, RunMetric.PACE))
+        assertEquals(device.quantile(DistanceBucket.SHORT_RUN, RunMetric.PPI, 0.9), decoded.quantile(DistanceBucket.SHORT_RUN, RunMetric.PPI, 0.9))
+        assertTrue(json.length < 20_000, "serialized size ${json.length}")
+
+        // Keyed by source, a repeated push replaces the earlier one instead of adding to it
+        val local = RunSketches()
+        local.upsert("server1", 5000.0, 450.0, 280.0)
+        val merged = MergedRunSketches(local)
+        merged.put("watch", decoded)
+        merged.put("watch", decoded)
+        assertEquals(199L, merged.combined().count(DistanceBucket.SHORT_RUN, RunMetric.PPI))
+        merged.put("phone", decoded)
+        assertEquals(397L, merged.combined().count(DistanceBucket.SHORT_RUN, RunMetric.PPI))
+        local.upsert("server2", 5000.0, 460.0, 270.0)
+        merged.invalidate()
+        assertEquals(398L, merged.combined().count(DistanceBucket.SHORT_RUN, RunMetric.PPI))
+        assertTrue(merged.remove("phone"))
+        assertEquals(200L, merged.combined().count(DistanceBucket.SHORT_RUN, RunMetric.PPI))
+
+        // A run near the top of its bucket ranks near 1.0 on PPI
+        assertTrue(device.rank(DistanceBucket.SHORT_RUN, RunMetric.PPI, 495.0)!! > 0.95)
+    }
+}
@@ -0,0 +1,95 @@
+package com.mebeatme.shared.persistence
+
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class BestsIndexTest {
+    
+    @Test
+    fun testBestPerBand() {
+        val index = BestsIndex()
+        index.upsert("a", 5000.0, 1300, 1000L)
+        index.upsert("b", 5050.0, 1250, 2000L)
+        index.upsert("c", 10000.0, 2700, 3000L)
+        index.upsert("d", 7000.0, 1000, 4000L) // outside every band
+        
+        assertEquals(1250, index.bestSeconds(BestsBand.FIVE_K))
+        assertEquals(2700, index.bestSeconds(BestsBand.TEN_K))
+        assertNull(index.bestSeconds(BestsBand.HALF))
+        assertFalse(index.remove("d"))
+    }
+    
+    @Test
+    fun testDeletingBestFallsBackToNext() {
+        val index = BestsIndex()
+        index.upsert("a", 5000.0, 1300, 1000L)
+        index.upsert("b", 5000.0, 1250, 2000L)
+        index.upsert("c", 5000.0, 1400, 3000L)
+        
+        assertTrue(index.remove("b"))
+        assertEquals(1300, index.bestSeconds(BestsBand.FIVE_K))
+        assertTrue(index.remove("a"))
+        assertEquals(1400, index.bestSeconds(BestsBand.FIVE_K))
+        assertTrue(index.remove("c"))
+        assertNull(index.bestSeconds(BestsBand.FIVE_K))
+    }
+    
+    @Test
+    fun testUpsertMovesRunBetweenBands() {
+        val index = BestsIndex()
+        index.upsert("a", 5000.0, 1200, 1000L)
+        index.upsert("a", 10000.0, 2500, 1000L)
+        
+        assertNull(index.bestSeconds(BestsBand.FIVE_K))
+        assertEquals(2500, index.bestSeconds(BestsBand.TEN_K))
+    }
+    
+    @Test
+    fun testSinceSkipsOlderBest() {
+        val index = BestsIndex()
+        index.upsert("old", 5000.0, 1100, 1000L)
+        index.upsert("new", 5000.0, 1300, 5000L)
+        
+        assertEquals(1100, index.bestSeconds(BestsBand.FIVE_K))
+        assertEquals(1300, index.bestSeconds(BestsBand.FIVE_K, sinceMs = 2000L))
+        assertNull(index.bestSeconds(BestsBand.FIVE_K, sinceMs = 6000L))
+    }
+    
+    @Test
+    fun testToleranceBandsMatchServerRanges() {
+        val index = BestsIndex(BestsBand.withTolerance(0.05))
+        index.upsert("a", 5240.0, 1300, 0L)
+        index.upsert("b", 20100.0, 5000, 0L)
+        
+        assertEquals(listOf(1300, null, 5000, null), index.bestSecondsByBand())
+    }
+    
+    @Test
+    fun testRandomUpsertsAndDeletesMatchFullScan() {
+        val random = Random(8)
+        val index = BestsIndex()
+        val live = mutableMapOf<String, Pair<Double, Int>>()
+        
+        repeat(5000) {
+            val id = "run${random.nextInt(400)}"
+            if (random.nextInt(4) == 0) {
+                index.remove(id)
+                live.remove(id)
+            } else {
+                val distance = listOf(5000.0, 10000.0, 21097.0, 42195.0, 8000.0)[random.nextInt(5)]
+                val seconds = random.nextInt(900, 15_000)
+                index.upsert(id, distance, seconds, 0L)
+                live[id] = distance to seconds
+            }
+            
+            for (band in BestsBand.STANDARD) {
+                val expected = live.values.filter { band.contains(it.first) }.minOfOrNull { it.second }
+                assertEquals(expected, index.bestSeconds(band))
+            }
+        }
+    }
+}
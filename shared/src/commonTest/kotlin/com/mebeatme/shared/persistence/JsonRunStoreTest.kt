@@ -182,9 +182,11 @@ class JsonRunStoreTest {
         val runs = listOf(createRunDTO("run1", 100.0))
         store.upsertAll(runs)
         
-        // Verify file exists and is valid JSON
-        assertTrue(dataFile.exists())
-        val content = dataFile.readText()
+        // Verify the run went to the log, and JSON is still available as an export
+        val logFile = File(dataFile.path + ".log")
+        assertTrue(logFile.exists())
+        assertEquals("MBMLOG", logFile.readBytes().copyOfRange(0, 6).decodeToString())
+        val content = store.exportJson()
         assertTrue(content.contains("run1"))
         assertTrue(content.contains("100.0"))
     }
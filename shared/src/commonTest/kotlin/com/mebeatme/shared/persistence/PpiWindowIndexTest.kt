@@ -0,0 +1,80 @@
+package com.mebeatme.shared.persistence
+
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class PpiWindowIndexTest {
+    
+    private val day = 24L * 3600_000
+    
+    @Test
+    fun testWindowMax() {
+        val index = PpiWindowIndex()
+        index.upsert("a", 10 * day, 500.0)
+        index.upsert("b", 50 * day, 700.0)
+        index.upsert("c", 95 * day, 600.0)
+        index.upsert("d", 99 * day, null) // not indexed
+        
+        val now = 100 * day
+        assertEquals(600.0, index.maxPpiInWindow(now, 7))
+        assertEquals(700.0, index.maxPpiInWindow(now, 60))
+        assertEquals(700.0, index.maxPpiInWindow(now, 365))
+        assertNull(index.maxPpiInWindow(now, 0))
+        assertEquals(3, index.size)
+        assertFalse(index.remove("d"))
+    }
+    
+    @Test
+    fun testDeleteAndMoveRecomputeMax() {
+        val index = PpiWindowIndex()
+        index.upsert("a", 1 * day, 500.0)
+        index.upsert("b", 2 * day, 900.0)
+        
+        assertTrue(index.remove("b"))
+        assertEquals(500.0, index.maxPpi(0L))
+        
+        index.upsert("a", 5 * day, 400.0)
+        assertNull(index.maxPpi(0L, 4 * day))
+        assertEquals(400.0, index.maxPpi(0L))
+    }
+    
+    @Test
+    fun testBatchedWindowsMatchSingleQueries() {
+        val index = PpiWindowIndex()
+        val random = Random(3)
+        repeat(2000) { index.upsert("run$it", random.nextLong(0, 400 * day), random.nextDouble(100.0, 1500.0)) }
+        
+        val now = 400 * day
+        val windows = listOf(90, 7, 365, 30, 30)
+        val batched = index.maxPpiInWindows(now, windows)
+        windows.forEachIndexed { i, days -> assertEquals(index.maxPpiInWindow(now, days), batched[i], "$days days") }
+    }
+    
+    @Test
+    fun testRandomUpdatesMatchFullScan() {
+        val index = PpiWindowIndex()
+        val live = mutableMapOf<String, Pair<Long, Double>>()
+        val random = Random(11)
+        
+        repeat(3000) {
+            val id = "run${random.nextInt(300)}"
+            if (random.nextInt(5) == 0) {
+                assertEquals(live.remove(id) != null, index.remove(id))
+            } else {
+                val startedAt = random.nextLong(0, 1000)
+                val ppi = random.nextDouble(0.0, 2000.0)
+                index.upsert(id, startedAt, ppi)
+                live[id] = startedAt to ppi
+            }
+            
+            val from = random.nextLong(0, 1000)
+            val to = random.nextLong(from, 1001)
+            val expected = live.values.filter { it.first in from..to }.maxOfOrNull { it.second }
+            assertEquals(expected, index.maxPpi(from, to))
+        }
+    }
+}
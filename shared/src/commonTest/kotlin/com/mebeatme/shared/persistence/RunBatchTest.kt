@@ -0,0 +1,108 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.core.calculateBests
+import com.mebeatme.shared.core.calculateBestsPacked
+import com.mebeatme.shared.model.RunDTO
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class RunBatchTest {
+
+    @Test
+    fun testRoundTripKeepsEveryPackedField() {
+        val runs = listOf(
+            createRunDTO("run1", 5000.0, 1500, efforts = mapOf("5k" to 1490, "1k" to 280)),
+            createRunDTO("ünïcode-run", 21097.0, 6000, ppi = null).copy(avgHr = 152, notes = "Windy 🌬", ppiCurveVersion = "purdy-cubic-v1"),
+            createRunDTO("run3", 42195.0, 12000, efforts = mapOf("5k" to 1200, "10k" to 2500, "half" to 5600, "full" to 12000))
+        )
+
+        val batch = RunBatch.of(runs)
+        assertEquals(3, batch.size)
+        // The pace curve and efforts outside the standard bands stay in the store
+        assertEquals(runs.map { it.copy(maxDistanceByDurationM = emptyList(), bestEffortsSec = it.bestEffortsSec - "1k") }, batch.toList())
+        assertNull(batch.ppi(1))
+        assertNull(batch.bestEffortSeconds(0, 1))
+        assertEquals(RunBatch.of(emptyList()).toList(), emptyList<RunDTO>())
+    }
+
+    @Test
+    fun testFixedLayoutForInPlaceReaders() {
+        val runs = List(3) { createRunDTO("run$it", 5000.0, 1500 + it) }
+        val bytes = RunBatchCodec.encode(runs)
+
+        // Swift reads these positions directly; see PackedRuns.swift
+        assertEquals(1, RunBatchCodec.readShort(bytes, 8))
+        assertEquals(RunBatchCodec.RECORD_SIZE, RunBatchCodec.readShort(bytes, 10))
+        assertEquals(3, RunBatchCodec.readInt(bytes, 12))
+        val secondRecord = RunBatchCodec.HEADER_SIZE + RunBatchCodec.RECORD_SIZE
+        assertEquals(1501, RunBatchCodec.readInt(bytes, secondRecord + RunBatchCodec.OFFSET_ELAPSED))
+        assertEquals(0xDD.toByte(), bytes[secondRecord + RunBatchCodec.OFFSET_ELAPSED])
+        assertEquals(5000.0, Double.fromBits(RunBatchCodec.readLong(bytes, secondRecord + RunBatchCodec.OFFSET_DISTANCE)))
+        assertEquals(0, RunBatchCodec.readInt(bytes, 16) % 8)
+
+        // Three ids plus one shared source
+        val stringsOffset = RunBatchCodec.readInt(bytes, 16)
+        assertEquals(4, RunBatchCodec.readInt(bytes, stringsOffset))
+        assertEquals(RunBatchCodec.readInt(bytes, RunBatchCodec.HEADER_SIZE + RunBatchCodec.OFFSET_SOURCE), RunBatchCodec.readInt(bytes, secondRecord + RunBatchCodec.OFFSET_SOURCE))
+    }
+
+    @Test
+    fun testRejectsForeignAndTruncatedBuffers() {
+        val bytes = RunBatchCodec.encode(List(10) { createRunDTO("run$it", 5000.0, 1500) })
+        assertFailsWith<IllegalArgumentException> { RunBatch(ByteArray(64)) }
+        assertFailsWith<IllegalArgumentException> { RunBatch(bytes.copyOf(bytes.size - 1)) }
+        assertFailsWith<IndexOutOfBoundsException> { RunBatch(bytes)[10] }
+
+        // Header and string table fields that would point outside the buffer
+        val stringsOffset = RunBatchCodec.readInt(bytes, 16)
+        fun corrupt(at: Int, value: Int) = bytes.copyOf().also { RunBatchCodec.writeInt(it, at, value) }
+        assertFailsWith<IllegalArgumentException> { RunBatch(corrupt(20, 0)) }
+        assertFailsWith<IllegalArgumentException> { RunBatch(corrupt(12, -1)) }
+        assertFailsWith<IllegalArgumentException> { RunBatch(corrupt(stringsOffset, 1_000_000)) }
+        assertFailsWith<IllegalArgumentException> { RunBatch(corrupt(stringsOffset, -2)) }
+        assertFailsWith<IllegalArgumentException> { RunBatch(corrupt(stringsOffset + 8, 1_000_000)) }
+        assertFailsWith<IllegalArgumentException> { RunBatch(corrupt(stringsOffset + 8, -5)) }
+    }
+
+    @Test
+    fun testPackedBestsMatchListBests() {
+        val random = Random(24)
+        val distances = listOf(3000.0, 5000.0, 10000.0, 21097.0, 42195.0)
+        val runs = List(2000) { i ->
+            val distance = distances[random.nextInt(distances.size)]
+            val efforts = BestsBand.STANDARD.filter { random.nextBoolean() }.associate { it.name to 1000 + random.nextInt(10_000) }
+            createRunDTO("run$i", distance, 900 + random.nextInt(12_000), efforts = efforts, startedAtEpochMs = i * 3_600_000L)
+        }
+        val batch = RunBatch.of(runs)
+
+        assertEquals(calculateBests(runs), calculateBestsPacked(batch))
+        assertEquals(calculateBests(runs, sinceMs = 1000 * 3_600_000L), calculateBestsPacked(batch, sinceMs = 1000 * 3_600_000L))
+        assertTrue(batch.bytes.size < runs.size * (RunBatchCodec.RECORD_SIZE + 16))
+    }
+
+    private fun createRunDTO(
+        id: String,
+        distanceMeters: Double,
+        elapsedSeconds: Int,
+        ppi: Double? = 400.0,
+        efforts: Map<String, Int> = emptyMap(),
+        startedAtEpochMs: Long = 1757300000000L
+    ): RunDTO {
+        return RunDTO(
+            id = id,
+            source = "GPX",
+            startedAtEpochMs = startedAtEpochMs,
+            endedAtEpochMs = startedAtEpochMs + elapsedSeconds * 1000L,
+            distanceMeters = distanceMeters,
+            elapsedSeconds = elapsedSeconds,
+            avgPaceSecPerKm = elapsedSeconds / (distanceMeters / 1000.0),
+            ppi = ppi,
+            bestEffortsSec = efforts,
+            maxDistanceByDurationM = listOf(100.0, 200.0)
+        )
+    }
+}
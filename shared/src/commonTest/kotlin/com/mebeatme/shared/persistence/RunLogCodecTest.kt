@@ -0,0 +1,129 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+class RunLogCodecTest {
+    
+    @Test
+    fun testRoundTripAndReplay() {
+        val log = RunLog(RunDTO.serializer()) { it.id }
+        val records = listOf(
+            log.upsert(createRunDTO("run1", 1200)),
+            log.upsert(createRunDTO("run2", 1300)),
+            log.upsert(createRunDTO("run1", 1100)),
+            log.delete("run2"),
+            log.upsert(createRunDTO("run3", 1500))
+        )
+        
+        val decoded = RunLogCodec.decode(RunLogCodec.MAGIC + RunLogCodec.encodeAll(records))
+        assertEquals(records.map { it.seq }, decoded.records.map { it.seq })
+        assertContentEquals(records[3].payload, decoded.records[3].payload)
+        
+        val replayLog = RunLog(RunDTO.serializer()) { it.id }
+        val runs = replayLog.replay(decoded.records)
+        assertEquals(listOf("run1", "run3"), runs.map { it.id })
+        assertEquals(1100, runs[0].elapsedSeconds)
+        assertEquals(5L, replayLog.lastSeq)
+        assertEquals(6L, replayLog.clear().seq)
+    }
+    
+    @Test
+    fun testTornTailAndCorruptRecordStopDecoding() {
+        val log = RunLog(RunDTO.serializer()) { it.id }
+        val first = RunLogCodec.MAGIC + RunLogCodec.encode(log.upsert(createRunDTO("run1", 1200)))
+        val second = RunLogCodec.encode(log.upsert(createRunDTO("run2", 1300)))
+        
+        // Crash mid-append: the second record is cut short
+        val torn = RunLogCodec.decode(first + second.copyOfRange(0, second.size - 3))
+        assertEquals(1, torn.records.size)
+        assertEquals(first.size, torn.validLength)
+        
+        // Flipped payload byte: checksum rejects the record
+        val flipped = second.copyOf().also { it[it.size - 2] = (it[it.size - 2] + 1).toByte() }
+        assertEquals(1, RunLogCodec.decode(first + flipped).records.size)
+        
+        // Replayed or reordered record: sequence must advance
+        assertEquals(1, RunLogCodec.decode(first + first.copyOfRange(RunLogCodec.MAGIC.size, first.size)).records.size)
+        
+        // Preallocated zeros after the last record are a tail too
+        val zeros = RunLogCodec.decode(first + ByteArray(4096))
+        assertEquals(1, zeros.records.size)
+        assertEquals(first.size, zeros.validLength)
+        assertFalse(zeros.needsRewrite)
+    }
+    
+    @Test
+    fun testDamagedMiddleRecordKeepsLaterRecords() {
+        val log = RunLog(RunDTO.serializer()) { it.id }
+        val encoded = (1..5).map { RunLogCodec.encode(log.upsert(createRunDTO("run$it", 1200 + it))) }
+        val damaged = encoded[2].copyOf().also { it[it.size / 2] = (it[it.size / 2].toInt() xor 0x10).toByte() }
+        val bytes = RunLogCodec.MAGIC + encoded[0] + encoded[1] + damaged + encoded[3] + encoded[4]
+        
+        val decoded = RunLogCodec.decode(bytes)
+        assertEquals(listOf(1L, 2L, 4L, 5L), decoded.records.map { it.seq })
+        assertEquals(bytes.size, decoded.validLength)
+        assertTrue(decoded.needsRewrite)
+        assertEquals(1, decoded.damagedRecords)
+        assertEquals(damaged.size, decoded.damagedBytes)
+        
+        val rewritten = RunLogCodec.decode(RunLogCodec.MAGIC + RunLogCodec.encodeAll(decoded.records))
+        assertEquals(listOf(1L, 2L, 4L, 5L), rewritten.records.map { it.seq })
+        assertFalse(rewritten.needsRewrite)
+    }
+    
+    @Test
+    fun testReadsVersion1LogsAndAsksForRewrite() {
+        val log = RunLog(RunDTO.serializer()) { it.id }
+        val record = RunLogCodec.encode(log.upsert(createRunDTO("run1", 1200)))
+        // Version 1 checksummed records with CRC-32
+        val v1Record = record.copyOf().also { writeInt(it, 4, Crc32.compute(it, 8, it.size)) }
+        val v1Header = RunLogCodec.MAGIC.copyOf().also { it[7] = 1 }
+        
+        val decoded = RunLogCodec.decode(v1Header + v1Record)
+        assertEquals(1, decoded.records.size)
+        assertTrue(decoded.needsRewrite)
+        assertEquals(0, decoded.damagedRecords)
+        // A version 1 record under the current header fails its checksum
+        assertEquals(0, RunLogCodec.decode(RunLogCodec.MAGIC + v1Record).records.size)
+    }
+    
+    @Test
+    fun testRejectsForeignFile() {
+        assertFailsWith<IllegalArgumentException> { RunLogCodec.decode("[{\"id\":\"run1\"}]".encodeToByteArray()) }
+    }
+    
+    @Test
+    fun testCrc32KnownValue() {
+        // Standard check value for "123456789"
+        assertEquals(0xCBF43926.toInt(), Crc32.compute("123456789".encodeToByteArray()))
+    }
+    
+    @Test
+    fun testCrc32cKnownValues() {
+        // Check value for "123456789", then a length that exercises both the 8-byte and tail loops
+        assertEquals(0xE3069283.toInt(), Crc32c.compute("123456789".encodeToByteArray()))
+        assertEquals(0x02FE26A8, Crc32c.compute("123456789abcdefghij".repeat(3).encodeToByteArray()))
+    }
+    
+    private fun writeInt(out: ByteArray, at: Int, value: Int) {
+        for (i in 0 until 4) out[at + i] = (value ushr (24 - 8 * i)).toByte()
+    }
+    
+    private fun createRunDTO(id: String, seconds: Int): RunDTO {
+        return RunDTO(
+            id = id,
+            source = "test",
+            startedAtEpochMs = 0L,
+            endedAtEpochMs = seconds * 1000L,
+            distanceMeters = 5000.0,
+            elapsedSeconds = seconds,
+            avgPaceSecPerKm = seconds / 5.0
+        )
+    }
+}
@@ -0,0 +1,83 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.DistanceBucket
+import kotlinx.datetime.LocalDate
+import kotlinx.datetime.TimeZone
+import kotlinx.datetime.atStartOfDayIn
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+class RunRollupsTest {
+    
+    private fun at(year: Int, month: Int, day: Int, hour: Int = 7): Long =
+        LocalDate(year, month, day).atStartOfDayIn(TimeZone.UTC).toEpochMilliseconds() + hour * 3600_000L
+    
+    @Test
+    fun testDayWeekAndMonthAggregates() {
+        val rollups = RunRollups()
+        // 2024-01-01 is a Monday
+        rollups.upsert("a", at(2024, 1, 1), 5000.0, 1500, 600.0)
+        rollups.upsert("b", at(2024, 1, 1, 18), 10000.0, 3300, 700.0)
+        rollups.upsert("c", at(2024, 1, 7), 2000.0, 500, null)
+        rollups.upsert("d", at(2024, 1, 8), 21097.0, 7000, 650.0)
+        
+        val days = rollups.rows(RollupPeriod.DAY, at(2024, 1, 1, 0), at(2024, 1, 31))
+        assertEquals(3, days.size)
+        assertEquals(2, days[0].runCount)
+        assertEquals(15000.0, days[0].totalDistanceMeters)
+        assertEquals(4800L, days[0].totalSeconds)
+        assertEquals(700.0, days[0].maxPpi)
+        assertEquals(300.0, days[0].bestPaceSecPerKm)
+        
+        val weeks = rollups.rows(RollupPeriod.WEEK, at(2024, 1, 1, 0), at(2024, 1, 31))
+        assertEquals(listOf(3, 1), weeks.map { it.runCount })
+        assertEquals(at(2024, 1, 8, 0), weeks[1].startEpochMs)
+        assertEquals(mapOf(DistanceBucket.SHORT_RUN to 1, DistanceBucket.MEDIUM_RUN to 1, DistanceBucket.SPRINT to 1), weeks[0].bucketCounts)
+        
+        val months = rollups.rows(RollupPeriod.MONTH, at(2024, 1, 1, 0), at(2024, 1, 31))
+        assertEquals(1, months.size)
+        assertEquals(4, months[0].runCount)
+        assertEquals(700.0, months[0].maxPpi)
+    }
+    
+    @Test
+    fun testDeleteAndMoveUpdateEveryPeriod() {
+        val rollups = RunRollups()
+        rollups.upsert("a", at(2024, 2, 29), 5000.0, 1500, 900.0)
+        rollups.upsert("b", at(2024, 2, 29), 5000.0, 1600, 500.0)
+        
+        assertTrue(rollups.remove("a"))
+        assertFalse(rollups.remove("a"))
+        assertEquals(500.0, rollups.rows(RollupPeriod.MONTH, at(2024, 2, 1), at(2024, 2, 29)).single().maxPpi)
+        
+        rollups.upsert("b", at(2024, 3, 1), 5000.0, 1600, 500.0)
+        assertTrue(rollups.rows(RollupPeriod.MONTH, at(2024, 2, 1), at(2024, 2, 29)).isEmpty())
+        assertEquals(1, rollups.rows(RollupPeriod.MONTH, at(2024, 3, 1), at(2024, 3, 31)).single().runCount)
+        // 2024-02-26 starts the ISO week that holds both 29 Feb and 1 Mar
+        assertEquals(1, rollups.rows(RollupPeriod.WEEK, at(2024, 2, 26), at(2024, 3, 3)).single().runCount)
+    }
+    
+    @Test
+    fun testRollupsMatchRawTotals() {
+        val rollups = RunRollups()
+        val random = Random(21)
+        val runs = (0 until 2000).map { i ->
+            val distance = random.nextDouble(800.0, 30_000.0)
+            Triple("run$i", at(2023, 1, 1) + random.nextLong(0, 730L * 24 * 3600_000), distance)
+        }
+        runs.forEach { (id, start, distance) -> rollups.upsert(id, start, distance, (distance / 3).toInt(), distance / 20) }
+        runs.take(300).forEach { rollups.remove(it.first) }
+        val live = runs.drop(300)
+        
+        for (period in RollupPeriod.values()) {
+            val rows = rollups.rows(period, 0L, at(2030, 1, 1))
+            assertEquals(live.size, rows.sumOf { it.runCount }, "$period")
+            assertEquals(live.sumOf { it.third }, rows.sumOf { it.totalDistanceMeters }, 1e-3)
+            assertEquals(live.maxOf { it.third / 20 }, rows.mapNotNull { it.maxPpi }.maxOrNull())
+            assertEquals(rows.sortedBy { it.startEpochMs }, rows)
+        }
+    }
+}
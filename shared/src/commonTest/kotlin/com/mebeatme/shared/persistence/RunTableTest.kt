@@ -0,0 +1,54 @@
+package com.mebeatme.shared.persistence
+
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class RunTableTest {
+    
+    private data class Entry(val id: String, val value: Int)
+    
+    @Test
+    fun testUpsertKeepsSlotAndDeleteLeavesOrder() {
+        val table = RunTable<Entry> { it.id }
+        assertTrue(table.upsert(Entry("a", 1)))
+        assertTrue(table.upsert(Entry("b", 2)))
+        assertTrue(table.upsert(Entry("c", 3)))
+        assertFalse(table.upsert(Entry("a", 10)))
+        
+        assertTrue(table.remove("b"))
+        assertFalse(table.remove("b"))
+        assertNull(table["b"])
+        assertEquals(listOf(Entry("a", 10), Entry("c", 3)), table.toList())
+        
+        table.upsert(Entry("b", 4))
+        assertEquals(listOf("a", "c", "b"), table.toList().map { it.id })
+        assertEquals(3, table.size)
+    }
+    
+    @Test
+    fun testMatchesReferenceMapUnderChurn() {
+        // Heavy delete/reinsert churn exercises tombstone reuse, rehashing and slot compaction
+        val random = Random(16)
+        val table = RunTable<Entry> { it.id }
+        val reference = LinkedHashMap<String, Entry>()
+        repeat(200_000) { step ->
+            val id = "run${random.nextInt(3_000)}"
+            if (random.nextInt(3) == 0) {
+                assertEquals(reference.remove(id) != null, table.remove(id))
+            } else {
+                val entry = Entry(id, step)
+                assertEquals(id !in reference, table.upsert(entry))
+                reference[id] = entry
+            }
+        }
+        
+        assertEquals(reference.size, table.size)
+        assertEquals(reference.values.toList(), table.toList())
+        reference.keys.forEach { assertEquals(reference[it], table[it]) }
+        assertNull(table["missing"])
+    }
+}
@@ -0,0 +1,174 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertFalse
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class RunTiersTest {
+
+    private val nowMs = 1757300000000L
+    private val dayMs = 24L * 3600 * 1000
+
+    @Test
+    fun testResidentRunsStayWithinPolicy() {
+        val table = open(MemoryColdSegmentFile(), TierPolicy(hotDays = 30, maxResidentRuns = 20))
+        val runs = (0 until 500).map { createRunDTO("run$it", nowMs - (500 - it) * dayMs / 4) }
+
+        runs.chunked(7).forEach { batch ->
+            batch.forEach { table.upsert(it) }
+            table.settle()
+            assertTrue(table.metrics().residentRuns <= 20)
+        }
+
+        val metrics = table.metrics()
+        assertEquals(20, metrics.residentRuns)
+        assertEquals(480, metrics.coldRuns)
+        assertEquals(runs, table.toList())
+        assertEquals(runs[3], table["run3"])
+        assertEquals(runs.filter { it.startedAtEpochMs >= nowMs - 10 * dayMs }, table.startedSince(nowMs - 10 * dayMs))
+        assertTrue(table.metrics().coldReads > 480)
+    }
+
+    @Test
+    fun testRunsLeaveTheHotWindow() {
+        val table = open(MemoryColdSegmentFile(), TierPolicy(hotDays = 7, maxResidentRuns = 100))
+        (0 until 30).forEach { table.upsert(createRunDTO("run$it", nowMs - it * dayMs)) }
+        table.settle()
+
+        assertEquals(8, table.metrics().residentRuns)
+        assertEquals(30, table.size)
+        assertEquals(nowMs - 20 * dayMs, table["run20"]?.startedAtEpochMs)
+    }
+
+    @Test
+    fun testReloadAfterCheckpointAndDeletes() {
+        val segment = MemoryColdSegmentFile()
+        val table = open(segment, TierPolicy(hotDays = 30, maxResidentRuns = 5))
+        val expected = LinkedHashMap<String, RunDTO>()
+        val random = Random(23)
+        repeat(1000) { step ->
+            val run = createRunDTO("run${random.nextInt(80)}", nowMs - random.nextInt(100) * dayMs, ppi = step.toDouble())
+            if (random.nextInt(4) == 0) {
+                assertEquals(run.id in expected, table.remove(run.id))
+                expected.remove(run.id)
+            } else {
+                table.upsert(run)
+                expected[run.id] = run
+            }
+            table.settle()
+            if (step % 100 == 99) table.checkpoint()
+        }
+        table.checkpoint()
+
+        // The callbacks see every record's effect, as the store's indexes do
+        val indexed = mutableSetOf<String>()
+        val reloaded = TieredRunTable(segment) { nowMs }
+        reloaded.policy = table.policy
+        reloaded.load(upsert = { indexed.add(it.id) }, delete = { indexed.remove(it) }, clear = { indexed.clear() })
+
+        assertEquals(expected.size, reloaded.size)
+        assertEquals(expected.keys, indexed)
+        expected.values.forEach { assertEquals(it, reloaded[it.id]) }
+        assertTrue(reloaded.metrics().residentRuns <= 5)
+        assertTrue(table.metrics().rewrites > 0, "superseded records were never reclaimed")
+    }
+
+    @Test
+    fun testDeletedRunsStayDeletedAfterReload() {
+        val segment = MemoryColdSegmentFile()
+        val table = open(segment, TierPolicy(maxResidentRuns = 0))
+        (1..3).forEach { table.upsert(createRunDTO("run$it", nowMs)) }
+        table.settle()
+        assertEquals(3, table.metrics().coldRuns)
+
+        // Replace cold runs with dirty copies, then remove them: the old records must be cancelled
+        table.upsert(createRunDTO("run1", nowMs, ppi = 200.0))
+        assertTrue(table.remove("run1"))
+        table.upsert(createRunDTO("run2", nowMs, ppi = 200.0))
+        table.settle()
+        assertTrue(table.remove("run2"))
+        // Remove, re-add and remove again before any checkpoint
+        assertTrue(table.remove("run3"))
+        table.upsert(createRunDTO("run3", nowMs, ppi = 300.0))
+        assertTrue(table.remove("run3"))
+        table.checkpoint()
+        assertEquals(0, table.metrics().rewrites)
+
+        val deleted = mutableSetOf<String>()
+        val reloaded = TieredRunTable(segment) { nowMs }
+        reloaded.load(upsert = {}, delete = { deleted.add(it) }, clear = {})
+        assertEquals(0, reloaded.size)
+        assertEquals(setOf("run1", "run2", "run3"), deleted)
+
+        // A reload queues no further deletes
+        val bytes = segment.length
+        reloaded.checkpoint()
+        assertEquals(bytes, segment.length)
+        assertEquals(table.metrics().deadColdBytes, reloaded.metrics().deadColdBytes)
+    }
+
+    @Test
+    fun testTornTailIsCutAndDamageFails() {
+        val segment = MemoryColdSegmentFile()
+        open(segment, TierPolicy()).apply {
+            (1..10).forEach { upsert(createRunDTO("run$it", nowMs - it * dayMs)) }
+            checkpoint()
+        }
+        val intact = segment.length
+        segment.append(RunLogCodec.encode(RunLogRecord(99, RunLogOp.UPSERT, "{\"id\":".encodeToByteArray())).copyOf(12))
+
+        val recovered = TieredRunTable(segment) { nowMs }
+        recovered.load(upsert = {}, delete = {}, clear = {})
+        assertEquals(10, recovered.size)
+        assertEquals(intact, segment.length)
+
+        val bytes = segment.read(0, intact.toInt())
+        bytes[RunLogCodec.MAGIC.size + RunLogCodec.RECORD_OVERHEAD + 2] = 'X'.code.toByte()
+        segment.rewrite { it(bytes) }
+        assertFailsWith<IllegalStateException> {
+            TieredRunTable(segment) { nowMs }.load(upsert = {}, delete = {}, clear = {})
+        }
+    }
+
+    @Test
+    fun testClearEmptiesTheSegment() {
+        val segment = MemoryColdSegmentFile()
+        val table = open(segment, TierPolicy(maxResidentRuns = 0))
+        (1..10).forEach { table.upsert(createRunDTO("run$it", nowMs)) }
+        table.settle()
+        assertEquals(10, table.metrics().coldRuns)
+
+        table.clear()
+        assertEquals(RunLogCodec.MAGIC.size.toLong(), segment.length)
+        assertNull(table["run1"])
+        assertFalse("run1" in table)
+        assertEquals(0, table.size)
+    }
+
+    private fun open(segment: ColdSegmentFile, policy: TierPolicy): TieredRunTable {
+        val table = TieredRunTable(segment) { nowMs }
+        table.policy = policy
+        table.load(upsert = {}, delete = {}, clear = {})
+        return table
+    }
+
+    private fun createRunDTO(id: String, startedAtEpochMs: Long, ppi: Double = 100.0): RunDTO {
+        return RunDTO(
+            id = id,
+            source = "test",
+            startedAtEpochMs = startedAtEpochMs,
+            endedAtEpochMs = startedAtEpochMs + 1_500_000L,
+            distanceMeters = 5000.0,
+            elapsedSeconds = 1500,
+            avgPaceSecPerKm = 300.0,
+            ppi = ppi,
+            bestEffortsSec = mapOf("5k" to 1500),
+            maxDistanceByDurationM = List(20) { 100.0 * (it + 1) }
+        )
+    }
+}
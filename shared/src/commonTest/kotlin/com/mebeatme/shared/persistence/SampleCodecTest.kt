@@ -0,0 +1,117 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunSample
+import com.mebeatme.shared.model.RunSession
+import kotlinx.datetime.Instant
+import kotlinx.serialization.builtins.ListSerializer
+import kotlinx.serialization.json.Json
+import kotlinx.serialization.json.jsonObject
+import kotlinx.serialization.json.jsonPrimitive
+import kotlin.math.abs
+import kotlin.math.sin
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class SampleCodecTest {
+
+    @Test
+    fun testRoundTripWithinResolution() {
+        val samples = marathon(2000, withGps = true)
+        val decoded = SampleCodec.decode(SampleCodec.encode(samples, blockSize = 100))
+
+        assertEquals(samples.size, decoded.size)
+        samples.zip(decoded).forEach { (expected, actual) ->
+            assertEquals(expected.timestamp, actual.timestamp)
+            assertTrue(abs(expected.distance - actual.distance) <= 0.5 / SampleCodec.DISTANCE_SCALE)
+            assertTrue(abs(expected.pace - actual.pace) <= 0.5 / SampleCodec.PACE_SCALE)
+            assertTrue(abs(expected.latitude!! - actual.latitude!!) <= 0.5 / SampleCodec.DEGREE_SCALE)
+            assertTrue(abs(expected.elevation!! - actual.elevation!!) <= 0.5 / SampleCodec.ELEVATION_SCALE)
+            assertEquals(expected.heartRate, actual.heartRate)
+        }
+    }
+
+    @Test
+    fun testMissingValuesAndNonFinitePace() {
+        val samples = listOf(
+            RunSample(Instant.fromEpochMilliseconds(0), 0.0, Double.NaN, heartRate = 120),
+            RunSample(Instant.fromEpochMilliseconds(1000), 3.0, Double.POSITIVE_INFINITY),
+            RunSample(Instant.fromEpochMilliseconds(2500), 6.5, 300.0, heartRate = 131)
+        )
+        val decoded = SampleCodec.decode(SampleCodec.encode(samples))
+
+        assertTrue(decoded[0].pace.isNaN())
+        assertEquals(Double.POSITIVE_INFINITY, decoded[1].pace)
+        assertEquals(listOf(120, null, 131), decoded.map { it.heartRate })
+        assertNull(decoded[0].latitude)
+        assertEquals(emptyList<RunSample>(), SampleCodec.decode(SampleCodec.encode(emptyList())))
+        assertFailsWith<IllegalArgumentException> { PackedSamples(ByteArray(4)) }
+    }
+
+    @Test
+    fun testBetweenDecodesOnlyMatchingSamples() {
+        val samples = marathon(5000, withGps = false)
+        val packed = PackedSamples(SampleCodec.encode(samples, blockSize = 64))
+        assertEquals(5000, packed.size)
+        assertEquals((5000 + 63) / 64, packed.blockCount)
+
+        val from = samples[1234].timestamp
+        val to = samples[1500].timestamp
+        assertEquals(samples.subList(1234, 1501).map { it.timestamp }, packed.between(from, to).map { it.timestamp })
+        assertEquals(1, packed.between(samples[0].timestamp, samples[0].timestamp).size)
+        assertEquals(0, packed.between(to, from).size)
+    }
+
+    @Test
+    fun testRunSessionCarriesPackedSamples() {
+        val samples = marathon(15_000, withGps = true)
+        val session = RunSession("s1", distance = samples.last().distance, duration = 15_000L, timestamp = samples[0].timestamp, pace = 300.0, samples = samples)
+        val payload = Json.encodeToString(RunSession.serializer(), session)
+        val unpacked = Json.encodeToString(ListSerializer(RunSample.serializer()), samples)
+
+        // The samples travel as one Base64 string, far smaller than a JSON array of them
+        val field = Json.parseToJsonElement(payload).jsonObject.getValue("samples").jsonPrimitive
+        assertTrue(field.isString)
+        assertTrue(unpacked.length >= 5 * payload.length, "JSON ${unpacked.length} vs packed ${payload.length}")
+
+        val decoded = Json.decodeFromString(RunSession.serializer(), payload)
+        assertEquals(session.copy(samples = emptyList()), decoded.copy(samples = emptyList()))
+        assertEquals(SampleCodec.decode(SampleCodec.encode(samples)), decoded.samples)
+        assertEquals(emptyList<RunSample>(), Json.decodeFromString(RunSession.serializer(), Json.encodeToString(RunSession.serializer(), session.copy(samples = emptyList()))).samples)
+    }
+
+    @Test
+    fun testRunSessionReadsLegacySampleArrays() {
+        val samples = marathon(100, withGps = true)
+        val session = RunSession("s1", distance = samples.last().distance, duration = 100L, timestamp = samples[0].timestamp, pace = 300.0, samples = samples)
+        val packed = Json.encodeToString(RunSession.serializer(), session)
+        val unpacked = Json.encodeToString(ListSerializer(RunSample.serializer()), samples)
+        val legacy = packed.replace(Regex("\"samples\":\"[^\"]*\""), "\"samples\":$unpacked")
+
+        // An old payload keeps its samples exactly; nothing was quantized on the way
+        assertEquals(session, Json.decodeFromString(RunSession.serializer(), legacy))
+        assertEquals(emptyList<RunSample>(), Json.decodeFromString(RunSession.serializer(), packed.replace(Regex("\"samples\":\"[^\"]*\""), "\"samples\":[]")).samples)
+    }
+
+    // 1 Hz samples at a gently varying pace with GPS, elevation and heart rate
+    private fun marathon(count: Int, withGps: Boolean): List<RunSample> {
+        val random = Random(19)
+        var distance = 0.0
+        return List(count) { i ->
+            val pace = 300.0 + 20.0 * sin(i / 600.0) + random.nextDouble(-2.0, 2.0)
+            distance += 1000.0 / pace
+            RunSample(
+                timestamp = Instant.fromEpochMilliseconds(1_700_000_000_000L + i * 1000L),
+                distance = distance,
+                pace = pace,
+                latitude = if (withGps) 45.5 + distance * 9e-6 else null,
+                longitude = if (withGps) -73.6 + sin(distance / 500.0) * 1e-3 else null,
+                elevation = if (withGps) 40.0 + 15.0 * sin(distance / 2000.0) else null,
+                heartRate = if (withGps) 150 + (i / 300) % 20 else null
+            )
+        }
+    }
+}
@@ -1,38 +1,60 @@
 package com.mebeatme.shared.persistence
 
+import com.mebeatme.shared.core.putDouble
+import com.mebeatme.shared.core.putInt
+import com.mebeatme.shared.model.BestsDTO
 import com.mebeatme.shared.model.RunDTO
-import com.mebeatme.shared.core.highestPpiInWindow
+import kotlinx.cinterop.ByteVar
+import kotlinx.cinterop.CPointer
+import kotlinx.cinterop.ExperimentalForeignApi
+import kotlinx.datetime.TimeZone
 import kotlinx.serialization.encodeToString
 import kotlinx.serialization.json.Json
 import kotlinx.serialization.decodeFromString
 
 /**
- * iOS implementation of JSON-based persistence layer for MeBeatMe
- * Uses in-memory storage since iOS doesn't have direct file access in commonMain
+ * iOS implementation of the persistence layer for MeBeatMe
+ * Keeps runs in memory. When [dataFile] is a path String, writes also go to the
+ * append-only run log at "<path>.log" (see [RunLogFile]) and opening the store replays it.
  */
-actual class JsonRunStore actual constructor(private val dataFile: Any) {
+actual class JsonRunStore actual constructor(private val dataFile: Any, timeZone: TimeZone) {
+    
+    actual constructor(dataFile: Any) : this(dataFile, TimeZone.currentSystemDefault())
     
     private val json = Json {
         prettyPrint = true
         ignoreUnknownKeys = true
     }
     
-    private val runs = mutableListOf<RunDTO>()
+    private val runs = RunTable<RunDTO> { it.id }
+    private val indexes = RunIndexes(timeZone)
+    private val log = RunLog(RunDTO.serializer()) { it.id }
+    private val logFile = (dataFile as? String)?.let { RunLogFile("$it.log") }
+    
+    init {
+        logFile?.let { file ->
+            log.replay(file.open()).forEach { runs.upsert(it) }
+            indexes.rebuild(runs.toList())
+        }
+    }
     
     actual fun upsertAll(newRuns: List<RunDTO>): Int {
+        logFile?.append(newRuns.map { log.upsert(it) })
         var stored = 0
         newRuns.forEach { newRun ->
-            val existingIndex = runs.indexOfFirst { it.id == newRun.id }
-            if (existingIndex >= 0) {
-                runs[existingIndex] = newRun
-            } else {
-                runs.add(newRun)
-            }
+            runs.upsert(newRun)
+            indexes.upsert(newRun)
             stored++
         }
         return stored
     }
     
+    // Like every write on this store, atomic for callers that keep the store on one thread
+    actual fun replaceIfUnchanged(updates: List<Pair<RunDTO, RunDTO>>): Int {
+        val unchanged = updates.filter { (read, replacement) -> read.id == replacement.id && runs[read.id] == read }
+        return if (unchanged.isEmpty()) 0 else upsertAll(unchanged.map { it.second })
+    }
+    
     actual fun listSince(sinceMs: Long): List<RunDTO> {
         return runs.filter { it.startedAtEpochMs >= sinceMs }
     }
@@ -42,27 +64,72 @@ actual class JsonRunStore actual constructor(private val dataFile: Any) {
     }
     
     actual fun getHighestPpiLast90Days(nowMs: Long, days: Int): Double? {
-        return highestPpiInWindow(runs, nowMs, days)
+        return indexes.ppiWindows.maxPpiInWindow(nowMs, days)
+    }
+    
+    actual fun getHighestPpiInWindows(nowMs: Long, days: List<Int>): List<Double?> {
+        return indexes.ppiWindows.maxPpiInWindows(nowMs, days)
+    }
+    
+    actual fun getBests(nowMs: Long, sinceMs: Long): BestsDTO {
+        return indexes.bests.toBestsDTO(sinceMs, indexes.ppiWindows.maxPpiInWindow(nowMs, 90))
+    }
+    
+    /**
+     * [getBests] written into an MBMBests the caller owns (shared/include/mebeatme_flat.h),
+     * so a bests refresh allocates no boxed bridge objects.
+     * @param out At least FlatBests.SIZE bytes, 8-aligned
+     */
+    @OptIn(ExperimentalForeignApi::class)
+    fun writeBests(nowMs: Long, sinceMs: Long, out: CPointer<ByteVar>) {
+        indexes.writeFlatBests(nowMs, sinceMs, { at, value -> out.putInt(at, value) }, { at, value -> out.putDouble(at, value) })
+    }
+    
+    actual fun getRollups(period: RollupPeriod, fromMs: Long, toMs: Long): List<RollupRow> {
+        return indexes.rollups.rows(period, fromMs, toMs)
+    }
+    
+    actual fun getSustainedPaceSecPerKm(durationSec: Double): Double? {
+        return indexes.paceEnvelope.sustainedPaceSecPerKm(durationSec)
+    }
+    
+    actual fun getSketches(): RunSketches {
+        return indexes.sketches.copy()
     }
     
     actual fun getById(id: String): RunDTO? {
-        return runs.find { it.id == id }
+        return runs[id]
     }
     
     actual fun deleteById(id: String): Boolean {
-        val index = runs.indexOfFirst { it.id == id }
-        if (index >= 0) {
-            runs.removeAt(index)
+        if (runs[id] != null) {
+            logFile?.append(listOf(log.delete(id)))
+            runs.remove(id)
+            indexes.remove(id)
             return true
         }
         return false
     }
     
     actual fun clear() {
+        logFile?.append(listOf(log.clear()))
         runs.clear()
+        indexes.clear()
+    }
+    
+    actual fun exportJson(): String {
+        return json.encodeToString(runs.toList())
+    }
+    
+    actual fun importJson(jsonString: String): Int {
+        return upsertAll(json.decodeFromString<List<RunDTO>>(jsonString))
     }
     
     actual fun size(): Int {
         return runs.size
     }
+    
+    actual fun getLogRecovery(): RunLogRecovery {
+        return logFile?.recovery ?: RunLogRecovery()
+    }
 }
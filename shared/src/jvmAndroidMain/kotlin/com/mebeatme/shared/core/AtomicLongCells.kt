@@ -0,0 +1,14 @@
+package com.mebeatme.shared.core
+
+import java.util.concurrent.atomic.AtomicLongArray
+
+internal actual class AtomicLongCells actual constructor(size: Int) {
+    private val cells = AtomicLongArray(size)
+
+    actual val size: Int get() = cells.length()
+
+    actual operator fun get(index: Int): Long = cells.get(index)
+
+    actual fun compareAndSet(index: Int, expected: Long, newValue: Long): Boolean =
+        cells.compareAndSet(index, expected, newValue)
+}
@@ -0,0 +1,55 @@
+package com.mebeatme.shared.persistence
+
+import java.io.File
+import java.io.IOException
+import java.nio.ByteBuffer
+import java.nio.channels.FileChannel
+import java.nio.file.Files
+import java.nio.file.StandardCopyOption
+import java.nio.file.StandardOpenOption
+
+/**
+ * Crash-safe file replacement for the run store's files on the JVM and Android.
+ *
+ * A file is written to a temp file in the same directory and fsynced, renamed over
+ * the target, and then the directory is fsynced so the rename survives a power cut.
+ * After a crash the target holds either the old or the new contents, never a mix.
+ */
+internal object AtomicFiles {
+
+    /** Suffix of temp files; a leftover one is from an interrupted write and can be deleted. */
+    const val TEMP_SUFFIX = ".tmp"
+
+    fun write(target: File, bytes: ByteArray) = write(target, ByteBuffer.wrap(bytes))
+
+    fun write(target: File, contents: ByteBuffer) {
+        target.absoluteFile.parentFile?.mkdirs()
+        val tempFile = File(target.absolutePath + TEMP_SUFFIX)
+        FileChannel.open(tempFile.toPath(), StandardOpenOption.CREATE, StandardOpenOption.WRITE, StandardOpenOption.TRUNCATE_EXISTING).use { channel ->
+            while (contents.hasRemaining()) channel.write(contents)
+            channel.force(true)
+        }
+        move(tempFile, target)
+    }
+
+    /**
+     * Rename [source] to [target], replacing it, and make the rename durable.
+     */
+    fun move(source: File, target: File) {
+        Files.move(source.toPath(), target.toPath(), StandardCopyOption.REPLACE_EXISTING, StandardCopyOption.ATOMIC_MOVE)
+        syncDirectory(target.absoluteFile.parentFile)
+    }
+
+    /**
+     * Flush a directory's entries, so files created or renamed in it survive a crash.
+     * Some platforms (Windows) cannot open a directory; there the rename is already durable.
+     */
+    fun syncDirectory(directory: File?) {
+        if (directory == null) return
+        try {
+            FileChannel.open(directory.toPath(), StandardOpenOption.READ).use { it.force(true) }
+        } catch (e: IOException) {
+            // Directory handles unsupported on this platform
+        }
+    }
+}
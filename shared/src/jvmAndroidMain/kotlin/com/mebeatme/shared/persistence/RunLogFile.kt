@@ -0,0 +1,80 @@
+package com.mebeatme.shared.persistence
+
+import java.io.File
+import java.nio.ByteBuffer
+import java.nio.channels.FileChannel
+import java.nio.file.StandardOpenOption
+
+actual class RunLogFile actual constructor(private val path: String) {
+    
+    private var channel: FileChannel? = null
+    
+    private var lastRecovery = RunLogRecovery()
+    
+    actual val recovery: RunLogRecovery get() = lastRecovery
+    
+    actual fun open(): List<RunLogRecord> {
+        lastRecovery = RunLogRecovery()
+        val file = File(path)
+        val bytes = if (file.exists()) file.readBytes() else ByteArray(0)
+        if (bytes.isEmpty()) {
+            // New log: the header goes through the atomic path so the file's directory entry is durable too
+            AtomicFiles.write(file, RunLogCodec.MAGIC)
+            channel = openChannel(file).also { it.position(it.size()) }
+            return emptyList()
+        }
+        val decoded = RunLogCodec.decode(bytes)
+        if (decoded.damagedRecords > 0) {
+            // Dropped records may be deletes; keep the log as found before the rewrite loses them for good
+            val aside = File(corruptCopyPath(path) { File(it).exists() })
+            AtomicFiles.write(aside, bytes)
+            lastRecovery = RunLogRecovery(decoded.damagedRecords, decoded.damagedBytes.toLong(), keptAside = listOf(aside.path))
+        } else if (!decoded.needsRewrite && decoded.validLength < bytes.size) {
+            lastRecovery = RunLogRecovery(tornBytes = (bytes.size - decoded.validLength).toLong())
+        }
+        if (decoded.needsRewrite) {
+            AtomicFiles.write(file, RunLogCodec.MAGIC + RunLogCodec.encodeAll(decoded.records))
+        }
+        val opened = openChannel(file)
+        try {
+            val length = if (decoded.needsRewrite) opened.size() else decoded.validLength.toLong()
+            if (opened.size() > length) {
+                opened.truncate(length)
+                opened.force(true)
+            }
+            opened.position(length)
+            channel = opened
+            return decoded.records
+        } catch (e: Exception) {
+            opened.close()
+            throw e
+        }
+    }
+    
+    actual fun append(records: List<RunLogRecord>) {
+        if (records.isEmpty()) return
+        val target = channel ?: throw IllegalStateException("Run log $path is not open")
+        writeFully(target, RunLogCodec.encodeAll(records))
+        target.force(false)
+    }
+    
+    actual fun reset() {
+        close()
+        val file = File(path)
+        AtomicFiles.write(file, RunLogCodec.MAGIC)
+        channel = openChannel(file).also { it.position(it.size()) }
+    }
+    
+    actual fun close() {
+        channel?.close()
+        channel = null
+    }
+    
+    private fun openChannel(file: File): FileChannel =
+        FileChannel.open(file.toPath(), StandardOpenOption.READ, StandardOpenOption.WRITE)
+    
+    private fun writeFully(target: FileChannel, bytes: ByteArray) {
+        val buffer = ByteBuffer.wrap(bytes)
+        while (buffer.hasRemaining()) target.write(buffer)
+    }
+}
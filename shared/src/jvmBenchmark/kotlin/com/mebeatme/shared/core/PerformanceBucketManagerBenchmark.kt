@@ -0,0 +1,78 @@
+package com.mebeatme.shared.core
+
+import com.mebeatme.shared.model.DistanceBucket
+import kotlinx.benchmark.Benchmark
+import kotlinx.benchmark.BenchmarkMode
+import kotlinx.benchmark.Measurement
+import kotlinx.benchmark.Mode
+import kotlinx.benchmark.OutputTimeUnit
+import kotlinx.benchmark.Scope
+import kotlinx.benchmark.Setup
+import kotlinx.benchmark.State
+import kotlinx.benchmark.Warmup
+import org.openjdk.jmh.annotations.Threads
+import java.util.concurrent.TimeUnit
+import kotlin.random.Random
+
+/**
+ * Eight threads offering bests at once: the compare-and-set cells of [PerformanceBucketManager]
+ * against the map behind one lock that it replaced.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+@Warmup(iterations = 3, time = 1, timeUnit = TimeUnit.SECONDS)
+@Measurement(iterations = 5, time = 1, timeUnit = TimeUnit.SECONDS)
+@Threads(8)
+class PerformanceBucketManagerBenchmark {
+
+    private val buckets = DistanceBucket.values()
+    private lateinit var manager: PerformanceBucketManager
+    private lateinit var locked: MutableMap<DistanceBucket, Double>
+
+    // Each thread replays its own offers, so threads contend only on the buckets
+    @State(Scope.Thread)
+    class Offers {
+        val bucketIndexes = IntArray(4096)
+        val ppis = DoubleArray(4096)
+        var next = 0
+
+        @Setup
+        fun setUp() {
+            val random = Random(Thread.currentThread().id)
+            for (i in ppis.indices) {
+                bucketIndexes[i] = random.nextInt(DistanceBucket.values().size)
+                ppis[i] = random.nextDouble(100.0, 1200.0)
+            }
+        }
+
+        fun advance(): Int = next.also { next = (next + 1) and (ppis.size - 1) }
+    }
+
+    @Setup
+    fun setUp() {
+        manager = PerformanceBucketManager()
+        locked = mutableMapOf()
+    }
+
+    @Benchmark
+    fun compareAndSet(offers: Offers): Boolean {
+        val i = offers.advance()
+        return manager.offerBest(buckets[offers.bucketIndexes[i]], offers.ppis[i])
+    }
+
+    @Benchmark
+    fun synchronizedMap(offers: Offers): Boolean {
+        val i = offers.advance()
+        val bucket = buckets[offers.bucketIndexes[i]]
+        val ppi = offers.ppis[i]
+        return synchronized(locked) {
+            if (ppi > (locked[bucket] ?: 0.0)) {
+                locked[bucket] = ppi
+                true
+            } else {
+                false
+            }
+        }
+    }
+}
@@ -0,0 +1,81 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+import kotlinx.benchmark.Benchmark
+import kotlinx.benchmark.BenchmarkMode
+import kotlinx.benchmark.Measurement
+import kotlinx.benchmark.Mode
+import kotlinx.benchmark.OutputTimeUnit
+import kotlinx.benchmark.Scope
+import kotlinx.benchmark.State
+import kotlinx.benchmark.Warmup
+import org.openjdk.jmh.annotations.Level
+import org.openjdk.jmh.annotations.Setup
+import org.openjdk.jmh.annotations.TearDown
+import org.openjdk.jmh.annotations.Threads
+import java.io.File
+import java.nio.file.Files
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicBoolean
+import java.util.concurrent.atomic.AtomicInteger
+import kotlin.concurrent.thread
+
+/**
+ * Read latency percentiles (JMH sample mode reports p50 to p99.99 and max) for four
+ * reader threads while one writer upserts single runs into a 10k-run store nonstop.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.SampleTime)
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+@Warmup(iterations = 2, time = 1, timeUnit = TimeUnit.SECONDS)
+@Measurement(iterations = 5, time = 2, timeUnit = TimeUnit.SECONDS)
+@Threads(4)
+class JsonRunStoreReadLatencyBenchmark {
+
+    private lateinit var tempDir: File
+    private lateinit var store: JsonRunStore
+    private val writing = AtomicBoolean(false)
+    private lateinit var writer: Thread
+    private val lookup = AtomicInteger()
+
+    @Setup(Level.Trial)
+    fun startWriter() {
+        tempDir = Files.createTempDirectory("mebeatme_bench").toFile()
+        store = JsonRunStore(File(tempDir, "runs.json")).apply { compactionPolicy = CompactionPolicy.MANUAL }
+        store.upsertAll((1..10_000).map { createRunDTO("run$it", 1200 + it % 600) })
+        writing.set(true)
+        writer = thread(name = "bench-writer") {
+            var i = 0
+            while (writing.get()) store.upsertAll(listOf(createRunDTO("run${i++ % 20_000 + 1}", 1300)))
+        }
+    }
+
+    @TearDown(Level.Trial)
+    fun stopWriter() {
+        writing.set(false)
+        writer.join()
+        store.close()
+        tempDir.deleteRecursively()
+    }
+
+    @Benchmark
+    fun getAll(): Int = store.getAll().size
+
+    @Benchmark
+    fun getById(): RunDTO? = store.getById("run${lookup.getAndIncrement() and 0x1FFF}")
+
+    @Benchmark
+    fun size(): Int = store.size()
+
+    private fun createRunDTO(id: String, seconds: Int): RunDTO {
+        return RunDTO(
+            id = id,
+            source = "bench",
+            startedAtEpochMs = 0L,
+            endedAtEpochMs = seconds * 1000L,
+            distanceMeters = 5000.0,
+            elapsedSeconds = seconds,
+            avgPaceSecPerKm = seconds / 5.0
+        )
+    }
+}
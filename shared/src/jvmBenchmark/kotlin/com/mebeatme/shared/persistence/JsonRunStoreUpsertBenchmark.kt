@@ -0,0 +1,70 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+import kotlinx.benchmark.Benchmark
+import kotlinx.benchmark.BenchmarkMode
+import kotlinx.benchmark.Measurement
+import kotlinx.benchmark.Mode
+import kotlinx.benchmark.OutputTimeUnit
+import kotlinx.benchmark.Scope
+import kotlinx.benchmark.State
+import kotlinx.benchmark.Warmup
+import org.openjdk.jmh.annotations.Level
+import org.openjdk.jmh.annotations.Setup
+import org.openjdk.jmh.annotations.TearDown
+import java.io.File
+import java.nio.file.Files
+import java.util.concurrent.TimeUnit
+
+/**
+ * A 100k-run backfill into a 100k-run store, half overwrites and half new runs, then
+ * getById against the 150k-run result. Every iteration starts from a fresh store.
+ */
+@State(Scope.Benchmark)
+@Warmup(iterations = 1)
+@Measurement(iterations = 5)
+class JsonRunStoreUpsertBenchmark {
+
+    private lateinit var tempDir: File
+    private lateinit var store: JsonRunStore
+    private val backfill = (50_000 until 150_000).map { createRunDTO("run$it", it + 1) }
+    private var lookup = 0
+
+    @Setup(Level.Iteration)
+    fun openStore() {
+        tempDir = Files.createTempDirectory("mebeatme_bench").toFile()
+        store = JsonRunStore(File(tempDir, "runs.json")).apply { compactionPolicy = CompactionPolicy.MANUAL }
+        store.upsertAll((0 until 100_000).map { createRunDTO("run$it", it) })
+    }
+
+    @TearDown(Level.Iteration)
+    fun closeStore() {
+        store.close()
+        tempDir.deleteRecursively()
+    }
+
+    @Benchmark
+    @BenchmarkMode(Mode.SingleShotTime)
+    @OutputTimeUnit(TimeUnit.MILLISECONDS)
+    fun upsertBackfill() = store.upsertAll(backfill)
+
+    @Benchmark
+    @BenchmarkMode(Mode.AverageTime)
+    @OutputTimeUnit(TimeUnit.NANOSECONDS)
+    fun getById(): RunDTO? {
+        lookup = (lookup + 7) % 100_000
+        return store.getById("run$lookup")
+    }
+
+    private fun createRunDTO(id: String, n: Int): RunDTO {
+        return RunDTO(
+            id = id,
+            source = "bench",
+            startedAtEpochMs = n * 60_000L,
+            endedAtEpochMs = n * 60_000L + 1_800_000L,
+            distanceMeters = 5000.0,
+            elapsedSeconds = 1200 + n,
+            avgPaceSecPerKm = 240.0
+        )
+    }
+}
@@ -0,0 +1,46 @@
+package com.mebeatme.shared.core
+
+import com.mebeatme.shared.service.MeBeatMeService
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/*
+ * Writers of structs from shared/include/mebeatme_flat.h into a ByteBuffer, for JNI
+ * callers that allocate one direct buffer in native order and read the structs in place
+ * through GetDirectBufferAddress. JsonRunStore.writeBests fills an MBMBests the same way.
+ */
+
+/**
+ * [MeBeatMeService.getRealTimeFeedback] written as an MBMFeedback at [at]; allocates nothing.
+ * @param out Buffer in native byte order with [FlatFeedback.SIZE] bytes from [at]
+ * @return false, leaving [out] untouched, if no run is in progress
+ */
+fun MeBeatMeService.writeRealTimeFeedback(
+    out: ByteBuffer,
+    at: Int = 0,
+    precision: ScoringPrecision = ScoringPrecision.FIXED_Q16
+): Boolean {
+    requireNativeOrder(out)
+    return FlatFeedback.write(this, precision, { field, value -> out.putInt(at + field, value) }, { field, value -> out.putDouble(at + field, value) })
+}
+
+/**
+ * [MeBeatMeService.completeSession] with the score written as an MBMScore at [at].
+ * @param out Buffer in native byte order with [FlatScore.SIZE] bytes from [at]
+ * @return false, leaving [out] untouched, if there was no session to complete
+ */
+fun MeBeatMeService.completeSessionFlat(out: ByteBuffer, at: Int = 0): Boolean {
+    requireNativeOrder(out)
+    val score = completeSession() ?: return false
+    FlatScore.write(
+        score,
+        putInt = { field, value -> out.putInt(at + field, value) },
+        putLong = { field, value -> out.putLong(at + field, value) },
+        putDouble = { field, value -> out.putDouble(at + field, value) }
+    )
+    return true
+}
+
+private fun requireNativeOrder(out: ByteBuffer) {
+    require(out.order() == ByteOrder.nativeOrder()) { "Flat records need a buffer in native byte order" }
+}
@@ -1,132 +1,776 @@
 package com.mebeatme.shared.persistence
 
+import com.mebeatme.shared.model.BestsDTO
 import com.mebeatme.shared.model.RunDTO
-import com.mebeatme.shared.core.highestPpiInWindow
+import kotlinx.datetime.TimeZone
 import kotlinx.serialization.encodeToString
 import kotlinx.serialization.json.Json
 import kotlinx.serialization.decodeFromString
 import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.util.BitSet
+import java.util.concurrent.CompletableFuture
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.ExecutionException
+import java.util.concurrent.ExecutorService
+import java.util.concurrent.Executors
+import java.util.concurrent.LinkedBlockingQueue
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicBoolean
+import java.util.concurrent.atomic.AtomicReference
+import java.util.concurrent.locks.ReentrantLock
 import java.util.concurrent.locks.ReentrantReadWriteLock
 import kotlin.concurrent.read
+import kotlin.concurrent.thread
+import kotlin.concurrent.withLock
 import kotlin.concurrent.write
 
 /**
- * JVM implementation of JSON-based persistence layer for MeBeatMe
+ * JVM implementation of the persistence layer for MeBeatMe
+ *
+ * Runs are stored in an append-only binary log next to [dataFile] (runs.json → runs.json.log):
+ * each upsert, delete or clear appends its records and fsyncs, so a write costs
+ * O(runs written) instead of rewriting the history. Opening the store replays the log.
+ * An existing runs.json without a log is imported once and left in place as a backup;
+ * JSON is otherwise only an import/export format.
+ *
+ * To keep the log from growing without bound, it is compacted in the background as
+ * [compactionPolicy] directs: under the writer lock the active log is sealed as
+ * runs.json.log.<n> and a new one started, and the current [RunSnapshot] is taken; then,
+ * while writes carry on into the new log, it is written as a [RunArchive]
+ * snapshot (runs.json.archive, replaced atomically) and the sealed segments are
+ * deleted. Opening maps the snapshot and replays any sealed segments and the
+ * active log on top, so a crash at any point loses nothing.
+ *
+ * Only runs written since the last compaction are resident. The snapshot stays mapped
+ * and its rows are decoded on demand: [getAll] and [listSince] read them through the
+ * published [RunStoreView], [getById] looks them up by id, and opening streams each row
+ * through the indexes once without keeping it. [getAll] lists snapshot runs by start
+ * time, then later ones in write order.
+ *
+ * Writes go through group commit: [upsertAllAsync], [replaceIfUnchangedAsync],
+ * [deleteByIdAsync] and [clearAsync] queue a mutation and a single commit thread appends whatever has queued, up to
+ * [groupCommitPolicy], with one write and one fsync, then applies the batch and
+ * completes each caller's future. The blocking [upsertAll], [deleteById] and [clear]
+ * wait on that future, so concurrent callers (watch sync, an import, manual entries)
+ * share fsyncs instead of paying one each; [getGroupCommitMetrics] reports how well.
+ *
+ * Run reads ([getAll], [listSince], [getById], [size], exports) never block: every
+ * commit publishes an immutable [RunStoreView] that readers pick up with one atomic
+ * load, and [getAll] hands that view out as is. Index queries (bests, PPI windows,
+ * rollups, sketches) take a read lock that the commit thread holds only while updating
+ * the in-memory indexes, never across file I/O.
  */
-actual class JsonRunStore actual constructor(private val dataFile: Any) {
+actual class JsonRunStore actual constructor(private val dataFile: Any, timeZone: TimeZone) {
+    
+    actual constructor(dataFile: Any) : this(dataFile, TimeZone.currentSystemDefault())
     
     private val file = dataFile as File
+    private val logPath = file.path + ".log"
+    private val logFile = RunLogFile(logPath)
+    private val archiveFile = File(file.path + ".archive")
+    private val log = RunLog(RunDTO.serializer()) { it.id }
     private val json = Json {
         prettyPrint = true
         ignoreUnknownKeys = true
     }
     
+    /** Batching for the commit thread; read at the start of every batch. */
+    @Volatile
+    var groupCommitPolicy = GroupCommitPolicy()
+    
+    private val pending = LinkedBlockingQueue<Mutation>()
+    // Admission: [closed] flips and Stop is queued under it, so no write can queue behind Stop
+    private val intake = Any()
+    @Volatile
+    private var closed = false
+    private val committer = lazy { thread(isDaemon = true, name = "run-store-committer") { commitLoop() } }
+    
+    private val commitStats = CommitLatencyHistogram()
+    private var commitBatches = 0L
+    private var commitMutations = 0L
+    private var commitRecords = 0L
+    private var commitStartedNanos = System.nanoTime()
+    
+    // Serializes the commit thread and compaction; the archive, runs table and log are only touched under it
+    private val writer = ReentrantLock()
+    private var archive: RunArchive? = null
+    // Archive rows that later writes replaced or deleted
+    private val hiddenRows = BitSet()
+    private var hiddenChanged = false
+    // Runs written since the archive: the log tail
+    private val runs = RunTable<RunDTO> { it.id }
+    private val dirtySegments = HashSet<Int>()
+    
+    // Published run versions for readers; byId holds the tail only
+    private val snapshot = AtomicReference(RunStoreView(null, BitSet(), RunSnapshot.of(runs)))
+    @Volatile
+    private var byId = ConcurrentHashMap<String, RunDTO>()
+    
+    // Guards the indexes only, and only for in-memory updates
     private val lock = ReentrantReadWriteLock()
-    private val runs = mutableListOf<RunDTO>()
+    private val indexes = RunIndexes(timeZone)
+    
+    // Repairs made while opening logs, summed over reloads; compaction's reopen of a fresh log adds nothing
+    @Volatile
+    private var logRecovery = RunLogRecovery()
+    
+    // Active log bookkeeping for the dead-record trigger; guarded by the writer lock
+    private var logRecords = 0
+    private var deadRecords = 0
+    private val idsInLog = HashSet<String>()
+    
+    /** When background compaction starts; [CompactionPolicy.MANUAL] turns it off. */
+    @Volatile
+    var compactionPolicy = CompactionPolicy()
+    
+    private val compacting = AtomicBoolean(false)
+    // Starts its thread on the first scheduled compaction
+    private val compactor: ExecutorService =
+        Executors.newSingleThreadExecutor { task -> Thread(task, "run-store-compactor").apply { isDaemon = true } }
+    
+    @Volatile
+    private var compactionTotals = CompactionMetrics()
     
     init {
-        loadFromFile()
+        // Left behind by a write interrupted before its rename; the target still holds the previous version
+        listOf(archiveFile.path, logPath).forEach { File(it + AtomicFiles.TEMP_SUFFIX).delete() }
+        openLog()
     }
     
     actual fun upsertAll(newRuns: List<RunDTO>): Int {
-        return lock.write {
-            var stored = 0
-            newRuns.forEach { newRun ->
-                val existingIndex = runs.indexOfFirst { it.id == newRun.id }
-                if (existingIndex >= 0) {
-                    runs[existingIndex] = newRun
-                } else {
-                    runs.add(newRun)
-                }
-                stored++
-            }
-            saveToFile()
-            stored
-        }
+        return await(upsertAllAsync(newRuns))
+    }
+    
+    /**
+     * Queue an upsert for the next group commit.
+     * @return Completes with the number of runs stored once they are on disk and visible to readers
+     */
+    fun upsertAllAsync(newRuns: List<RunDTO>): CompletableFuture<Int> {
+        return enqueue(Mutation.Upsert(newRuns))
+    }
+    
+    actual fun replaceIfUnchanged(updates: List<Pair<RunDTO, RunDTO>>): Int {
+        return await(replaceIfUnchangedAsync(updates))
+    }
+    
+    /**
+     * Queue a conditional replace for the next group commit; the comparison is made by the
+     * commit thread, after every write queued before it.
+     * @return Completes with the number of runs replaced once they are on disk and visible to readers
+     */
+    fun replaceIfUnchangedAsync(updates: List<Pair<RunDTO, RunDTO>>): CompletableFuture<Int> {
+        return enqueue(Mutation.Replace(updates))
     }
     
     actual fun listSince(sinceMs: Long): List<RunDTO> {
+        return snapshot.get().listSince(sinceMs)
+    }
+    
+    actual fun getAll(): List<RunDTO> {
+        return snapshot.get()
+    }
+    
+    actual fun getHighestPpiLast90Days(nowMs: Long, days: Int): Double? {
         return lock.read {
-            runs.filter { it.startedAtEpochMs >= sinceMs }
+            indexes.ppiWindows.maxPpiInWindow(nowMs, days)
         }
     }
     
-    actual fun getAll(): List<RunDTO> {
+    actual fun getHighestPpiInWindows(nowMs: Long, days: List<Int>): List<Double?> {
         return lock.read {
-            runs.toList()
+            indexes.ppiWindows.maxPpiInWindows(nowMs, days)
         }
     }
     
-    actual fun getHighestPpiLast90Days(nowMs: Long, days: Int): Double? {
+    actual fun getBests(nowMs: Long, sinceMs: Long): BestsDTO {
         return lock.read {
-            highestPpiInWindow(runs, nowMs, days)
+            indexes.bests.toBestsDTO(sinceMs, indexes.ppiWindows.maxPpiInWindow(nowMs, 90))
         }
     }
     
-    actual fun getById(id: String): RunDTO? {
+    /**
+     * [getBests] written as an MBMBests (shared/include/mebeatme_flat.h) at [at] in [out],
+     * without allocating; JNI code reads it in place through GetDirectBufferAddress.
+     * @param out Buffer in native byte order with FlatBests.SIZE bytes from [at]
+     */
+    fun writeBests(nowMs: Long, sinceMs: Long, out: ByteBuffer, at: Int = 0) {
+        require(out.order() == ByteOrder.nativeOrder()) { "Flat records need a buffer in native byte order" }
+        lock.read {
+            indexes.writeFlatBests(nowMs, sinceMs, { field, value -> out.putInt(at + field, value) }, { field, value -> out.putDouble(at + field, value) })
+        }
+    }
+    
+    actual fun getRollups(period: RollupPeriod, fromMs: Long, toMs: Long): List<RollupRow> {
         return lock.read {
-            runs.find { it.id == id }
+            indexes.rollups.rows(period, fromMs, toMs)
         }
     }
     
-    actual fun deleteById(id: String): Boolean {
-        return lock.write {
-            val index = runs.indexOfFirst { it.id == id }
-            if (index >= 0) {
-                runs.removeAt(index)
-                saveToFile()
-                true
-            } else {
-                false
-            }
+    actual fun getSustainedPaceSecPerKm(durationSec: Double): Double? {
+        return lock.read {
+            indexes.paceEnvelope.sustainedPaceSecPerKm(durationSec)
         }
     }
     
+    actual fun getSketches(): RunSketches {
+        return lock.read {
+            indexes.sketches.copy()
+        }
+    }
+    
+    actual fun getById(id: String): RunDTO? {
+        return byId[id] ?: snapshot.get().archived(id)
+    }
+    
+    actual fun deleteById(id: String): Boolean {
+        return await(deleteByIdAsync(id))
+    }
+    
+    /**
+     * Queue a delete for the next group commit.
+     * @return Completes with whether the run existed, once the delete is on disk and visible to readers
+     */
+    fun deleteByIdAsync(id: String): CompletableFuture<Boolean> {
+        return enqueue(Mutation.Delete(id))
+    }
+    
     actual fun clear() {
-        lock.write {
-            runs.clear()
-            saveToFile()
+        await(clearAsync())
+    }
+    
+    fun clearAsync(): CompletableFuture<Unit> {
+        return enqueue(Mutation.Clear())
+    }
+    
+    actual fun exportJson(): String {
+        return json.encodeToString<List<RunDTO>>(snapshot.get())
+    }
+    
+    actual fun importJson(jsonString: String): Int {
+        return upsertAll(json.decodeFromString<List<RunDTO>>(jsonString))
+    }
+    
+    /**
+     * Write the current runs as a memory-mappable columnar [RunArchive]
+     * @param target Archive file, replaced atomically
+     */
+    fun writeArchive(target: File) {
+        RunArchive.write(target, snapshot.get())
+    }
+    
+    /**
+     * Fold the log into a new snapshot now, on the calling thread.
+     * Writes from other threads wait only while the log is sealed, not while the snapshot is written.
+     * @return false if there was nothing to compact or a compaction was already running
+     */
+    fun compact(): Boolean {
+        if (!compacting.compareAndSet(false, true)) return false
+        try {
+            return compactNow()
+        } finally {
+            compacting.set(false)
         }
     }
     
-    actual fun size(): Int {
-        return lock.read {
-            runs.size
+    fun getCompactionMetrics(): CompactionMetrics {
+        return writer.withLock {
+            compactionTotals.copy(
+                snapshotBytes = archiveFile.length(),
+                logBytes = File(logPath).length() + sealedSegments().sumOf { it.length() },
+                deadRecordRatio = if (logRecords == 0) 0.0 else deadRecords.toDouble() / logRecords
+            )
+        }
+    }
+    
+    fun getGroupCommitMetrics(): GroupCommitMetrics {
+        return synchronized(commitStats) {
+            GroupCommitMetrics(
+                batches = commitBatches,
+                mutations = commitMutations,
+                records = commitRecords,
+                fsyncs = commitBatches,
+                elapsedMs = (System.nanoTime() - commitStartedNanos) / 1_000_000,
+                commitLatency = commitStats.copy()
+            )
         }
     }
     
+    /** Start a new measurement window for [getGroupCommitMetrics]. */
+    fun resetGroupCommitMetrics() {
+        synchronized(commitStats) {
+            commitStats.clear()
+            commitBatches = 0L
+            commitMutations = 0L
+            commitRecords = 0L
+            commitStartedNanos = System.nanoTime()
+        }
+    }
+    
+    /**
+     * Commit queued writes, wait for a running compaction and release the log file handle;
+     * the store must not be used afterwards
+     */
+    fun close() {
+        val started = synchronized(intake) {
+            closed = true
+            committer.isInitialized().also { if (it) pending.put(Mutation.Stop) }
+        }
+        if (started) committer.value.join()
+        compactor.shutdown()
+        compactor.awaitTermination(1, TimeUnit.MINUTES)
+        writer.withLock {
+            logFile.close()
+            archive?.close()
+        }
+    }
+    
+    actual fun size(): Int {
+        return snapshot.get().size
+    }
+    
+    actual fun getLogRecovery(): RunLogRecovery {
+        return logRecovery
+    }
+    
     // ===== PRIVATE METHODS =====
     
-    private fun loadFromFile() {
-        if (!file.exists()) {
-            return
+    private sealed class Mutation {
+        val queuedAt = System.nanoTime()
+        
+        class Upsert(val runs: List<RunDTO>) : Mutation() {
+            val done = CompletableFuture<Int>()
         }
         
+        class Replace(val updates: List<Pair<RunDTO, RunDTO>>) : Mutation() {
+            val done = CompletableFuture<Int>()
+            var replaced = emptyList<RunDTO>()
+        }
+        
+        class Delete(val id: String) : Mutation() {
+            val done = CompletableFuture<Boolean>()
+            var existed = false
+        }
+        
+        class Clear : Mutation() {
+            val done = CompletableFuture<Unit>()
+        }
+        
+        object Stop : Mutation()
+        
+        val records: Int get() = when (this) {
+            is Upsert -> runs.size
+            is Replace -> updates.size
+            else -> 1
+        }
+    }
+    
+    private fun <T> enqueue(mutation: Mutation): CompletableFuture<T> {
+        synchronized(intake) {
+            check(!closed) { "Run store is closed" }
+            committer.value
+            pending.put(mutation)
+        }
+        @Suppress("UNCHECKED_CAST")
+        return when (mutation) {
+            is Mutation.Upsert -> mutation.done
+            is Mutation.Replace -> mutation.done
+            is Mutation.Delete -> mutation.done
+            is Mutation.Clear -> mutation.done
+            Mutation.Stop -> throw IllegalArgumentException("Stop is not a write")
+        } as CompletableFuture<T>
+    }
+    
+    private fun <T> await(future: CompletableFuture<T>): T {
         try {
-            val jsonString = file.readText()
-            val loadedRuns = json.decodeFromString<List<RunDTO>>(jsonString)
-            runs.clear()
-            runs.addAll(loadedRuns)
-        } catch (e: Exception) {
-            // If file is corrupted, start fresh
-            runs.clear()
+            return future.get()
+        } catch (e: ExecutionException) {
+            throw e.cause ?: e
+        }
+    }
+    
+    private fun commitLoop() {
+        try {
+            while (true) {
+                val first = next(null) ?: continue
+                if (first === Mutation.Stop) return
+                val policy = groupCommitPolicy
+                val batch = mutableListOf(first)
+                var records = first.records
+                val deadline = System.nanoTime() + TimeUnit.MILLISECONDS.toNanos(policy.maxDelayMillis)
+                var stop = false
+                while (records < policy.maxBatchRecords) {
+                    val next = next(deadline) ?: break
+                    if (next === Mutation.Stop) {
+                        stop = true
+                        break
+                    }
+                    batch.add(next)
+                    records += next.records
+                }
+                // A pending interrupt would close the log's FileChannel mid-append
+                Thread.interrupted()
+                commit(batch)
+                if (stop) return
+            }
+        } finally {
+            // Normally empty; if the thread dies on an unexpected error, writers fail instead of waiting forever
+            synchronized(intake) { closed = true }
+            val left = ArrayList<Mutation>()
+            pending.drainTo(left)
+            fail(left, IllegalStateException("Run store is closed"))
         }
     }
     
-    private fun saveToFile() {
+    // The committer owns its thread: an interrupt must not strand queued writers, so it only ends a wait early
+    private fun next(deadline: Long?): Mutation? {
+        return try {
+            if (deadline == null) {
+                pending.take()
+            } else {
+                val wait = deadline - System.nanoTime()
+                if (wait > 0) pending.poll(wait, TimeUnit.NANOSECONDS) else pending.poll()
+            }
+        } catch (e: InterruptedException) {
+            if (deadline == null) null else pending.poll()
+        }
+    }
+    
+    // One append and fsync for the whole batch, then one apply and publish
+    private fun commit(batch: List<Mutation>) {
         try {
-            // Create parent directories if they don't exist
-            file.parentFile?.mkdirs()
-            
-            // Write to temporary file first (atomic write)
-            val tempFile = File(file.absolutePath + ".tmp")
-            val jsonString = json.encodeToString(runs)
-            tempFile.writeText(jsonString)
-            
-            // Move temp file to final location
-            tempFile.renameTo(file)
-        } catch (e: Exception) {
-            throw RuntimeException("Failed to save runs to file", e)
+            writer.withLock {
+                // Deletes and replaces see the batch's earlier mutations, which are not applied yet; null is deleted
+                val overlay = HashMap<String, RunDTO?>()
+                var cleared = false
+                val current = { id: String -> if (id in overlay) overlay[id] else if (cleared) null else stored(id) }
+                val records = ArrayList<RunLogRecord>()
+                batch.forEach { mutation ->
+                    when (mutation) {
+                        is Mutation.Upsert -> mutation.runs.forEach {
+                            records.add(log.upsert(it))
+                            overlay[it.id] = it
+                        }
+                        is Mutation.Replace -> {
+                            mutation.replaced = mutation.updates
+                                .filter { (read, replacement) -> read.id == replacement.id && current(read.id) == read }
+                                .map { it.second }
+                            mutation.replaced.forEach {
+                                records.add(log.upsert(it))
+                                overlay[it.id] = it
+                            }
+                        }
+                        is Mutation.Delete -> {
+                            mutation.existed = current(mutation.id) != null
+                            if (mutation.existed) {
+                                records.add(log.delete(mutation.id))
+                                overlay[mutation.id] = null
+                            }
+                        }
+                        is Mutation.Clear -> {
+                            records.add(log.clear())
+                            overlay.clear()
+                            cleared = true
+                        }
+                        Mutation.Stop -> Unit
+                    }
+                }
+                logFile.append(records)
+                // The batch is durable from here on: if memory cannot follow, rebuild it from disk rather than fail writes that happened
+                try {
+                    lock.write { batch.forEach { apply(it) } }
+                    publish()
+                } catch (e: Exception) {
+                    reloadFromDisk()
+                }
+                maybeScheduleCompaction()
+                synchronized(commitStats) {
+                    commitBatches++
+                    commitMutations += batch.size
+                    commitRecords += records.size
+                }
+            }
+        } catch (e: Throwable) {
+            fail(batch, e)
+            return
+        }
+        val now = System.nanoTime()
+        synchronized(commitStats) { batch.forEach { commitStats.record(now - it.queuedAt) } }
+        batch.forEach { mutation ->
+            when (mutation) {
+                is Mutation.Upsert -> mutation.done.complete(mutation.runs.size)
+                is Mutation.Replace -> mutation.done.complete(mutation.replaced.size)
+                is Mutation.Delete -> mutation.done.complete(mutation.existed)
+                is Mutation.Clear -> mutation.done.complete(Unit)
+                Mutation.Stop -> Unit
+            }
+        }
+    }
+    
+    private fun fail(mutations: List<Mutation>, error: Throwable) {
+        mutations.forEach { mutation ->
+            when (mutation) {
+                is Mutation.Upsert -> mutation.done.completeExceptionally(error)
+                is Mutation.Replace -> mutation.done.completeExceptionally(error)
+                is Mutation.Delete -> mutation.done.completeExceptionally(error)
+                is Mutation.Clear -> mutation.done.completeExceptionally(error)
+                Mutation.Stop -> Unit
+            }
+        }
+    }
+    
+    // Called under the writer lock: runs, indexes and log bookkeeping are rebuilt from the snapshot and logs
+    private fun reloadFromDisk() {
+        lock.write {
+            dropArchive()
+            runs.clear()
+            byId.clear()
+            indexes.clear()
+            dirtySegments.clear()
+            logRecords = 0
+            deadRecords = 0
+            idsInLog.clear()
+            logFile.close()
+            openLog()
+        }
+    }
+    
+    // Called under the writer lock and the index write lock, after the mutation is on disk
+    private fun apply(mutation: Mutation) {
+        when (mutation) {
+            is Mutation.Upsert -> mutation.runs.forEach { applyUpsert(it) }
+            is Mutation.Replace -> mutation.replaced.forEach { applyUpsert(it) }
+            is Mutation.Delete -> if (mutation.existed) {
+                trackDelete(mutation.id)
+                markDirty(mutation.id)
+                runs.remove(mutation.id)
+                hideArchived(mutation.id)
+                byId.remove(mutation.id)
+                indexes.remove(mutation.id)
+            }
+            is Mutation.Clear -> {
+                trackClear()
+                runs.clear()
+                dropArchive()
+                byId.clear()
+                indexes.clear()
+            }
+            Mutation.Stop -> Unit
+        }
+    }
+    
+    private fun applyUpsert(newRun: RunDTO) {
+        trackUpsert(newRun.id)
+        runs.upsert(newRun)
+        hideArchived(newRun.id)
+        markDirty(newRun.id)
+        byId[newRun.id] = newRun
+        indexes.upsert(newRun)
+    }
+    
+    private fun openLog() {
+        val migrate = !File(logPath).exists() && !archiveFile.exists() && file.exists()
+        if (archiveFile.exists()) {
+            val opened = RunArchive.open(archiveFile)
+            // The log records it covers are gone, so a damaged snapshot cannot be repaired here
+            if (!opened.verify()) {
+                opened.close()
+                throw IllegalStateException("Run archive ${archiveFile.path} failed its checksum")
+            }
+            archive = opened
+        }
+        // Segments sealed by a compaction that did not finish come before the active log
+        sealedSegments().forEach { segment ->
+            val segmentLog = RunLogFile(segment.path)
+            val records = segmentLog.open()
+            segmentLog.close()
+            logRecovery += segmentLog.recovery
+            replay(records)
+        }
+        var records = logFile.open()
+        logRecovery += logFile.recovery
+        if (migrate) {
+            val legacy = try {
+                json.decodeFromString<List<RunDTO>>(file.readText())
+            } catch (e: Exception) {
+                // Corrupted legacy file: keep it aside for manual recovery rather than treat it as a good backup
+                AtomicFiles.move(file, File(file.path + ".corrupt"))
+                emptyList()
+            }
+            records = legacy.map { log.upsert(it) }
+            logFile.append(records)
+        }
+        replay(records, track = true)
+        // Archive rows go through the indexes one at a time and are not kept
+        indexes.clear()
+        archive?.let { opened ->
+            for (row in 0 until opened.size) if (!hiddenRows[row]) indexes.upsert(opened.read(row))
+        }
+        runs.toList().forEach {
+            indexes.upsert(it)
+            byId[it.id] = it
+        }
+        hiddenChanged = false
+        snapshot.set(RunStoreView(archive, hiddenRows.clone() as BitSet, RunSnapshot.of(runs)))
+    }
+    
+    private fun replay(records: List<RunLogRecord>, track: Boolean = false) {
+        log.replay(
+            records,
+            upsert = { run ->
+                if (track) trackUpsert(run.id)
+                runs.upsert(run)
+                hideArchived(run.id)
+            },
+            delete = { id ->
+                if (track) trackDelete(id)
+                runs.remove(id)
+                hideArchived(id)
+            },
+            clear = {
+                if (track) trackClear()
+                runs.clear()
+                dropArchive()
+            }
+        )
+    }
+    
+    private fun trackUpsert(id: String) {
+        logRecords++
+        if (!idsInLog.add(id)) deadRecords++
+    }
+    
+    // The delete record itself is dead too: it only matters until the next snapshot
+    private fun trackDelete(id: String) {
+        logRecords++
+        deadRecords += if (idsInLog.remove(id)) 2 else 1
+    }
+    
+    private fun trackClear() {
+        logRecords++
+        deadRecords = logRecords
+        idsInLog.clear()
+    }
+    
+    private fun markDirty(id: String) {
+        val slot = runs.slotOf(id)
+        if (slot >= 0) dirtySegments.add(slot / RunSnapshot.SEGMENT_SIZE)
+    }
+    
+    // The committed run for [id], from the tail or the archive; called under the writer lock
+    private fun stored(id: String): RunDTO? {
+        runs[id]?.let { return it }
+        val row = archive?.rowOf(id) ?: -1
+        return if (row >= 0 && !hiddenRows[row]) archive!!.read(row) else null
+    }
+    
+    // A tail write now answers for this id, so its archive row, if any, drops out of reads
+    private fun hideArchived(id: String) {
+        val row = archive?.rowOf(id) ?: -1
+        if (row >= 0 && !hiddenRows[row]) {
+            hiddenRows.set(row)
+            hiddenChanged = true
         }
     }
+    
+    private fun dropArchive() {
+        archive?.close()
+        archive = null
+        hiddenRows.clear()
+        hiddenChanged = true
+    }
+    
+    // Readers see a write once this returns; the hidden rows are copied only when a write changed them
+    private fun publish() {
+        val current = snapshot.get()
+        val hidden = if (hiddenChanged) hiddenRows.clone() as BitSet else current.hidden
+        snapshot.set(RunStoreView(archive, hidden, current.tail.next(runs, dirtySegments)))
+        hiddenChanged = false
+        dirtySegments.clear()
+    }
+    
+    // Called under the writer lock once the new archive holds everything sealed: it replaces the old one,
+    // and the tail shrinks to what the active log has had since the seal
+    private fun swapArchive(next: RunArchive) {
+        archive?.close()
+        archive = next
+        hiddenRows.clear()
+        runs.clear()
+        dirtySegments.clear()
+        replay(RunLogCodec.decode(File(logPath).readBytes()).records)
+        val tail = ConcurrentHashMap<String, RunDTO>()
+        runs.toList().forEach { tail[it.id] = it }
+        hiddenChanged = false
+        // The old byId answers correctly for the new view too, so it is replaced only after the view
+        snapshot.set(RunStoreView(archive, hiddenRows.clone() as BitSet, RunSnapshot.of(runs)))
+        byId = tail
+    }
+    
+    // Called under the writer lock; the flag keeps at most one compaction queued or running
+    private fun maybeScheduleCompaction() {
+        if (compacting.get() || !compactionPolicy.shouldCompact(File(logPath).length(), logRecords, deadRecords)) return
+        if (compacting.compareAndSet(false, true)) {
+            compactor.execute {
+                try {
+                    compactNow()
+                } finally {
+                    compacting.set(false)
+                }
+            }
+        }
+    }
+    
+    // Seal the active log and take the published runs under the writer lock, then write the snapshot without it
+    private fun compactNow(): Boolean {
+        val started = System.nanoTime()
+        val previousSnapshotBytes = archiveFile.length()
+        val (current, segments) = writer.withLock {
+            val sealed = sealedSegments()
+            if (logRecords == 0 && sealed.isEmpty()) return false
+            if (logRecords > 0) {
+                logFile.close()
+                val target = File("$logPath.${(sealed.maxOfOrNull { segmentNumber(it) } ?: 0L) + 1}")
+                try {
+                    AtomicFiles.move(File(logPath), target)
+                } finally {
+                    logFile.open()
+                }
+                logRecords = 0
+                deadRecords = 0
+                idsInLog.clear()
+            }
+            snapshot.get() to sealedSegments()
+        }
+        
+        val compactedBytes = segments.sumOf { it.length() }
+        RunArchive.write(archiveFile, current)
+        // Sorting the ids here keeps it out of the writer lock
+        val next = RunArchive.open(archiveFile).also { it.rowOf("") }
+        writer.withLock { swapArchive(next) }
+        segments.forEach { it.delete() }
+        
+        val durationMs = (System.nanoTime() - started) / 1_000_000
+        val reclaimed = previousSnapshotBytes + compactedBytes - archiveFile.length()
+        compactionTotals = compactionTotals.let {
+            it.copy(
+                compactions = it.compactions + 1,
+                lastDurationMs = durationMs,
+                totalDurationMs = it.totalDurationMs + durationMs,
+                lastBytesReclaimed = reclaimed,
+                totalBytesReclaimed = it.totalBytesReclaimed + reclaimed
+            )
+        }
+        return true
+    }
+    
+    private fun sealedSegments(): List<File> {
+        val prefix = File(logPath).name + "."
+        val directory = file.absoluteFile.parentFile ?: return emptyList()
+        return (directory.listFiles() ?: emptyArray())
+            .filter { it.name.startsWith(prefix) && it.name.removePrefix(prefix).toLongOrNull() != null }
+            .sortedBy { segmentNumber(it) }
+    }
+    
+    private fun segmentNumber(segment: File): Long = segment.name.substringAfterLast('.').toLong()
 }
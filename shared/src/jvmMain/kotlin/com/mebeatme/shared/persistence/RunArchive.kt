@@ -0,0 +1,281 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+import kotlinx.serialization.Serializable
+import kotlinx.serialization.json.Json
+import java.io.Closeable
+import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.MappedByteBuffer
+import java.nio.channels.FileChannel
+import java.nio.file.StandardOpenOption
+import java.util.zip.CRC32C
+
+/**
+ * Read-optimized, memory-mapped columnar snapshot of a run history.
+ *
+ * Rows are sorted by startedAtEpochMs and every field lives in its own column:
+ * fixed-width columns for times, distance, elapsed, pace, PPI and heart rate; a
+ * dictionary for source; string tables for ids and for the rarely set fields
+ * (notes, curve version, best efforts, pace curve) as compact JSON. Opening maps
+ * the file and reads a 16-byte header plus the column directory, so it costs the
+ * same for ten runs or a hundred thousand and touches no row data. A time-range
+ * query binary-searches the start column, then reads the matching rows
+ * sequentially and builds [RunDTO]s for those rows only.
+ *
+ * Layout (little-endian):
+ *
+ *     [8 magic][i32 rows][i32 columns][columns × (i64 offset, i64 length)][sections, 8-byte aligned]
+ *     [footer: i32 CRC-32C of everything before it][i32 0][8 end magic]
+ *
+ * A string table is an i32 count, i32 offsets (count + 1), then the UTF-8 bytes.
+ * [open] checks the end magic, so a cut-short file is refused at no cost; [verify]
+ * checks the checksum with one sequential pass. Files are replaced with [AtomicFiles].
+ * Readers are safe to share between threads; the mapping is released when the archive is collected.
+ */
+class RunArchive private constructor(
+    private val channel: FileChannel,
+    private val buffer: MappedByteBuffer
+) : Closeable {
+
+    init {
+        require(buffer.getInt(12) == Column.values().size) { "Unsupported run archive layout" }
+    }
+
+    /** Number of runs in the archive. */
+    val size: Int = buffer.getInt(8)
+
+    private val sections = LongArray(Column.values().size) { buffer.getLong(HEADER_SIZE + it * 16) }
+    private val sources = StringTable(sections[Column.SOURCE_DICT.ordinal].toInt())
+    private val ids = StringTable(sections[Column.ID.ordinal].toInt())
+    private val extras = StringTable(sections[Column.EXTRAS.ordinal].toInt())
+
+    // Rows in id order, for [rowOf]
+    private val idOrder: IntArray by lazy {
+        val decoded = Array(size) { ids[it] }
+        (0 until size).sortedBy { decoded[it] }.toIntArray()
+    }
+
+    /**
+     * Runs started at or after [sinceMs], oldest first.
+     */
+    fun listSince(sinceMs: Long): List<RunDTO> = listBetween(sinceMs, Long.MAX_VALUE)
+
+    /**
+     * Runs started in [fromMs, toMs], oldest first.
+     */
+    fun listBetween(fromMs: Long, toMs: Long): List<RunDTO> {
+        if (fromMs > toMs) return emptyList()
+        val first = lowerBound(fromMs)
+        val end = if (toMs == Long.MAX_VALUE) size else lowerBound(toMs + 1)
+        return (first until end).map { read(it) }
+    }
+
+    /**
+     * Number of runs started in [fromMs, toMs], from the start column alone.
+     */
+    fun countBetween(fromMs: Long, toMs: Long): Int =
+        if (fromMs > toMs) 0 else (if (toMs == Long.MAX_VALUE) size else lowerBound(toMs + 1)) - lowerBound(fromMs)
+
+    fun startedAt(row: Int): Long = long(Column.STARTED_AT, row)
+
+    /**
+     * First row started at or after [sinceMs]; [size] if there is none.
+     */
+    fun firstRowSince(sinceMs: Long): Int = lowerBound(sinceMs)
+
+    /**
+     * Row of the run with [id], or -1. The first lookup sorts the id column once.
+     */
+    fun rowOf(id: String): Int {
+        val order = idOrder
+        var low = 0
+        var high = size
+        while (low < high) {
+            val mid = (low + high) ushr 1
+            if (ids[order[mid]] < id) low = mid + 1 else high = mid
+        }
+        return if (low < size && ids[order[low]] == id) order[low] else -1
+    }
+
+    /**
+     * Materialize one row.
+     */
+    fun read(row: Int): RunDTO {
+        require(row in 0 until size) { "Row $row out of range" }
+        val ppi = double(Column.PPI, row)
+        val avgHr = int(Column.AVG_HR, row)
+        val extra = extras[row].takeIf { it.isNotEmpty() }?.let { json.decodeFromString(Extras.serializer(), it) } ?: Extras()
+        return RunDTO(
+            id = ids[row],
+            source = sources[int(Column.SOURCE, row)],
+            startedAtEpochMs = startedAt(row),
+            endedAtEpochMs = long(Column.ENDED_AT, row),
+            distanceMeters = double(Column.DISTANCE, row),
+            elapsedSeconds = int(Column.ELAPSED, row),
+            avgPaceSecPerKm = double(Column.PACE, row),
+            avgHr = avgHr.takeIf { it != NO_HR },
+            ppi = ppi.takeUnless { it.isNaN() },
+            notes = extra.notes,
+            ppiCurveVersion = extra.ppiCurveVersion,
+            bestEffortsSec = extra.bestEffortsSec,
+            maxDistanceByDurationM = extra.maxDistanceByDurationM
+        )
+    }
+
+    /**
+     * Check the footer checksum against the contents, reading the whole file once.
+     */
+    fun verify(): Boolean {
+        val footer = buffer.capacity() - FOOTER_SIZE
+        val crc = CRC32C()
+        crc.update(buffer.duplicate().apply { position(0); limit(footer) })
+        return crc.value.toInt() == buffer.getInt(footer)
+    }
+
+    override fun close() {
+        channel.close()
+    }
+
+    // First row whose start is >= startMs
+    private fun lowerBound(startMs: Long): Int {
+        var low = 0
+        var high = size
+        while (low < high) {
+            val mid = (low + high) ushr 1
+            if (startedAt(mid) < startMs) low = mid + 1 else high = mid
+        }
+        return low
+    }
+
+    private fun long(column: Column, row: Int): Long = buffer.getLong(sections[column.ordinal].toInt() + row * 8)
+
+    private fun double(column: Column, row: Int): Double = buffer.getDouble(sections[column.ordinal].toInt() + row * 8)
+
+    private fun int(column: Column, row: Int): Int = buffer.getInt(sections[column.ordinal].toInt() + row * 4)
+
+    private inner class StringTable(private val offset: Int) {
+        private val count = buffer.getInt(offset)
+
+        operator fun get(index: Int): String {
+            val start = buffer.getInt(offset + 4 + index * 4)
+            val end = buffer.getInt(offset + 4 + (index + 1) * 4)
+            val bytes = ByteArray(end - start)
+            buffer.duplicate().apply { position(offset + 4 + (count + 1) * 4 + start) }.get(bytes)
+            return bytes.decodeToString()
+        }
+    }
+
+    private enum class Column {
+        STARTED_AT, ENDED_AT, DISTANCE, ELAPSED, PACE, PPI, AVG_HR, SOURCE, SOURCE_DICT, ID, EXTRAS
+    }
+
+    /** Fields outside the fixed-width columns; defaults are omitted, so most rows store nothing. */
+    @Serializable
+    private data class Extras(
+        val notes: String? = null,
+        val ppiCurveVersion: String? = null,
+        val bestEffortsSec: Map<String, Int> = emptyMap(),
+        val maxDistanceByDurationM: List<Double> = emptyList()
+    )
+
+    companion object {
+        private val MAGIC = byteArrayOf('M'.code.toByte(), 'B'.code.toByte(), 'M'.code.toByte(), 'A'.code.toByte(), 'R'.code.toByte(), 'C'.code.toByte(), 0, 2)
+        private val END_MAGIC = byteArrayOf('M'.code.toByte(), 'B'.code.toByte(), 'M'.code.toByte(), 'A'.code.toByte(), 'E'.code.toByte(), 'N'.code.toByte(), 'D'.code.toByte(), 2)
+        private const val HEADER_SIZE = 16
+        private const val FOOTER_SIZE = 16
+        private const val NO_HR = Int.MIN_VALUE
+        private val json = Json { ignoreUnknownKeys = true }
+
+        /**
+         * Map an archive. Only the header, column directory and footer are read here.
+         * @throws IllegalArgumentException if the file is not a complete run archive
+         */
+        fun open(file: File): RunArchive {
+            val channel = FileChannel.open(file.toPath(), StandardOpenOption.READ)
+            try {
+                require(channel.size() in (HEADER_SIZE + FOOTER_SIZE).toLong()..Int.MAX_VALUE.toLong()) { "Not a run archive: ${file.name}" }
+                val buffer = channel.map(FileChannel.MapMode.READ_ONLY, 0, channel.size())
+                buffer.order(ByteOrder.LITTLE_ENDIAN)
+                val magic = ByteArray(MAGIC.size).also { buffer.get(0, it) }
+                require(magic.contentEquals(MAGIC)) { "Not a run archive: ${file.name}" }
+                val endMagic = ByteArray(END_MAGIC.size).also { buffer.get(buffer.capacity() - END_MAGIC.size, it) }
+                require(endMagic.contentEquals(END_MAGIC)) { "Run archive is incomplete: ${file.name}" }
+                return RunArchive(channel, buffer)
+            } catch (e: Exception) {
+                channel.close()
+                throw e
+            }
+        }
+
+        /**
+         * Write [runs] as an archive, replacing [file] atomically once the new one is on disk.
+         */
+        fun write(file: File, runs: Collection<RunDTO>) {
+            val rows = runs.sortedWith(compareBy<RunDTO> { it.startedAtEpochMs }.thenBy { it.id })
+            val sourceNames = rows.map { it.source }.distinct()
+            val sourceCodes = sourceNames.withIndex().associate { it.value to it.index }
+
+            val sections = listOf(
+                longColumn(rows) { it.startedAtEpochMs },
+                longColumn(rows) { it.endedAtEpochMs },
+                doubleColumn(rows) { it.distanceMeters },
+                intColumn(rows) { it.elapsedSeconds },
+                doubleColumn(rows) { it.avgPaceSecPerKm },
+                doubleColumn(rows) { it.ppi ?: Double.NaN },
+                intColumn(rows) { it.avgHr ?: NO_HR },
+                intColumn(rows) { sourceCodes.getValue(it.source) },
+                stringTable(sourceNames),
+                stringTable(rows.map { it.id }),
+                stringTable(rows.map { run ->
+                    val extra = Extras(run.notes, run.ppiCurveVersion, run.bestEffortsSec, run.maxDistanceByDurationM)
+                    if (extra == Extras()) "" else json.encodeToString(Extras.serializer(), extra)
+                })
+            )
+
+            val directorySize = HEADER_SIZE + sections.size * 16
+            var position = align(directorySize.toLong())
+            val offsets = sections.map { section -> position.also { position = align(position + section.size) } }
+            require(position + FOOTER_SIZE <= Int.MAX_VALUE) { "Run archive larger than 2 GB" }
+
+            val out = ByteBuffer.allocate(position.toInt() + FOOTER_SIZE).order(ByteOrder.LITTLE_ENDIAN)
+            out.put(MAGIC)
+            out.putInt(rows.size)
+            out.putInt(sections.size)
+            sections.indices.forEach { out.putLong(offsets[it]).putLong(sections[it].size.toLong()) }
+            sections.indices.forEach { out.position(offsets[it].toInt()); out.put(sections[it]) }
+
+            val crc = CRC32C()
+            crc.update(out.array(), 0, position.toInt())
+            out.position(position.toInt())
+            out.putInt(crc.value.toInt())
+            out.putInt(0)
+            out.put(END_MAGIC)
+            out.position(0)
+            AtomicFiles.write(file, out)
+        }
+
+        private fun align(position: Long): Long = (position + 7) and 7L.inv()
+
+        private fun longColumn(rows: List<RunDTO>, value: (RunDTO) -> Long): ByteArray =
+            ByteBuffer.allocate(rows.size * 8).order(ByteOrder.LITTLE_ENDIAN).also { out -> rows.forEach { out.putLong(value(it)) } }.array()
+
+        private fun doubleColumn(rows: List<RunDTO>, value: (RunDTO) -> Double): ByteArray =
+            ByteBuffer.allocate(rows.size * 8).order(ByteOrder.LITTLE_ENDIAN).also { out -> rows.forEach { out.putDouble(value(it)) } }.array()
+
+        private fun intColumn(rows: List<RunDTO>, value: (RunDTO) -> Int): ByteArray =
+            ByteBuffer.allocate(rows.size * 4).order(ByteOrder.LITTLE_ENDIAN).also { out -> rows.forEach { out.putInt(value(it)) } }.array()
+
+        private fun stringTable(values: List<String>): ByteArray {
+            val encoded = values.map { it.encodeToByteArray() }
+            val out = ByteBuffer.allocate(4 + (values.size + 1) * 4 + encoded.sumOf { it.size }).order(ByteOrder.LITTLE_ENDIAN)
+            out.putInt(values.size)
+            var offset = 0
+            out.putInt(offset)
+            encoded.forEach { offset += it.size; out.putInt(offset) }
+            encoded.forEach { out.put(it) }
+            return out.array()
+        }
+    }
+}
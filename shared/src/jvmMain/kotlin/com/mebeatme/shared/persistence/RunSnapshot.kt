@@ -0,0 +1,108 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+
+/**
+ * Immutable version of the JVM store's runs, published after every write so readers
+ * never wait for a writer.
+ *
+ * Runs sit in fixed-size segments that mirror [RunTable] slots, holes included. The
+ * next version copies only the segments whose slots a write touched and shares the
+ * rest, so publishing costs O(touched segments × [SEGMENT_SIZE] + runs / [SEGMENT_SIZE])
+ * rather than a copy of every run. After a [RunTable] compaction or clear, slots have
+ * moved and the next version is rebuilt in full.
+ *
+ * The snapshot is itself the List readers get back, so [JsonRunStore.getAll] copies
+ * nothing. Versions no reader holds any more are left to the garbage collector.
+ */
+internal class RunSnapshot private constructor(
+    private val segments: Array<Array<Any?>>,
+    private val live: IntArray,
+    private val generation: Int
+) : AbstractList<RunDTO>() {
+
+    // Runs before each segment; the last entry is the total
+    private val runsBefore = IntArray(segments.size + 1).also { before ->
+        for (i in segments.indices) before[i + 1] = before[i] + live[i]
+    }
+
+    override val size: Int get() = runsBefore[segments.size]
+
+    override fun get(index: Int): RunDTO {
+        if (index < 0 || index >= size) throw IndexOutOfBoundsException("Index $index, size $size")
+        // Last segment with fewer runs before it than index + 1
+        var low = 0
+        var high = segments.size - 1
+        while (low < high) {
+            val mid = (low + high + 1) ushr 1
+            if (runsBefore[mid] <= index) low = mid else high = mid - 1
+        }
+        var remaining = index - runsBefore[low]
+        for (slot in segments[low]) {
+            if (slot != null && remaining-- == 0) return slot as RunDTO
+        }
+        throw IllegalStateException("Snapshot counts out of step")
+    }
+
+    override fun iterator(): Iterator<RunDTO> = object : Iterator<RunDTO> {
+        private var segment = 0
+        private var slot = 0
+        private var next: RunDTO? = advance()
+
+        override fun hasNext(): Boolean = next != null
+
+        override fun next(): RunDTO {
+            val current = next ?: throw NoSuchElementException()
+            next = advance()
+            return current
+        }
+
+        private fun advance(): RunDTO? {
+            while (segment < segments.size) {
+                val runs = segments[segment]
+                while (slot < runs.size) {
+                    val run = runs[slot++]
+                    if (run != null) return run as RunDTO
+                }
+                segment++
+                slot = 0
+            }
+            return null
+        }
+    }
+
+    /**
+     * The version after a write.
+     * @param dirtySegments Segments (slot / [SEGMENT_SIZE]) whose slots the write changed
+     */
+    fun next(table: RunTable<RunDTO>, dirtySegments: Set<Int>): RunSnapshot {
+        if (table.generation != generation) return of(table)
+        val count = (table.slotCount + SEGMENT_SIZE - 1) / SEGMENT_SIZE
+        val nextSegments = segments.copyOf(count)
+        val nextLive = live.copyOf(count)
+        dirtySegments.forEach { segment ->
+            if (segment < count) nextSegments[segment] = copySegment(table, segment).also { nextLive[segment] = it.countRuns() }
+        }
+        // Slots past the old end belong to segments the write appended to
+        for (segment in 0 until count) {
+            if (nextSegments[segment] == null) nextSegments[segment] = copySegment(table, segment).also { nextLive[segment] = it.countRuns() }
+        }
+        @Suppress("UNCHECKED_CAST")
+        return RunSnapshot(nextSegments as Array<Array<Any?>>, nextLive, table.generation)
+    }
+
+    companion object {
+        const val SEGMENT_SIZE = 256
+
+        fun of(table: RunTable<RunDTO>): RunSnapshot {
+            val count = (table.slotCount + SEGMENT_SIZE - 1) / SEGMENT_SIZE
+            val segments = Array(count) { copySegment(table, it) }
+            return RunSnapshot(segments, IntArray(count) { segments[it].countRuns() }, table.generation)
+        }
+
+        private fun copySegment(table: RunTable<RunDTO>, segment: Int): Array<Any?> =
+            table.copySlots(segment * SEGMENT_SIZE, minOf((segment + 1) * SEGMENT_SIZE, table.slotCount))
+
+        private fun Array<Any?>.countRuns(): Int = count { it != null }
+    }
+}
@@ -0,0 +1,42 @@
+package com.mebeatme.shared.persistence
+
+/**
+ * When the JVM store folds its log into a fresh [RunArchive] snapshot in the background.
+ *
+ * Compaction starts once the active log reaches [maxLogBytes], or once it reaches
+ * [minLogBytes] and at least [maxDeadRatio] of its records are superseded (a run
+ * upserted again, deleted, or wiped by a clear), since replaying those only costs
+ * startup time.
+ */
+data class CompactionPolicy(
+    val maxLogBytes: Long = 8L * 1024 * 1024,
+    val minLogBytes: Long = 64L * 1024,
+    val maxDeadRatio: Double = 0.5
+) {
+    fun shouldCompact(logBytes: Long, records: Int, deadRecords: Int): Boolean =
+        logBytes >= maxLogBytes ||
+            (logBytes >= minLogBytes && records > 0 && deadRecords.toDouble() / records >= maxDeadRatio)
+
+    companion object {
+        /** Never compact on its own; [JsonRunStore.compact] still works. */
+        val MANUAL = CompactionPolicy(maxLogBytes = Long.MAX_VALUE, minLogBytes = Long.MAX_VALUE)
+    }
+}
+
+/**
+ * Compaction counters and current file sizes of a JVM store.
+ * @param lastBytesReclaimed Old snapshot plus compacted log bytes minus the new snapshot; negative if the snapshot grew more than the log it replaced
+ * @param snapshotBytes Size of the current snapshot, 0 before the first compaction
+ * @param logBytes Size of the active log plus any segments awaiting compaction
+ * @param deadRecordRatio Share of active log records superseded by later ones
+ */
+data class CompactionMetrics(
+    val compactions: Int = 0,
+    val lastDurationMs: Long = 0L,
+    val totalDurationMs: Long = 0L,
+    val lastBytesReclaimed: Long = 0L,
+    val totalBytesReclaimed: Long = 0L,
+    val snapshotBytes: Long = 0L,
+    val logBytes: Long = 0L,
+    val deadRecordRatio: Double = 0.0
+)
@@ -0,0 +1,82 @@
+package com.mebeatme.shared.persistence
+
+/**
+ * How the JVM store's commit thread batches writes.
+ *
+ * The commit thread takes everything queued while the previous batch was being
+ * fsynced, up to [maxBatchRecords] log records, so concurrent writers share one
+ * fsync without any added wait. A positive [maxDelayMillis] also holds a batch open
+ * that long after its first write arrives, trading commit latency for fewer fsyncs
+ * under a steady trickle of small writes.
+ */
+data class GroupCommitPolicy(
+    val maxBatchRecords: Int = 4096,
+    val maxDelayMillis: Long = 0L
+) {
+    init {
+        require(maxBatchRecords > 0) { "maxBatchRecords must be positive" }
+        require(maxDelayMillis >= 0) { "maxDelayMillis must not be negative" }
+    }
+}
+
+/**
+ * Commit latency distribution in power-of-two microsecond buckets: bucket i counts
+ * commits that took [2^(i-1), 2^i) µs, so percentiles are accurate to a factor of two.
+ * Not synchronized; [JsonRunStore] copies it under its own lock.
+ */
+class CommitLatencyHistogram internal constructor(private val counts: LongArray = LongArray(BUCKETS)) {
+
+    val count: Long get() = counts.sum()
+
+    /** Commits per bucket; bucket i has upper bound [upperBoundMicros] (i). */
+    fun bucketCounts(): List<Long> = counts.toList()
+
+    /**
+     * Upper bound of the bucket holding quantile [q], in microseconds, or null if nothing was recorded.
+     */
+    fun percentileMicros(q: Double): Long? {
+        require(q in 0.0..1.0) { "Quantile must be in [0, 1]" }
+        val total = count
+        if (total == 0L) return null
+        val rank = maxOf(1L, kotlin.math.ceil(q * total).toLong())
+        var seen = 0L
+        counts.forEachIndexed { bucket, bucketCount ->
+            seen += bucketCount
+            if (seen >= rank) return upperBoundMicros(bucket)
+        }
+        return upperBoundMicros(BUCKETS - 1)
+    }
+
+    internal fun record(nanos: Long) {
+        val micros = maxOf(0L, nanos / 1000)
+        counts[minOf(BUCKETS - 1, 64 - micros.countLeadingZeroBits())]++
+    }
+
+    internal fun copy(): CommitLatencyHistogram = CommitLatencyHistogram(counts.copyOf())
+
+    internal fun clear() = counts.fill(0L)
+
+    companion object {
+        const val BUCKETS = 32
+
+        fun upperBoundMicros(bucket: Int): Long = 1L shl bucket
+    }
+}
+
+/**
+ * Group-commit counters since the store opened or since [JsonRunStore.resetGroupCommitMetrics].
+ * @param mutations Calls committed (an upsertAll, deleteById or clear each count once)
+ * @param commitLatency Time from a call being queued to its batch being on disk and visible
+ */
+data class GroupCommitMetrics(
+    val batches: Long,
+    val mutations: Long,
+    val records: Long,
+    val fsyncs: Long,
+    val elapsedMs: Long,
+    val commitLatency: CommitLatencyHistogram
+) {
+    val fsyncsPerSecond: Double get() = if (elapsedMs == 0L) 0.0 else fsyncs * 1000.0 / elapsedMs
+
+    val mutationsPerBatch: Double get() = if (batches == 0L) 0.0 else mutations.toDouble() / batches
+}
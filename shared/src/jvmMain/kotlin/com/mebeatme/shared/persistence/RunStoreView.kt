@@ -0,0 +1,80 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+import java.util.BitSet
+
+/**
+ * What the JVM store's readers see: the rows of the mapped [RunArchive] that no later
+ * write replaced or deleted, by start time, then the log tail's [RunSnapshot] in write order.
+ *
+ * Archive rows are decoded when read and not kept, so only runs written since the last
+ * compaction stay resident however long the history. Like [RunSnapshot], a view never
+ * changes once published; the store publishes a new one after every write.
+ *
+ * @param archive Current archive, or null before the first compaction and after a clear
+ * @param hidden Archive rows the tail replaced or deleted; never modified after publishing
+ */
+internal class RunStoreView(
+    private val archive: RunArchive?,
+    val hidden: BitSet,
+    val tail: RunSnapshot
+) : AbstractList<RunDTO>() {
+
+    private val archived = if (archive == null) 0 else archive.size - hidden.cardinality()
+
+    override val size: Int get() = archived + tail.size
+
+    override fun get(index: Int): RunDTO {
+        if (index < 0 || index >= size) throw IndexOutOfBoundsException("Index $index, size $size")
+        if (index >= archived) return tail[index - archived]
+        // Each hidden row at or before the candidate pushes it one row further
+        var row = index
+        var skipped = hidden.nextSetBit(0)
+        while (skipped in 0..row) {
+            row++
+            skipped = hidden.nextSetBit(skipped + 1)
+        }
+        return archive!!.read(row)
+    }
+
+    override fun iterator(): Iterator<RunDTO> = object : Iterator<RunDTO> {
+        private var row = nextVisible(0)
+        private val tailRuns = tail.iterator()
+
+        override fun hasNext(): Boolean = row >= 0 || tailRuns.hasNext()
+
+        override fun next(): RunDTO {
+            if (row < 0) return tailRuns.next()
+            return archive!!.read(row).also { row = nextVisible(row + 1) }
+        }
+    }
+
+    /**
+     * Runs started at or after [sinceMs]: archive rows from a binary search of the start column, then the tail.
+     */
+    fun listSince(sinceMs: Long): List<RunDTO> {
+        val runs = ArrayList<RunDTO>()
+        var row = if (archive == null) -1 else nextVisible(archive.firstRowSince(sinceMs))
+        while (row >= 0) {
+            runs.add(archive!!.read(row))
+            row = nextVisible(row + 1)
+        }
+        tail.filterTo(runs) { it.startedAtEpochMs >= sinceMs }
+        return runs
+    }
+
+    /**
+     * The archived version of [id], unless the tail replaced or deleted it.
+     */
+    fun archived(id: String): RunDTO? {
+        val row = archive?.rowOf(id) ?: -1
+        return if (row < 0 || hidden[row]) null else archive!!.read(row)
+    }
+
+    // First visible archive row at or after [from], or -1
+    private fun nextVisible(from: Int): Int {
+        if (archive == null) return -1
+        val row = hidden.nextClearBit(from)
+        return if (row < archive.size) row else -1
+    }
+}
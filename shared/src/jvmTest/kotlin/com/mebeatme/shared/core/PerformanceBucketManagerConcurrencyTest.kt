@@ -0,0 +1,62 @@
+package com.mebeatme.shared.core
+
+import com.mebeatme.shared.model.DistanceBucket
+import java.util.concurrent.CountDownLatch
+import kotlin.concurrent.thread
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+
+class PerformanceBucketManagerConcurrencyTest {
+    
+    private val threads = 8
+    private val updatesPerThread = 250_000
+    private val buckets = DistanceBucket.values()
+    
+    @Test
+    fun testConcurrentUpdatesKeepTheMaximum() {
+        val manager = PerformanceBucketManager()
+        val expected = DoubleArray(buckets.size)
+        val offered = List(threads) { seed -> offers(seed) }
+        offered.flatten().forEach { (bucket, ppi) -> expected[bucket.ordinal] = maxOf(expected[bucket.ordinal], ppi) }
+        
+        runConcurrently { worker -> offered[worker].forEach { (bucket, ppi) -> manager.offerBest(bucket, ppi) } }
+        
+        buckets.forEach { assertEquals(expected[it.ordinal], manager.getHistoricalBest(it), "bucket $it") }
+    }
+    
+    @Test
+    fun testSnapshotsNeverGoBackwards() {
+        val manager = PerformanceBucketManager()
+        val offered = List(threads) { seed -> offers(seed) }
+        var regressed = false
+        
+        val reader = thread {
+            var previous = manager.getBucketStats()
+            while (!Thread.currentThread().isInterrupted) {
+                val next = manager.getBucketStats()
+                if (buckets.any { next.getValue(it).historicalBest < previous.getValue(it).historicalBest }) regressed = true
+                previous = next
+            }
+        }
+        runConcurrently { worker -> offered[worker].forEach { (bucket, ppi) -> manager.offerBest(bucket, ppi) } }
+        reader.interrupt()
+        reader.join()
+        
+        assertFalse(regressed)
+    }
+    
+    private fun offers(seed: Int): List<Pair<DistanceBucket, Double>> {
+        val random = Random(seed)
+        return List(updatesPerThread) { buckets[random.nextInt(buckets.size)] to random.nextDouble(100.0, 1200.0) }
+    }
+    
+    // Starts all workers together and returns once the last one finishes
+    private fun runConcurrently(work: (Int) -> Unit) {
+        val start = CountDownLatch(1)
+        val workers = (0 until threads).map { worker -> thread { start.await(); work(worker) } }
+        start.countDown()
+        workers.forEach { it.join() }
+    }
+}
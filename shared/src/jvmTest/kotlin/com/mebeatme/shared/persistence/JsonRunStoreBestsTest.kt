@@ -0,0 +1,98 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.core.calculateBests
+import com.mebeatme.shared.model.RunDTO
+import kotlinx.datetime.LocalDate
+import kotlinx.datetime.LocalDateTime
+import kotlinx.datetime.TimeZone
+import kotlinx.datetime.atStartOfDayIn
+import kotlinx.datetime.toInstant
+import java.io.File
+import java.nio.file.Files
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+
+class JsonRunStoreBestsTest {
+    
+    @Test
+    fun testBestsTrackUpsertsAndDeletes() {
+        val store = createStore()
+        store.upsertAll(listOf(
+            createRunDTO("run1", 5000.0, 1300),
+            createRunDTO("run2", 5010.0, 1250),
+            createRunDTO("run3", 42195.0, 11000)
+        ))
+        
+        assertEquals(1250, store.getBests(nowMs = 0L).best5kSec)
+        assertEquals(11000, store.getBests(nowMs = 0L).bestFullSec)
+        
+        store.deleteById("run2")
+        assertEquals(1300, store.getBests(nowMs = 0L).best5kSec)
+        
+        store.clear()
+        assertNull(store.getBests(nowMs = 0L).best5kSec)
+    }
+    
+    @Test
+    fun testBestsSurviveReload() {
+        val dataFile = File(Files.createTempDirectory("mebeatme_test").toFile(), "runs.json")
+        JsonRunStore(dataFile).upsertAll(listOf(createRunDTO("run1", 10000.0, 2600)))
+        
+        assertEquals(2600, JsonRunStore(dataFile).getBests(nowMs = 0L).best10kSec)
+    }
+    
+    @Test
+    fun testBestsMatchCalculateBests() {
+        val store = createStore()
+        val runs = (1..300).map { i ->
+            val distance = listOf(5000.0, 10000.0, 21097.5, 42195.0, 7000.0)[i % 5]
+            createRunDTO("run$i", distance, 1000 + (i * 37) % 9000, startedAt = i * 1000L)
+        }
+        store.upsertAll(runs)
+        
+        val expected = calculateBests(runs, sinceMs = 150_000L)
+        val actual = store.getBests(nowMs = 0L, sinceMs = 150_000L)
+        assertEquals(expected.best5kSec, actual.best5kSec)
+        assertEquals(expected.best10kSec, actual.best10kSec)
+        assertEquals(expected.bestHalfSec, actual.bestHalfSec)
+        assertEquals(expected.bestFullSec, actual.bestFullSec)
+    }
+    
+    @Test
+    fun testRollupsFollowTheStoreTimeZone() {
+        // 23:30 on New Year's Day in New York is already January 2nd in UTC
+        val zone = TimeZone.of("America/New_York")
+        val startedAt = LocalDateTime(2024, 1, 1, 23, 30).toInstant(zone).toEpochMilliseconds()
+        val newYork = JsonRunStore(File(Files.createTempDirectory("mebeatme_test").toFile(), "runs.json"), zone)
+        val utc = JsonRunStore(File(Files.createTempDirectory("mebeatme_test").toFile(), "runs.json"), TimeZone.UTC)
+        listOf(newYork, utc).forEach { it.upsertAll(listOf(createRunDTO("late", 5000.0, 1500, startedAt))) }
+        
+        val range = startedAt - 3 * 24 * 3600_000L
+        assertEquals(
+            LocalDate(2024, 1, 1).atStartOfDayIn(zone).toEpochMilliseconds(),
+            newYork.getRollups(RollupPeriod.DAY, range, startedAt).single().startEpochMs
+        )
+        assertEquals(
+            LocalDate(2024, 1, 2).atStartOfDayIn(TimeZone.UTC).toEpochMilliseconds(),
+            utc.getRollups(RollupPeriod.DAY, range, startedAt).single().startEpochMs
+        )
+    }
+    
+    private fun createStore(): JsonRunStore {
+        val tempDir = Files.createTempDirectory("mebeatme_test").toFile()
+        return JsonRunStore(File(tempDir, "runs.json"))
+    }
+    
+    private fun createRunDTO(id: String, distance: Double, seconds: Int, startedAt: Long = 0L): RunDTO {
+        return RunDTO(
+            id = id,
+            source = "test",
+            startedAtEpochMs = startedAt,
+            endedAtEpochMs = startedAt + seconds * 1000L,
+            distanceMeters = distance,
+            elapsedSeconds = seconds,
+            avgPaceSecPerKm = seconds / (distance / 1000.0)
+        )
+    }
+}
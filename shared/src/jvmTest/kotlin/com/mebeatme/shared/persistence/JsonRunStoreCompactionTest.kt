@@ -0,0 +1,152 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+import java.io.File
+import java.nio.file.Files
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.TimeUnit
+import kotlin.concurrent.thread
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+class JsonRunStoreCompactionTest {
+
+    @Test
+    fun testCompactionReclaimsLogAndReopenMatches() {
+        val dataFile = createDataFile()
+        val store = JsonRunStore(dataFile).apply { compactionPolicy = CompactionPolicy.MANUAL }
+        repeat(20) { round -> store.upsertAll((1..100).map { createRunDTO("run$it", 1200 + round, it) }) }
+        (1..50).forEach { store.deleteById("run$it") }
+        val before = store.getCompactionMetrics()
+        assertEquals((19 * 100 + 50 * 2).toDouble() / (20 * 100 + 50), before.deadRecordRatio, 1e-9)
+
+        assertTrue(store.compact())
+        assertFalse(store.compact())
+        val metrics = store.getCompactionMetrics()
+        assertEquals(1, metrics.compactions)
+        assertTrue(metrics.lastBytesReclaimed > 0)
+        assertEquals(before.logBytes - metrics.lastBytesReclaimed, metrics.snapshotBytes)
+        assertEquals(RunLogCodec.MAGIC.size.toLong(), metrics.logBytes)
+        assertEquals(0.0, metrics.deadRecordRatio)
+
+        store.upsertAll(listOf(createRunDTO("late", 1500, 1)))
+        val expected = store.getAll().sortedBy { it.id }
+        val expectedBests = store.getBests(nowMs = 0L)
+        store.close()
+
+        val reopened = JsonRunStore(dataFile)
+        assertEquals(expected, reopened.getAll().sortedBy { it.id })
+        assertEquals(expectedBests, reopened.getBests(nowMs = 0L))
+        assertFalse(File(dataFile.path + ".log.1").exists())
+    }
+
+    @Test
+    fun testArchivedRunsServeReadsAfterCompaction() {
+        val dataFile = createDataFile()
+        val store = JsonRunStore(dataFile).apply { compactionPolicy = CompactionPolicy.MANUAL }
+        store.upsertAll((1..100).map { createRunDTO("run$it", 1200, it) })
+        assertTrue(store.compact())
+
+        store.upsertAll(listOf(createRunDTO("run10", 1100, 10), createRunDTO("late", 1500, 200)))
+        assertTrue(store.deleteById("run20"))
+        assertFalse(store.deleteById("run20"))
+
+        assertEquals(1100, store.getById("run10")?.elapsedSeconds)
+        assertEquals(null, store.getById("run20"))
+        assertEquals(1200, store.getById("run30")?.elapsedSeconds)
+        assertEquals(100, store.size())
+        assertEquals((91..100).map { "run$it" } + "late", store.listSince(91 * 86_400_000L).map { it.id })
+        val all = store.getAll()
+        assertEquals(all.indices.map { all[it] }, all.toList())
+        assertEquals(listOf("run10", "late"), all.takeLast(2).map { it.id })
+
+        // Updates and deletes since the compaction are replayed over the archive on reopen
+        val expected = all.sortedBy { it.id }
+        store.close()
+        val reopened = JsonRunStore(dataFile)
+        assertEquals(expected, reopened.getAll().sortedBy { it.id })
+        assertEquals(null, reopened.getById("run20"))
+        assertEquals(1100, reopened.getBests(nowMs = 0L).best5kSec)
+    }
+
+    @Test
+    fun testCrashBeforeSegmentsAreDeletedIsHarmless() {
+        val dataFile = createDataFile()
+        JsonRunStore(dataFile).apply {
+            compactionPolicy = CompactionPolicy.MANUAL
+            upsertAll((1..10).map { createRunDTO("run$it", 1200, it) })
+            clear()
+            upsertAll((1..5).map { createRunDTO("run$it", 1300, it) })
+            deleteById("run5")
+            close()
+        }
+
+        // Seal the log and write its snapshot, as a compaction would, but keep the segment
+        val logFile = File(dataFile.path + ".log")
+        val segment = File(dataFile.path + ".log.1")
+        Files.copy(logFile.toPath(), segment.toPath())
+        logFile.delete()
+        RunArchive.write(File(dataFile.path + ".archive"), (1..4).map { createRunDTO("run$it", 1300, it) })
+
+        val reopened = JsonRunStore(dataFile)
+        assertEquals(listOf("run1", "run2", "run3", "run4"), reopened.getAll().map { it.id }.sorted())
+        assertTrue(reopened.compact())
+        assertFalse(segment.exists())
+        reopened.close()
+        assertEquals(4, JsonRunStore(dataFile).size())
+    }
+
+    @Test
+    fun testWritesContinueDuringBackgroundCompaction() {
+        val dataFile = createDataFile()
+        val store = JsonRunStore(dataFile)
+        store.compactionPolicy = CompactionPolicy(maxLogBytes = 32 * 1024, minLogBytes = 32 * 1024)
+
+        val done = CountDownLatch(1)
+        var reads = 0
+        val reader = thread {
+            while (done.count > 0) {
+                if (store.getAll().size <= 300) reads++
+            }
+        }
+        repeat(2000) { store.upsertAll(listOf(createRunDTO("run${it % 300}", 1200 + it % 600, it))) }
+        done.countDown()
+        reader.join(TimeUnit.SECONDS.toMillis(10))
+        assertTrue(reads > 0)
+
+        val expected = store.getAll().sortedBy { it.id }
+        store.close()
+        assertTrue(store.getCompactionMetrics().compactions > 0)
+        assertTrue(File(dataFile.path + ".archive").exists())
+        assertEquals(expected, JsonRunStore(dataFile).getAll().sortedBy { it.id })
+    }
+
+    @Test
+    fun testPolicyTriggers() {
+        val policy = CompactionPolicy(maxLogBytes = 1000, minLogBytes = 100, maxDeadRatio = 0.5)
+        assertTrue(policy.shouldCompact(1000, 10, 0))
+        assertFalse(policy.shouldCompact(99, 10, 10))
+        assertTrue(policy.shouldCompact(100, 10, 5))
+        assertFalse(policy.shouldCompact(500, 10, 4))
+        assertFalse(CompactionPolicy.MANUAL.shouldCompact(Long.MAX_VALUE - 1, 10, 10))
+    }
+
+    private fun createDataFile(): File {
+        val tempDir = Files.createTempDirectory("mebeatme_test").toFile()
+        return File(tempDir, "runs.json")
+    }
+
+    private fun createRunDTO(id: String, seconds: Int, day: Int): RunDTO {
+        return RunDTO(
+            id = id,
+            source = "test",
+            startedAtEpochMs = day * 86_400_000L,
+            endedAtEpochMs = day * 86_400_000L + seconds * 1000L,
+            distanceMeters = 5000.0,
+            elapsedSeconds = seconds,
+            avgPaceSecPerKm = seconds / 5.0
+        )
+    }
+}
@@ -0,0 +1,158 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+import java.io.File
+import java.nio.file.Files
+import java.util.concurrent.CompletableFuture
+import java.util.concurrent.ConcurrentLinkedQueue
+import java.util.concurrent.ExecutionException
+import java.util.concurrent.TimeUnit
+import kotlin.concurrent.thread
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class JsonRunStoreGroupCommitTest {
+
+    @Test
+    fun testConcurrentWritersAllCommit() {
+        val dataFile = createDataFile()
+        val store = JsonRunStore(dataFile).apply { compactionPolicy = CompactionPolicy.MANUAL }
+        val writers = 8
+        val writesEach = 200
+
+        (0 until writers).map { writer ->
+            thread { repeat(writesEach) { store.upsertAll(listOf(createRunDTO("w$writer-$it", 1200 + it))) } }
+        }.forEach { it.join() }
+
+        val metrics = store.getGroupCommitMetrics()
+        assertEquals((writers * writesEach).toLong(), metrics.mutations)
+        assertEquals(metrics.mutations, metrics.commitLatency.count)
+        assertTrue(metrics.batches in 1..metrics.mutations)
+
+        val expected = store.getAll().sortedBy { it.id }
+        assertEquals(writers * writesEach, expected.size)
+        store.close()
+        assertEquals(expected, JsonRunStore(dataFile).getAll().sortedBy { it.id })
+    }
+
+    @Test
+    fun testCloseNeverStrandsRacingWriters() {
+        repeat(20) { round ->
+            val store = JsonRunStore(createDataFile())
+            store.upsertAll(listOf(createRunDTO("first", 1200)))
+            val futures = ConcurrentLinkedQueue<CompletableFuture<Int>>()
+            val writers = (0 until 4).map { writer ->
+                thread {
+                    var i = 0
+                    while (true) {
+                        try {
+                            futures.add(store.upsertAllAsync(listOf(createRunDTO("r$round-$writer-${i++}", 1200))))
+                        } catch (e: IllegalStateException) {
+                            break
+                        }
+                    }
+                }
+            }
+            Thread.sleep(5)
+            store.close()
+            writers.forEach { it.join() }
+
+            // Every accepted write either committed or failed; none is left waiting
+            futures.forEach { future ->
+                try {
+                    future.get(10, TimeUnit.SECONDS)
+                } catch (e: ExecutionException) {
+                    assertTrue(e.cause is IllegalStateException)
+                }
+            }
+        }
+    }
+
+    @Test
+    fun testInterruptedCommitterKeepsCommitting() {
+        val dataFile = createDataFile()
+        val store = JsonRunStore(dataFile)
+        store.upsertAll(listOf(createRunDTO("before", 1200)))
+
+        Thread.getAllStackTraces().keys.filter { it.name == "run-store-committer" }.forEach { it.interrupt() }
+        assertEquals(1, store.upsertAllAsync(listOf(createRunDTO("after", 1300))).get(10, TimeUnit.SECONDS))
+
+        store.close()
+        assertEquals(setOf("before", "after"), JsonRunStore(dataFile).getAll().map { it.id }.toSet())
+    }
+
+    @Test
+    fun testMutationsInOneBatchSeeEachOther() {
+        val dataFile = createDataFile()
+        val store = JsonRunStore(dataFile)
+        store.groupCommitPolicy = GroupCommitPolicy(maxDelayMillis = 200)
+
+        val upserted = store.upsertAllAsync(listOf(createRunDTO("run1", 1200), createRunDTO("run2", 1300)))
+        val deleted = store.deleteByIdAsync("run1")
+        val deletedAgain = store.deleteByIdAsync("run1")
+        val cleared = store.clearAsync()
+        val afterClear = store.deleteByIdAsync("run2")
+        val last = store.upsertAllAsync(listOf(createRunDTO("run3", 1400)))
+
+        assertEquals(2, upserted.get())
+        assertEquals(true, deleted.get())
+        assertEquals(false, deletedAgain.get())
+        cleared.get()
+        assertEquals(false, afterClear.get())
+        assertEquals(1, last.get())
+        assertEquals(1L, store.getGroupCommitMetrics().batches)
+        assertEquals(listOf("run3"), store.getAll().map { it.id })
+        assertNull(store.getById("run2"))
+
+        store.close()
+        assertFailsWith<IllegalStateException> { store.upsertAll(listOf(createRunDTO("late", 1500))) }
+        assertEquals(listOf("run3"), JsonRunStore(dataFile).getAll().map { it.id })
+    }
+
+    @Test
+    fun testBatchesRespectMaxRecords() {
+        val store = JsonRunStore(createDataFile())
+        store.groupCommitPolicy = GroupCommitPolicy(maxBatchRecords = 2, maxDelayMillis = 100)
+
+        val futures = (1..6).map { store.upsertAllAsync(listOf(createRunDTO("run$it", 1200))) }
+        futures.forEach { it.get() }
+
+        assertTrue(store.getGroupCommitMetrics().batches >= 3)
+        store.resetGroupCommitMetrics()
+        assertEquals(0L, store.getGroupCommitMetrics().batches)
+        assertEquals(6, store.size())
+    }
+
+    @Test
+    fun testLatencyHistogramPercentiles() {
+        val histogram = CommitLatencyHistogram()
+        assertNull(histogram.percentileMicros(0.5))
+        repeat(90) { histogram.record(300_000L) }       // 300 µs → [256, 512)
+        repeat(10) { histogram.record(5_000_000L) }     // 5 ms → [4096, 8192)
+
+        assertEquals(512L, histogram.percentileMicros(0.5))
+        assertEquals(512L, histogram.percentileMicros(0.9))
+        assertEquals(8192L, histogram.percentileMicros(0.99))
+        assertEquals(100L, histogram.count)
+    }
+
+    private fun createDataFile(): File {
+        val tempDir = Files.createTempDirectory("mebeatme_test").toFile()
+        return File(tempDir, "runs.json")
+    }
+
+    private fun createRunDTO(id: String, seconds: Int): RunDTO {
+        return RunDTO(
+            id = id,
+            source = "test",
+            startedAtEpochMs = 0L,
+            endedAtEpochMs = seconds * 1000L,
+            distanceMeters = 5000.0,
+            elapsedSeconds = seconds,
+            avgPaceSecPerKm = seconds / 5.0
+        )
+    }
+}
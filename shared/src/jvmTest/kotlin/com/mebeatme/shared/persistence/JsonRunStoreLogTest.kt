@@ -0,0 +1,117 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+import kotlinx.serialization.encodeToString
+import kotlinx.serialization.json.Json
+import java.io.File
+import java.io.RandomAccessFile
+import java.nio.file.Files
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class JsonRunStoreLogTest {
+    
+    @Test
+    fun testReopenReplaysUpsertsDeletesAndClears() {
+        val dataFile = createDataFile()
+        JsonRunStore(dataFile).apply {
+            upsertAll(listOf(createRunDTO("run1", 1200), createRunDTO("run2", 1300)))
+            upsertAll(listOf(createRunDTO("run1", 1100)))
+            deleteById("run2")
+            close()
+        }
+        
+        val reopened = JsonRunStore(dataFile)
+        assertEquals(listOf("run1"), reopened.getAll().map { it.id })
+        assertEquals(1100, reopened.getById("run1")?.elapsedSeconds)
+        assertEquals(1100, reopened.getBests(nowMs = 0L).best5kSec)
+        
+        reopened.clear()
+        reopened.upsertAll(listOf(createRunDTO("run3", 1400)))
+        reopened.close()
+        assertEquals(listOf("run3"), JsonRunStore(dataFile).getAll().map { it.id })
+    }
+    
+    @Test
+    fun testTornTailIsCutOffAndAppendsContinue() {
+        val dataFile = createDataFile()
+        JsonRunStore(dataFile).apply {
+            upsertAll(listOf(createRunDTO("run1", 1200)))
+            upsertAll(listOf(createRunDTO("run2", 1300)))
+            close()
+        }
+        
+        // Simulate a crash halfway through the last append
+        val logFile = File(dataFile.path + ".log")
+        RandomAccessFile(logFile, "rw").use { it.setLength(it.length() - 10) }
+        
+        val recovered = JsonRunStore(dataFile)
+        assertEquals(listOf("run1"), recovered.getAll().map { it.id })
+        recovered.upsertAll(listOf(createRunDTO("run3", 1400)))
+        recovered.close()
+        
+        assertEquals(listOf("run1", "run3"), JsonRunStore(dataFile).getAll().map { it.id })
+    }
+    
+    @Test
+    fun testLegacyJsonIsMigratedOnce() {
+        val dataFile = createDataFile()
+        val legacy = listOf(createRunDTO("old1", 1500), createRunDTO("old2", 1600))
+        dataFile.writeText(Json.encodeToString(legacy))
+        
+        val store = JsonRunStore(dataFile)
+        assertEquals(listOf("old1", "old2"), store.getAll().map { it.id })
+        store.deleteById("old1")
+        store.close()
+        
+        // The backup is left in place but the log wins from now on
+        val reopened = JsonRunStore(dataFile)
+        assertEquals(listOf("old2"), reopened.getAll().map { it.id })
+        assertNull(reopened.getById("old1"))
+    }
+    
+    @Test
+    fun testExportImportRoundTrip() {
+        val source = JsonRunStore(createDataFile())
+        source.upsertAll((1..5).map { createRunDTO("run$it", 1200 + it) })
+        
+        val target = JsonRunStore(createDataFile())
+        assertEquals(5, target.importJson(source.exportJson()))
+        assertEquals(source.getAll(), target.getAll())
+    }
+    
+    @Test
+    fun testSingleUpsertAppendsOnlyItsRecord() {
+        val dataFile = createDataFile()
+        val store = JsonRunStore(dataFile).apply { compactionPolicy = CompactionPolicy.MANUAL }
+        store.upsertAll((1..10_000).map { createRunDTO("run$it", 1200 + it % 600) })
+        val logFile = File(dataFile.path + ".log")
+        
+        // The log grows by one small record per write, not by a rewrite of the 10k stored runs
+        repeat(20) {
+            val before = logFile.length()
+            store.upsertAll(listOf(createRunDTO("new$it", 1300)))
+            assertTrue(logFile.length() - before in 1..1024, "upsert $it appended ${logFile.length() - before} bytes")
+        }
+        store.close()
+    }
+    
+    private fun createDataFile(): File {
+        val tempDir = Files.createTempDirectory("mebeatme_test").toFile()
+        return File(tempDir, "runs.json")
+    }
+    
+    private fun createRunDTO(id: String, seconds: Int): RunDTO {
+        return RunDTO(
+            id = id,
+            source = "test",
+            startedAtEpochMs = 0L,
+            endedAtEpochMs = seconds * 1000L,
+            distanceMeters = 5000.0,
+            elapsedSeconds = seconds,
+            avgPaceSecPerKm = seconds / 5.0
+        )
+    }
+}
@@ -0,0 +1,175 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+import java.io.File
+import java.io.RandomAccessFile
+import java.nio.file.Files
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+/**
+ * Fault injection against the JVM store's files: every run whose write returned must
+ * survive a crash at any point after it.
+ */
+class JsonRunStoreRecoveryTest {
+
+    @Test
+    fun testTornAppendsNeverLoseAcknowledgedRuns() {
+        val random = Random(22)
+        repeat(40) { round ->
+            val dataFile = createDataFile()
+            val logFile = File(dataFile.path + ".log")
+            val acknowledged = mutableListOf<String>()
+            JsonRunStore(dataFile).apply {
+                compactionPolicy = CompactionPolicy.MANUAL
+                repeat(1 + random.nextInt(30)) {
+                    upsertAll(listOf(createRunDTO("r$round-$it", 1200 + it)))
+                    acknowledged.add("r$round-$it")
+                }
+                close()
+            }
+
+            // The crash hit the next append: part of a record, garbage, or preallocated zeros reach the disk
+            val next = RunLogCodec.encode(RunLog(RunDTO.serializer()) { it.id }.upsert(createRunDTO("lost", 1500)))
+            val tail = when (round % 3) {
+                0 -> next.copyOf(1 + random.nextInt(next.size - 1))
+                1 -> random.nextBytes(1 + random.nextInt(64))
+                else -> ByteArray(1 + random.nextInt(4096))
+            }
+            logFile.appendBytes(tail)
+
+            val recovered = JsonRunStore(dataFile)
+            assertEquals(acknowledged.toSet(), recovered.getAll().map { it.id }.toSet(), "round $round")
+            assertEquals(0, recovered.getLogRecovery().damagedRecords, "round $round")
+            recovered.upsertAll(listOf(createRunDTO("after", 1300)))
+            recovered.close()
+            assertEquals(acknowledged.size + 1, JsonRunStore(dataFile).size())
+        }
+    }
+
+    @Test
+    fun testBitRotLosesOnlyTheDamagedRecord() {
+        val dataFile = createDataFile()
+        val logFile = File(dataFile.path + ".log")
+        val recordEnds = mutableListOf<Long>()
+        JsonRunStore(dataFile).apply {
+            compactionPolicy = CompactionPolicy.MANUAL
+            (1..100).forEach {
+                upsertAll(listOf(createRunDTO("run$it", 1200 + it)))
+                recordEnds.add(logFile.length())
+            }
+            close()
+        }
+
+        // Flip a payload byte of run50's record
+        val offset = (recordEnds[48] + recordEnds[49]) / 2
+        RandomAccessFile(logFile, "rw").use { raf ->
+            raf.seek(offset)
+            val original = raf.read()
+            raf.seek(offset)
+            raf.write(original xor 0x20)
+        }
+
+        val damaged = logFile.readBytes()
+
+        val recovered = JsonRunStore(dataFile)
+        val ids = recovered.getAll().map { it.id }.toSet()
+        assertEquals(99, ids.size)
+        assertFalse("run50" in ids)
+
+        // The loss is reported and the log as found is kept for manual recovery
+        val recovery = recovered.getLogRecovery()
+        assertEquals(1, recovery.damagedRecords)
+        assertEquals(recordEnds[49] - recordEnds[48], recovery.damagedBytes)
+        assertEquals(listOf(logFile.path + ".corrupt"), recovery.keptAside)
+        assertTrue(damaged.contentEquals(File(recovery.keptAside[0]).readBytes()))
+        recovered.upsertAll(listOf(createRunDTO("run101", 1300)))
+        recovered.close()
+
+        // The log was rewritten without the damaged record, so the next open is clean
+        assertEquals(100, JsonRunStore(dataFile).size())
+        assertFalse(RunLogCodec.decode(logFile.readBytes()).needsRewrite)
+    }
+
+    @Test
+    fun testInterruptedSnapshotWriteIsIgnored() {
+        val dataFile = createDataFile()
+        JsonRunStore(dataFile).apply {
+            compactionPolicy = CompactionPolicy.MANUAL
+            upsertAll((1..20).map { createRunDTO("run$it", 1200 + it) })
+            compact()
+            upsertAll(listOf(createRunDTO("run21", 1300)))
+            close()
+        }
+
+        // A crash before the rename leaves a partial temp file next to the intact snapshot
+        val tempFile = File(dataFile.path + ".archive" + AtomicFiles.TEMP_SUFFIX)
+        tempFile.writeBytes(File(dataFile.path + ".archive").readBytes().copyOf(100))
+
+        assertEquals(21, JsonRunStore(dataFile).size())
+        assertFalse(tempFile.exists())
+    }
+
+    @Test
+    fun testDamagedSnapshotFailsLoudly() {
+        val dataFile = createDataFile()
+        JsonRunStore(dataFile).apply {
+            upsertAll((1..20).map { createRunDTO("run$it", 1200 + it) })
+            compact()
+            close()
+        }
+        val archive = File(dataFile.path + ".archive")
+        val bytes = archive.readBytes()
+        archive.writeBytes(bytes.copyOf().also { it[bytes.size / 2] = (it[bytes.size / 2].toInt() xor 1).toByte() })
+
+        assertFailsWith<IllegalStateException> { JsonRunStore(dataFile) }
+    }
+
+    @Test
+    fun testCorruptLegacyFileIsKeptAside() {
+        val dataFile = createDataFile()
+        dataFile.writeText("[{\"id\": \"run1\", \"source\"")
+
+        val store = JsonRunStore(dataFile)
+        assertEquals(0, store.size())
+        assertTrue(File(dataFile.path + ".corrupt").exists())
+        assertFalse(dataFile.exists())
+    }
+
+    @Test
+    fun testLargeLogReplaysEveryRecord() {
+        val dataFile = createDataFile()
+        JsonRunStore(dataFile).apply {
+            compactionPolicy = CompactionPolicy.MANUAL
+            upsertAll((1..10_000).map { createRunDTO("run$it", 1200 + it % 600) })
+            close()
+        }
+
+        assertEquals(10_000, RunLogCodec.decode(File(dataFile.path + ".log").readBytes()).records.size)
+        val reopened = JsonRunStore(dataFile)
+        assertEquals(10_000, reopened.size())
+        assertEquals(1200 + 9_999 % 600, reopened.getById("run9999")?.elapsedSeconds)
+        reopened.close()
+    }
+
+    private fun createDataFile(): File {
+        val tempDir = Files.createTempDirectory("mebeatme_test").toFile()
+        return File(tempDir, "runs.json")
+    }
+
+    private fun createRunDTO(id: String, seconds: Int): RunDTO {
+        return RunDTO(
+            id = id,
+            source = "test",
+            startedAtEpochMs = 0L,
+            endedAtEpochMs = seconds * 1000L,
+            distanceMeters = 5000.0,
+            elapsedSeconds = seconds,
+            avgPaceSecPerKm = seconds / 5.0
+        )
+    }
+}
@@ -0,0 +1,96 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+import java.io.File
+import java.nio.file.Files
+import java.util.concurrent.atomic.AtomicBoolean
+import kotlin.concurrent.thread
+import kotlin.random.Random
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class JsonRunStoreSnapshotTest {
+
+    @Test
+    fun testSnapshotsStayFixedAndTrackWrites() {
+        val store = JsonRunStore(createDataFile()).apply { compactionPolicy = CompactionPolicy.MANUAL }
+        val expected = LinkedHashMap<String, RunDTO>()
+        val random = Random(20)
+
+        repeat(40) { round ->
+            val batch = (1..50).map { createRunDTO("run${random.nextInt(1500)}", 1200 + round) }
+            store.upsertAll(batch)
+            batch.forEach { expected[it.id] = it }
+            val before = store.getAll()
+            val beforeIds = before.map { it.id }
+
+            // Enough deletes to make the run table compact its slots now and then
+            expected.keys.filter { random.nextInt(3) == 0 }.forEach { id ->
+                assertTrue(store.deleteById(id))
+                expected.remove(id)
+            }
+
+            assertEquals(beforeIds, before.map { it.id })
+            val after = store.getAll()
+            assertEquals(expected.values.toList(), after)
+            assertEquals(after.indices.map { after[it] }, after.toList())
+            assertEquals(expected.size, store.size())
+        }
+
+        val held = store.getAll()
+        store.clear()
+        assertTrue(held.isNotEmpty())
+        assertEquals(0, store.getAll().size)
+        assertNull(store.getById(held[0].id))
+    }
+
+    @Test
+    fun testReadsStayConsistentUnderWriteLoad() {
+        val store = JsonRunStore(createDataFile()).apply { compactionPolicy = CompactionPolicy.MANUAL }
+        store.upsertAll((1..10_000).map { createRunDTO("run$it", 1200 + it % 600) })
+
+        // The writer only overwrites and adds, so every reader must see all of the first 10k runs
+        val writing = AtomicBoolean(true)
+        val writer = thread {
+            var i = 0
+            while (writing.get()) store.upsertAll(listOf(createRunDTO("run${i++ % 20_000 + 1}", 1300)))
+        }
+        val failures = List(4) { readerIndex ->
+            val failed = AtomicBoolean(false)
+            thread {
+                repeat(5_000) { i ->
+                    val ok = when ((i + readerIndex) % 3) {
+                        0 -> store.getAll().let { runs -> runs.size >= 10_000 && runs.map { it.id }.toSet().size == runs.size }
+                        1 -> store.getById("run${i % 10_000 + 1}") != null
+                        else -> store.size() >= 10_000
+                    }
+                    if (!ok) failed.set(true)
+                }
+            } to failed
+        }.map { (reader, failed) -> reader.join(); failed.get() }
+        writing.set(false)
+        writer.join()
+
+        assertEquals(List(4) { false }, failures)
+        assertTrue(store.size() >= 10_000)
+    }
+
+    private fun createDataFile(): File {
+        val tempDir = Files.createTempDirectory("mebeatme_test").toFile()
+        return File(tempDir, "runs.json")
+    }
+
+    private fun createRunDTO(id: String, seconds: Int): RunDTO {
+        return RunDTO(
+            id = id,
+            source = "test",
+            startedAtEpochMs = 0L,
+            endedAtEpochMs = seconds * 1000L,
+            distanceMeters = 5000.0,
+            elapsedSeconds = seconds,
+            avgPaceSecPerKm = seconds / 5.0
+        )
+    }
+}
@@ -0,0 +1,70 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+import java.io.File
+import java.nio.file.Files
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+
+class JsonRunStoreUpsertTest {
+    
+    @Test
+    fun testBackfillOverwritesAndAppends() {
+        val tempDir = Files.createTempDirectory("mebeatme_test").toFile()
+        try {
+            val store = JsonRunStore(File(tempDir, "runs.json"))
+            store.upsertAll((0 until 1_000).map { createRunDTO("run$it", it) })
+            
+            // Half of the backfill overwrites stored runs, half is new
+            store.upsertAll((500 until 1_500).map { createRunDTO("run$it", it + 1) })
+            
+            assertEquals(1_500, store.size())
+            assertEquals(1200 + 499, store.getById("run499")?.elapsedSeconds)
+            assertEquals(1200 + 501, store.getById("run500")?.elapsedSeconds)
+            assertEquals(1200 + 1_500, store.getById("run1499")?.elapsedSeconds)
+            store.deleteById("run500")
+            assertNull(store.getById("run500"))
+            assertEquals(1_499, store.size())
+            store.close()
+        } finally {
+            tempDir.deleteRecursively()
+        }
+    }
+    
+    @Test
+    fun testReplaceIfUnchangedSkipsRunsEditedSinceRead() {
+        val tempDir = Files.createTempDirectory("mebeatme_test").toFile()
+        try {
+            val store = JsonRunStore(File(tempDir, "runs.json"))
+            store.upsertAll((0 until 3).map { createRunDTO("run$it", it) })
+            val read = store.getAll()
+            
+            // Edited and deleted after the read; only run0 is still as read
+            store.upsertAll(listOf(read[1].copy(notes = "Windy")))
+            store.deleteById("run2")
+            val replaced = store.replaceIfUnchanged(read.map { it to it.copy(ppi = 500.0) })
+            
+            assertEquals(1, replaced)
+            assertEquals(500.0, store.getById("run0")?.ppi)
+            assertEquals("Windy", store.getById("run1")?.notes)
+            assertNull(store.getById("run1")?.ppi)
+            assertNull(store.getById("run2"))
+            store.close()
+        } finally {
+            tempDir.deleteRecursively()
+        }
+    }
+    
+    private fun createRunDTO(id: String, n: Int): RunDTO {
+        return RunDTO(
+            id = id,
+            source = "test",
+            startedAtEpochMs = n * 60_000L,
+            endedAtEpochMs = n * 60_000L + 1_800_000L,
+            distanceMeters = 5000.0,
+            elapsedSeconds = 1200 + n,
+            avgPaceSecPerKm = 240.0
+        )
+    }
+}
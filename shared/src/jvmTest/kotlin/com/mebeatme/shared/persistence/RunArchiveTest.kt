@@ -0,0 +1,88 @@
+package com.mebeatme.shared.persistence
+
+import com.mebeatme.shared.model.RunDTO
+import java.io.File
+import java.nio.file.Files
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+class RunArchiveTest {
+    
+    @Test
+    fun testRoundTripsEveryField() {
+        val runs = listOf(
+            createRunDTO("b", 2_000L, source = "GPX"),
+            createRunDTO("a", 1_000L, source = "FIT").copy(
+                avgHr = 152,
+                ppi = 512.5,
+                notes = "hills",
+                ppiCurveVersion = "purdy-v1",
+                bestEffortsSec = mapOf("5k" to 1190),
+                maxDistanceByDurationM = listOf(42.0, 84.5)
+            ),
+            createRunDTO("c", 3_000L, source = "GPX")
+        )
+        val file = createArchiveFile()
+        RunArchive.write(file, runs)
+        
+        RunArchive.open(file).use { archive ->
+            assertEquals(3, archive.size)
+            assertEquals(runs.sortedBy { it.startedAtEpochMs }, archive.listSince(0L))
+        }
+    }
+    
+    @Test
+    fun testTimeRangeQueries() {
+        val runs = (0 until 1_000).map { createRunDTO("run$it", it * 10_000L) }
+        val file = createArchiveFile()
+        RunArchive.write(file, runs.shuffled())
+        
+        RunArchive.open(file).use { archive ->
+            assertEquals(runs.filter { it.startedAtEpochMs >= 5_000_000L }, archive.listSince(5_000_000L))
+            assertEquals(listOf("run10", "run11", "run12"), archive.listBetween(100_000L, 120_000L).map { it.id })
+            assertEquals(3, archive.countBetween(95_000L, 125_000L))
+            assertEquals(0, archive.listSince(Long.MAX_VALUE).size)
+            assertEquals(0, archive.listBetween(20L, 10L).size)
+        }
+    }
+    
+    @Test
+    fun testRejectsOtherFiles() {
+        val file = createArchiveFile().apply { writeText("[]".repeat(20)) }
+        assertFailsWith<IllegalArgumentException> { RunArchive.open(file) }
+    }
+    
+    @Test
+    fun testFooterCatchesTruncationAndDamage() {
+        val file = createArchiveFile()
+        RunArchive.write(file, (0 until 100).map { createRunDTO("run$it", it * 60_000L) })
+        RunArchive.open(file).use { assertTrue(it.verify()) }
+        
+        val bytes = file.readBytes()
+        file.writeBytes(bytes.copyOf(bytes.size - 4))
+        assertFailsWith<IllegalArgumentException> { RunArchive.open(file) }
+        
+        file.writeBytes(bytes.copyOf().also { it[bytes.size / 2] = (it[bytes.size / 2].toInt() xor 1).toByte() })
+        RunArchive.open(file).use { assertFalse(it.verify()) }
+    }
+    
+    private fun createArchiveFile(): File {
+        val tempDir = Files.createTempDirectory("mebeatme_test").toFile()
+        return File(tempDir, "runs.archive")
+    }
+    
+    private fun createRunDTO(id: String, startedAt: Long, source: String = "Manual"): RunDTO {
+        return RunDTO(
+            id = id,
+            source = source,
+            startedAtEpochMs = startedAt,
+            endedAtEpochMs = startedAt + 1_800_000L,
+            distanceMeters = 5000.0,
+            elapsedSeconds = 1800,
+            avgPaceSecPerKm = 360.0
+        )
+    }
+}
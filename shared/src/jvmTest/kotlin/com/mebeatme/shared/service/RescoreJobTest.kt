@@ -0,0 +1,139 @@
+package com.mebeatme.shared.service
+
+import com.mebeatme.shared.core.PpiScoringEngine
+import com.mebeatme.shared.core.ScoringModel
+import com.mebeatme.shared.model.RunDTO
+import com.mebeatme.shared.persistence.JsonRunStore
+import kotlinx.coroutines.test.runTest
+import java.io.File
+import java.nio.file.Files
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+class RescoreJobTest {
+    
+    @Test
+    fun testRescoreWritesPpiAndCurveVersion() = runTest {
+        val store = createStore()
+        store.upsertAll((1..50).map { createRunDTO("run${it.toString().padStart(3, '0')}", 5000.0 + it * 10, 1200 + it) })
+        
+        val report = RescoreJob(store, ScoringModel.PURDY_INTERPOLATED, chunkSize = 8, chunksPerWave = 2).run()
+        
+        assertEquals(50, report.scanned)
+        assertEquals(50, report.rescored)
+        store.getAll().forEach { run ->
+            assertEquals(ScoringModel.PURDY_INTERPOLATED.version, run.ppiCurveVersion)
+            assertEquals(
+                PpiScoringEngine.score(run.distanceMeters, run.elapsedSeconds.toDouble(), ScoringModel.PURDY_INTERPOLATED),
+                run.ppi!!,
+                1e-9
+            )
+        }
+    }
+    
+    @Test
+    fun testRescoreSkipsRunsAlreadyOnTargetVersion() = runTest {
+        val store = createStore()
+        store.upsertAll((1..10).map { createRunDTO("run$it", 5000.0, 1500) })
+        
+        RescoreJob(store, ScoringModel.PURDY_CUBIC).run()
+        val second = RescoreJob(store, ScoringModel.PURDY_CUBIC).run()
+        
+        assertEquals(0, second.scanned)
+    }
+    
+    @Test
+    fun testUnscorableRunsAreNotSelectedAgain() = runTest {
+        val store = createStore()
+        store.upsertAll(listOf(createRunDTO("valid", 5000.0, 1500), createRunDTO("empty", 0.0, 0)))
+        
+        val first = RescoreJob(store, ScoringModel.PURDY_CUBIC).run()
+        val second = RescoreJob(store, ScoringModel.PURDY_CUBIC).run()
+        
+        assertEquals(2, first.rescored)
+        assertEquals(null, store.getById("empty")?.ppi)
+        assertEquals(ScoringModel.PURDY_CUBIC.version, store.getById("empty")?.ppiCurveVersion)
+        assertEquals(0, second.scanned)
+    }
+    
+    @Test
+    fun testRescoreResumesFromCheckpoint() = runTest {
+        val store = createStore()
+        store.upsertAll((1..40).map { createRunDTO("run${it.toString().padStart(2, '0')}", 10000.0, 3000) })
+        
+        val checkpoints = mutableListOf<RescoreCheckpoint>()
+        RescoreJob(store, ScoringModel.PURDY_POINTS, chunkSize = 5, chunksPerWave = 2).run { checkpoints += it }
+        assertEquals(4, checkpoints.size)
+        
+        // Pretend the job died after the first wave and the store lost everything after it
+        val firstWave = checkpoints.first()
+        store.upsertAll(store.getAll().filter { it.id > firstWave.lastRunId!! }.map { it.copy(ppi = null, ppiCurveVersion = null) })
+        
+        val resumed = RescoreJob(store, ScoringModel.PURDY_POINTS, chunkSize = 5, chunksPerWave = 2).run(resumeFrom = firstWave)
+        assertEquals(30, resumed.scanned)
+        assertEquals(40, resumed.rescored)
+        assertTrue(store.getAll().all { it.ppiCurveVersion == ScoringModel.PURDY_POINTS.version })
+    }
+    
+    @Test
+    fun testResumePicksUpRunsAddedBelowTheCheckpoint() = runTest {
+        val store = createStore()
+        store.upsertAll((10..40).map { createRunDTO("run$it", 10000.0, 3000) })
+        
+        val checkpoints = mutableListOf<RescoreCheckpoint>()
+        RescoreJob(store, ScoringModel.PURDY_POINTS, chunkSize = 5, chunksPerWave = 2).run { checkpoints += it }
+        
+        // Sorts before every id the first pass wrote
+        store.upsertAll(listOf(createRunDTO("run00", 5000.0, 1500)))
+        val resumed = RescoreJob(store, ScoringModel.PURDY_POINTS).run(resumeFrom = checkpoints.last())
+        
+        assertEquals(1, resumed.scanned)
+        assertEquals(32, resumed.rescored)
+        assertEquals(ScoringModel.PURDY_POINTS.version, store.getById("run00")?.ppiCurveVersion)
+    }
+    
+    @Test
+    fun testEditsDuringTheJobAreNotOverwritten() = runTest {
+        val store = createStore()
+        store.upsertAll((1..20).map { createRunDTO("run${it.toString().padStart(2, '0')}", 10000.0, 3000) })
+        val waves = store.getAll().chunked(10)
+        
+        // While the first wave is written, edit runs of the second wave the job already holds copies of
+        var edited = false
+        RescoreJob(store, ScoringModel.PURDY_POINTS, chunkSize = 5, chunksPerWave = 2).run {
+            if (!edited) {
+                edited = true
+                val second = waves[1]
+                store.upsertAll(listOf(second[0].copy(notes = "Windy"), second[1].copy(elapsedSeconds = 2900)))
+                store.deleteById(second[2].id)
+            }
+        }
+        
+        val notes = store.getById(waves[1][0].id)!!
+        assertEquals("Windy", notes.notes)
+        assertEquals(ScoringModel.PURDY_POINTS.version, notes.ppiCurveVersion)
+        // Changed time: left unscored for the next pass rather than given the old time's PPI
+        assertEquals(2900, store.getById(waves[1][1].id)?.elapsedSeconds)
+        assertEquals(null, store.getById(waves[1][1].id)?.ppiCurveVersion)
+        assertEquals(null, store.getById(waves[1][2].id))
+        assertEquals(19, store.size())
+    }
+    
+    private fun createStore(): JsonRunStore {
+        val tempDir = Files.createTempDirectory("mebeatme_test").toFile()
+        return JsonRunStore(File(tempDir, "runs.json"))
+    }
+    
+    private fun createRunDTO(id: String, distanceMeters: Double, elapsedSeconds: Int): RunDTO {
+        return RunDTO(
+            id = id,
+            source = "test",
+            startedAtEpochMs = 1757300000000L,
+            endedAtEpochMs = 1757300000000L + elapsedSeconds * 1000L,
+            distanceMeters = distanceMeters,
+            elapsedSeconds = elapsedSeconds,
+            avgPaceSecPerKm = elapsedSeconds / (distanceMeters / 1000.0)
+        )
+    }
+}
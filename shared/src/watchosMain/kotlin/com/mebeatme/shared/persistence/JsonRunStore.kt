@@ -1,40 +1,94 @@
 package com.mebeatme.shared.persistence
 
+import com.mebeatme.shared.core.putDouble
+import com.mebeatme.shared.core.putInt
+import com.mebeatme.shared.model.BestsDTO
 import com.mebeatme.shared.model.RunDTO
-import com.mebeatme.shared.core.highestPpiInWindow
+import kotlinx.datetime.Clock
+import kotlinx.datetime.TimeZone
+import kotlinx.cinterop.ByteVar
+import kotlinx.cinterop.CPointer
+import kotlinx.cinterop.ExperimentalForeignApi
 import kotlinx.serialization.encodeToString
 import kotlinx.serialization.json.Json
 import kotlinx.serialization.decodeFromString
 
 /**
- * watchOS implementation of JSON-based persistence layer for MeBeatMe
- * Uses in-memory storage since watchOS doesn't have direct file access in commonMain
+ * watchOS implementation of the persistence layer for MeBeatMe
+ * Keeps recent runs in memory and older ones in a cold segment on disk (see [TieredRunTable]),
+ * so memory stays within [tierPolicy] however long the history is. When [dataFile] is a path
+ * String, writes go to the append-only run log at "<path>.log" (see [RunLogFile]), which is
+ * checkpointed into the cold segment at "<path>.cold" and restarted once it passes
+ * [TierPolicy.maxLogBytes]; opening the store reads the segment, then replays the log.
  */
-actual class JsonRunStore actual constructor(private val dataFile: Any) {
+actual class JsonRunStore actual constructor(private val dataFile: Any, timeZone: TimeZone) {
+    
+    actual constructor(dataFile: Any) : this(dataFile, TimeZone.currentSystemDefault())
     
     private val json = Json {
         prettyPrint = true
         ignoreUnknownKeys = true
     }
     
-    private val runs = mutableListOf<RunDTO>()
+    private val runs = TieredRunTable(
+        (dataFile as? String)?.let { PosixColdSegmentFile("$it.cold") } ?: MemoryColdSegmentFile()
+    ) { Clock.System.now().toEpochMilliseconds() }
+    private val indexes = RunIndexes(timeZone)
+    private val log = RunLog(RunDTO.serializer()) { it.id }
+    private val logFile = (dataFile as? String)?.let { RunLogFile("$it.log") }
+    private var logBytes = 0L
+    
+    /** Memory budget; takes effect at the next write. */
+    var tierPolicy: TierPolicy
+        get() = runs.policy
+        set(value) {
+            runs.policy = value
+        }
+    
+    init {
+        runs.load(upsert = { indexes.upsert(it) }, delete = { indexes.remove(it) }, clear = { indexes.clear() })
+        logFile?.let { file ->
+            val records = file.open()
+            logBytes = records.sumOf { RunLogCodec.RECORD_OVERHEAD + it.payload.size.toLong() }
+            log.replay(
+                records,
+                upsert = { run ->
+                    runs.upsert(run)
+                    indexes.upsert(run)
+                },
+                delete = { id ->
+                    runs.remove(id)
+                    indexes.remove(id)
+                },
+                clear = {
+                    runs.clear()
+                    indexes.clear()
+                }
+            )
+        }
+        afterWrite()
+    }
     
     actual fun upsertAll(newRuns: List<RunDTO>): Int {
+        appendToLog(newRuns.map { log.upsert(it) })
         var stored = 0
         newRuns.forEach { newRun ->
-            val existingIndex = runs.indexOfFirst { it.id == newRun.id }
-            if (existingIndex >= 0) {
-                runs[existingIndex] = newRun
-            } else {
-                runs.add(newRun)
-            }
+            runs.upsert(newRun)
+            indexes.upsert(newRun)
             stored++
         }
+        afterWrite()
         return stored
     }
     
+    // Like every write on this store, atomic for callers that keep the store on one thread
+    actual fun replaceIfUnchanged(updates: List<Pair<RunDTO, RunDTO>>): Int {
+        val unchanged = updates.filter { (read, replacement) -> read.id == replacement.id && runs[read.id] == read }
+        return if (unchanged.isEmpty()) 0 else upsertAll(unchanged.map { it.second })
+    }
+    
     actual fun listSince(sinceMs: Long): List<RunDTO> {
-        return runs.filter { it.startedAtEpochMs >= sinceMs }
+        return runs.startedSince(sinceMs)
     }
     
     actual fun getAll(): List<RunDTO> {
@@ -42,27 +96,98 @@ actual class JsonRunStore actual constructor(private val dataFile: Any) {
     }
     
     actual fun getHighestPpiLast90Days(nowMs: Long, days: Int): Double? {
-        return highestPpiInWindow(runs, nowMs, days)
+        return indexes.ppiWindows.maxPpiInWindow(nowMs, days)
+    }
+    
+    actual fun getHighestPpiInWindows(nowMs: Long, days: List<Int>): List<Double?> {
+        return indexes.ppiWindows.maxPpiInWindows(nowMs, days)
+    }
+    
+    actual fun getBests(nowMs: Long, sinceMs: Long): BestsDTO {
+        return indexes.bests.toBestsDTO(sinceMs, indexes.ppiWindows.maxPpiInWindow(nowMs, 90))
+    }
+    
+    /**
+     * [getBests] written into an MBMBests the caller owns (shared/include/mebeatme_flat.h),
+     * so a bests refresh allocates no boxed bridge objects.
+     * @param out At least FlatBests.SIZE bytes, 8-aligned
+     */
+    @OptIn(ExperimentalForeignApi::class)
+    fun writeBests(nowMs: Long, sinceMs: Long, out: CPointer<ByteVar>) {
+        indexes.writeFlatBests(nowMs, sinceMs, { at, value -> out.putInt(at, value) }, { at, value -> out.putDouble(at, value) })
+    }
+    
+    actual fun getRollups(period: RollupPeriod, fromMs: Long, toMs: Long): List<RollupRow> {
+        return indexes.rollups.rows(period, fromMs, toMs)
+    }
+    
+    actual fun getSustainedPaceSecPerKm(durationSec: Double): Double? {
+        return indexes.paceEnvelope.sustainedPaceSecPerKm(durationSec)
+    }
+    
+    actual fun getSketches(): RunSketches {
+        return indexes.sketches.copy()
     }
     
     actual fun getById(id: String): RunDTO? {
-        return runs.find { it.id == id }
+        return runs[id]
     }
     
     actual fun deleteById(id: String): Boolean {
-        val index = runs.indexOfFirst { it.id == id }
-        if (index >= 0) {
-            runs.removeAt(index)
+        if (id in runs) {
+            appendToLog(listOf(log.delete(id)))
+            runs.remove(id)
+            indexes.remove(id)
+            afterWrite()
             return true
         }
         return false
     }
     
     actual fun clear() {
+        appendToLog(listOf(log.clear()))
         runs.clear()
+        indexes.clear()
+        // Nothing before the clear is needed any more
+        logFile?.reset()
+        logBytes = 0L
+    }
+    
+    actual fun exportJson(): String {
+        return json.encodeToString(runs.toList())
+    }
+    
+    actual fun importJson(jsonString: String): Int {
+        return upsertAll(json.decodeFromString<List<RunDTO>>(jsonString))
     }
     
     actual fun size(): Int {
         return runs.size
     }
+    
+    actual fun getLogRecovery(): RunLogRecovery {
+        return logFile?.recovery ?: RunLogRecovery()
+    }
+    
+    /**
+     * Get resident and cold run counts and cold segment activity
+     */
+    fun getTierMetrics(): TierMetrics {
+        return runs.metrics()
+    }
+    
+    private fun appendToLog(records: List<RunLogRecord>) {
+        logFile?.append(records)
+        logBytes += records.sumOf { RunLogCodec.RECORD_OVERHEAD + it.payload.size.toLong() }
+    }
+    
+    // Demote what no longer fits, then fold a full run log into the cold segment and restart it
+    private fun afterWrite() {
+        runs.settle()
+        if (logFile != null && logBytes > runs.policy.maxLogBytes) {
+            runs.checkpoint()
+            logFile.reset()
+            logBytes = 0L
+        }
+    }
 }
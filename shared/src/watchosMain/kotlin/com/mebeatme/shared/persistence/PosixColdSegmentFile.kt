@@ -0,0 +1,116 @@
+package com.mebeatme.shared.persistence
+
+import kotlinx.cinterop.ExperimentalForeignApi
+import kotlinx.cinterop.addressOf
+import kotlinx.cinterop.convert
+import kotlinx.cinterop.usePinned
+import platform.posix.O_CREAT
+import platform.posix.O_RDONLY
+import platform.posix.O_RDWR
+import platform.posix.O_TRUNC
+import platform.posix.O_WRONLY
+import platform.posix.SEEK_END
+import platform.posix.fsync
+import platform.posix.ftruncate
+import platform.posix.lseek
+import platform.posix.open
+import platform.posix.pread
+import platform.posix.pwrite
+import platform.posix.rename
+import platform.posix.unlink
+
+/**
+ * The watch store's cold segment, accessed with positioned POSIX reads so a lookup
+ * touches only the bytes of its record.
+ */
+@OptIn(ExperimentalForeignApi::class)
+internal class PosixColdSegmentFile(private val path: String) : ColdSegmentFile {
+
+    private var fd: Int
+
+    override var length: Long
+        private set
+
+    init {
+        // Left behind by a rewrite interrupted before its rename; the segment itself is intact
+        unlink(tempPath())
+        fd = openFile(path, O_RDWR or O_CREAT)
+        length = lseek(fd, 0, SEEK_END)
+    }
+
+    override fun read(offset: Long, length: Int): ByteArray {
+        val out = ByteArray(length)
+        var done = 0
+        while (done < length) {
+            val read = out.usePinned { pread(fd, it.addressOf(done), (length - done).convert(), offset + done) }
+            check(read > 0) { "Cannot read cold run segment $path at ${offset + done}" }
+            done += read.toInt()
+        }
+        return out
+    }
+
+    override fun append(bytes: ByteArray) {
+        writeFully(fd, bytes, length)
+        check(fsync(fd) == 0) { "Cannot flush cold run segment $path" }
+        length += bytes.size
+    }
+
+    override fun truncate(length: Long) {
+        check(ftruncate(fd, length) == 0 && fsync(fd) == 0) { "Cannot truncate cold run segment $path" }
+        this.length = length
+    }
+
+    override fun rewrite(write: ((ByteArray) -> Unit) -> Unit) {
+        val tempPath = tempPath()
+        val temp = openFile(tempPath, O_WRONLY or O_CREAT or O_TRUNC)
+        var written = 0L
+        try {
+            write { bytes ->
+                writeFully(temp, bytes, written)
+                written += bytes.size
+            }
+            check(fsync(temp) == 0) { "Cannot flush $tempPath" }
+        } finally {
+            platform.posix.close(temp)
+        }
+        check(rename(tempPath, path) == 0) { "Cannot replace cold run segment $path" }
+        syncDirectory()
+        platform.posix.close(fd)
+        fd = openFile(path, O_RDWR)
+        length = written
+    }
+
+    override fun close() {
+        if (fd >= 0) platform.posix.close(fd)
+        fd = -1
+    }
+
+    private fun tempPath() = "$path.tmp"
+
+    private fun openFile(path: String, flags: Int): Int {
+        val opened = open(path, flags, FILE_MODE)
+        check(opened >= 0) { "Cannot open $path" }
+        return opened
+    }
+
+    private fun writeFully(target: Int, bytes: ByteArray, offset: Long) {
+        var done = 0
+        while (done < bytes.size) {
+            val written = bytes.usePinned { pwrite(target, it.addressOf(done), (bytes.size - done).convert(), offset + done) }
+            check(written > 0) { "Cannot write cold run segment $path" }
+            done += written.toInt()
+        }
+    }
+
+    // Make the rename durable; the directory entry is what changed
+    private fun syncDirectory() {
+        val directory = open(path.substringBeforeLast('/', "."), O_RDONLY)
+        if (directory < 0) return
+        fsync(directory)
+        platform.posix.close(directory)
+    }
+
+    private companion object {
+        const val FILE_MODE = 0b110_100_100 // 0644
+    }
+}
@@ -13,7 +13,12 @@ final class SharedLinkSmokeTests: XCTestCase {
             distanceMeters: 5000.0,
             elapsedSeconds: 1500,
             avgPaceSecPerKm: 300.0,
-            ppi: nil
+            avgHr: nil,
+            ppi: nil,
+            notes: nil,
+            ppiCurveVersion: nil,
+            bestEffortsSec: [:],
+            maxDistanceByDurationM: []
         )
         
         // Test PPI calculation